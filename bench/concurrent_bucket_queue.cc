@@ -0,0 +1,150 @@
+// Scaling benchmark for ConcurrentBucketQueue, not part of make check.
+// Build and run with: make bench && ./bench/concurrent_bucket_queue [dim] [maxthreads]
+//
+// Expands a dim x dim grid graph with random edge weights once with a
+// sequential Dijkstra (std::priority_queue) and then in parallel with 1 to
+// maxthreads threads, printing the time and the speedup of each run over
+// the single threaded parallel one.
+#include <vector>
+#include <queue>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <limits>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include "config.h"
+#include "baldr/concurrent_bucket_queue.h"
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// Grid graph with random edge weights. Node index is row * dim + column.
+struct grid_t {
+  uint32_t dim;
+  std::vector<float> weights;   // weight of entering each node
+  grid_t(const uint32_t d) : dim(d), weights(d * d) {
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<uint32_t> dist(1, 20);
+    for (auto& w : weights)
+      w = dist(gen);
+  }
+  template <class visitor_t>
+  void neighbors(const uint32_t n, const visitor_t& v) const {
+    uint32_t r = n / dim, c = n % dim;
+    if (c > 0) v(n - 1);
+    if (c + 1 < dim) v(n + 1);
+    if (r > 0) v(n - dim);
+    if (r + 1 < dim) v(n + dim);
+  }
+};
+
+std::vector<float> sequential(const grid_t& grid) {
+  std::vector<float> costs(grid.weights.size(), std::numeric_limits<float>::infinity());
+  using entry_t = std::pair<float, uint32_t>;
+  std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> pq;
+  costs[0] = 0.0f;
+  pq.emplace(0.0f, 0);
+  while (!pq.empty()) {
+    auto e = pq.top();
+    pq.pop();
+    if (e.first > costs[e.second])
+      continue;
+    grid.neighbors(e.second, [&](uint32_t n) {
+      float c = e.first + grid.weights[n];
+      if (c < costs[n]) {
+        costs[n] = c;
+        pq.emplace(c, n);
+      }
+    });
+  }
+  return costs;
+}
+
+std::vector<float> parallel(const grid_t& grid, const uint32_t nthreads) {
+  AtomicLabelCosts costs(grid.weights.size());
+  ConcurrentBucketQueue queue(nthreads * 2, 0, grid.dim * 40, 5, costs.labelcost());
+  std::atomic<uint32_t> pending(1);
+  costs.relax(0, 0.0f);
+  queue.add(0, 0.0f);
+
+  const auto expand = [&]() {
+    while (pending.load() > 0) {
+      uint32_t label = queue.pop();
+      if (label == kInvalidLabel) {
+        std::this_thread::yield();
+        continue;
+      }
+      float cost = costs.cost(label);
+      grid.neighbors(label, [&](uint32_t n) {
+        if (costs.relax(n, cost + grid.weights[n])) {
+          pending++;
+          queue.add(n, cost + grid.weights[n]);
+        }
+      });
+      pending--;
+    }
+  };
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < nthreads; i++)
+    threads.emplace_back(expand);
+  for (auto& t : threads)
+    t.join();
+
+  std::vector<float> result(grid.weights.size());
+  for (uint32_t i = 0; i < result.size(); i++)
+    result[i] = costs.cost(i);
+  return result;
+}
+
+// Best of a few runs in milliseconds
+template <class run_t>
+double time_ms(const run_t& run) {
+  double best = std::numeric_limits<double>::infinity();
+  for (int i = 0; i < 3; i++) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+}
+
+int main(int argc, char** argv) {
+  const uint32_t dim = argc > 1 ? std::atoi(argv[1]) : 1000;
+  uint32_t maxthreads = argc > 2 ? std::atoi(argv[2]) :
+      std::thread::hardware_concurrency();
+  if (maxthreads == 0)
+    maxthreads = 1;
+
+  grid_t grid(dim);
+  std::vector<float> expected;
+  double seq = time_ms([&]() { expected = sequential(grid); });
+  std::cout << "grid " << dim << "x" << dim << ", "
+            << std::thread::hardware_concurrency() << " hardware threads"
+            << std::endl << std::fixed << std::setprecision(2)
+            << "sequential " << seq << " ms" << std::endl;
+
+  double single = 0.0;
+  // Doubling thread counts, always ending with maxthreads
+  for (uint32_t n = 1;; n = std::min(n * 2, maxthreads)) {
+    std::vector<float> costs;
+    double t = time_ms([&]() { costs = parallel(grid, n); });
+    if (n == 1)
+      single = t;
+    std::cout << "threads " << std::setw(3) << n << "  " << t << " ms"
+              << "  speedup " << single / t << "x"
+              << "  vs sequential " << seq / t << "x"
+              << (costs == expected ? "" : "  COSTS DIFFER") << std::endl;
+    if (n == maxthreads)
+      break;
+  }
+  return 0;
+}
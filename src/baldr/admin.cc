@@ -57,5 +57,15 @@ const std::string Admin::state_iso() const {
   return str;
 }
 
+// Country ISO without a copy
+TextView Admin::country_iso_view() const {
+  return TextView::terminated(country_iso_, kCountryIso);
+}
+
+// State ISO without a copy
+TextView Admin::state_iso_view() const {
+  return TextView::terminated(state_iso_, kStateIso);
+}
+
 }
 }
@@ -0,0 +1,21 @@
+#include "baldr/checked_access.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace valhalla {
+namespace baldr {
+
+// Throws for an index outside of a tile array
+void throw_out_of_bounds(const char* what, const char* count_name,
+                         const size_t tileid, const size_t level,
+                         const size_t idx, const size_t count) {
+  throw std::runtime_error(std::string("GraphTile ") + what +
+                           " index out of bounds: " + std::to_string(tileid) +
+                           "," + std::to_string(level) + "," +
+                           std::to_string(idx) + " " + count_name + "= " +
+                           std::to_string(count));
+}
+
+}
+}
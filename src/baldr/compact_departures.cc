@@ -0,0 +1,308 @@
+#include "baldr/compact_departures.h"
+#include "baldr/sorted_lookup.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Which fields changed from the previous departure, in the control byte of
+// a single departure entry. Bit 0 set marks a frequency entry instead.
+constexpr uint8_t kFrequency   = 1;
+constexpr uint8_t kRoute       = 2;
+constexpr uint8_t kHeadsign    = 4;
+constexpr uint8_t kBlock       = 8;
+constexpr uint8_t kSchedule    = 16;
+constexpr uint8_t kElapsed     = 32;
+constexpr uint8_t kWheelchair  = 64;
+constexpr uint8_t kBicycle     = 128;
+
+void put_varint(std::string& out, uint32_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+uint32_t get_varint(const uint8_t*& in) {
+  uint32_t value = 0;
+  for (uint32_t shift = 0;; shift += 7) {
+    const uint8_t byte = *in++;
+    value |= uint32_t(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+}
+
+// Reads a varint, throwing if it runs past the end
+uint32_t get_varint(const uint8_t*& in, const uint8_t* end) {
+  uint32_t value = 0;
+  for (uint32_t shift = 0; shift < 35; shift += 7) {
+    if (in >= end)
+      throw std::runtime_error("CompactDepartures: truncated data");
+    const uint8_t byte = *in++;
+    value |= uint32_t(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+  throw std::runtime_error("CompactDepartures: invalid varint");
+}
+
+uint32_t zigzag(const int32_t value) {
+  return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+int32_t unzigzag(const uint32_t value) {
+  return int32_t(value >> 1) ^ -int32_t(value & 1);
+}
+
+using valhalla::baldr::TransitDeparture;
+
+// Are all fields other than the departure time and trip the same?
+bool same_service(const TransitDeparture& a, const TransitDeparture& b) {
+  return a.routeid() == b.routeid() && a.headsign_offset() == b.headsign_offset() &&
+         a.blockid() == b.blockid() && a.schedule_index() == b.schedule_index() &&
+         a.elapsed_time() == b.elapsed_time() &&
+         a.wheelchair_accessible() == b.wheelchair_accessible() &&
+         a.bicycle_accessible() == b.bicycle_accessible();
+}
+
+// Encodes the departures of one line
+void encode_line(std::string& out, const TransitDeparture* departures,
+                 const uint32_t count) {
+  for (uint32_t i = 0; i < count;) {
+    const TransitDeparture& d = departures[i];
+    if (i > 0) {
+      // Extend a run at the same headway and trip step as this departure
+      const uint32_t headway = d.departure_time() - departures[i - 1].departure_time();
+      const int32_t step = int32_t(d.tripid() - departures[i - 1].tripid());
+      uint32_t j = i;
+      while (j < count && same_service(departures[j], departures[i - 1]) &&
+             departures[j].departure_time() - departures[j - 1].departure_time() == headway &&
+             int32_t(departures[j].tripid() - departures[j - 1].tripid()) == step)
+        j++;
+      if (j - i >= valhalla::baldr::CompactDepartures::kMinRun) {
+        out.push_back(static_cast<char>(kFrequency));
+        put_varint(out, j - i);
+        put_varint(out, headway);
+        put_varint(out, zigzag(step));
+        i = j;
+        continue;
+      }
+    }
+
+    // A single departure with the fields that changed
+    const TransitDeparture* p = i > 0 ? &departures[i - 1] : nullptr;
+    uint8_t control = 0;
+    if (!p || d.routeid() != p->routeid())
+      control |= kRoute;
+    if (!p || d.headsign_offset() != p->headsign_offset())
+      control |= kHeadsign;
+    if (!p || d.blockid() != p->blockid())
+      control |= kBlock;
+    if (!p || d.schedule_index() != p->schedule_index())
+      control |= kSchedule;
+    if (!p || d.elapsed_time() != p->elapsed_time())
+      control |= kElapsed;
+    control |= d.wheelchair_accessible() ? kWheelchair : 0;
+    control |= d.bicycle_accessible() ? kBicycle : 0;
+    out.push_back(static_cast<char>(control));
+    put_varint(out, d.departure_time() - (p ? p->departure_time() : 0));
+    put_varint(out, zigzag(int32_t(d.tripid() - (p ? p->tripid() : 0))));
+    if (control & kRoute)
+      put_varint(out, d.routeid());
+    if (control & kHeadsign)
+      put_varint(out, d.headsign_offset());
+    if (control & kBlock)
+      put_varint(out, d.blockid());
+    if (control & kSchedule)
+      put_varint(out, d.schedule_index());
+    if (control & kElapsed)
+      put_varint(out, d.elapsed_time());
+    i++;
+  }
+}
+
+}
+
+namespace valhalla {
+namespace baldr {
+
+constexpr uint32_t CompactDepartures::kMinRun;
+
+// Get the departure with these fields
+TransitDeparture CompactDepartures::Fields::departure() const {
+  return TransitDeparture(lineid, tripid, routeid, blockid, headsign_offset,
+                          departure_time, elapsed_time, schedule_index,
+                          wheelchair_accessible, bicycle_accessible);
+}
+
+// Iterator at the first departure of a line
+CompactDepartures::Line::iterator::iterator(const uint8_t* data,
+                                            const uint32_t lineid,
+                                            const uint32_t count)
+    : data_(data), left_(count), run_left_(0), headway_(0), trip_step_(0),
+      fields_{lineid, 0, 0, 0, 0, 0, 0, 0, false, false} {
+  if (left_ > 0)
+    decode();
+}
+
+// Decodes the next departure from the previous one
+void CompactDepartures::Line::iterator::decode() {
+  if (run_left_ == 0) {
+    const uint8_t control = *data_++;
+    if (control & kFrequency) {
+      run_left_ = get_varint(data_);
+      headway_ = get_varint(data_);
+      trip_step_ = unzigzag(get_varint(data_));
+    } else {
+      fields_.departure_time += get_varint(data_);
+      fields_.tripid += unzigzag(get_varint(data_));
+      if (control & kRoute)
+        fields_.routeid = get_varint(data_);
+      if (control & kHeadsign)
+        fields_.headsign_offset = get_varint(data_);
+      if (control & kBlock)
+        fields_.blockid = get_varint(data_);
+      if (control & kSchedule)
+        fields_.schedule_index = get_varint(data_);
+      if (control & kElapsed)
+        fields_.elapsed_time = get_varint(data_);
+      fields_.wheelchair_accessible = (control & kWheelchair) != 0;
+      fields_.bicycle_accessible = (control & kBicycle) != 0;
+      return;
+    }
+  }
+  fields_.departure_time += headway_;
+  fields_.tripid += trip_step_;
+  run_left_--;
+}
+
+// Advances to the first departure at or after a time, jumping within
+// frequency entries
+void CompactDepartures::Line::iterator::seek(const uint32_t time) {
+  while (left_ > 0 && fields_.departure_time < time) {
+    if (run_left_ > 0 && headway_ > 0) {
+      const uint32_t steps = std::min(run_left_,
+          (time - fields_.departure_time + headway_ - 1) / headway_);
+      fields_.departure_time += steps * headway_;
+      fields_.tripid += int32_t(steps) * trip_step_;
+      run_left_ -= steps;
+      left_ -= steps;
+    } else {
+      ++(*this);
+    }
+  }
+}
+
+// Encodes the departures, a table of lines followed by each line's entries
+CompactDepartures::CompactDepartures(const TransitDeparture* departures,
+                                     const uint32_t count)
+    : count_(count) {
+  struct Encoded {
+    uint32_t lineid;
+    uint32_t count;
+    std::string bytes;
+  };
+  std::vector<Encoded> lines;
+  for (uint32_t begin = 0, end; begin < count; begin = end) {
+    const uint32_t lineid = departures[begin].lineid();
+    for (end = begin + 1; end < count && departures[end].lineid() == lineid; end++) {
+      if (departures[end].departure_time() < departures[end - 1].departure_time())
+        throw std::runtime_error("CompactDepartures: departures are not sorted by time");
+    }
+    if (end < count && departures[end].lineid() < lineid)
+      throw std::runtime_error("CompactDepartures: departures are not sorted by line");
+    lines.push_back({ lineid, end - begin, std::string() });
+    encode_line(lines.back().bytes, departures + begin, end - begin);
+  }
+
+  put_varint(data_, lines.size());
+  uint32_t previous = 0;
+  for (const auto& line : lines) {
+    put_varint(data_, line.lineid - previous);
+    put_varint(data_, line.count);
+    put_varint(data_, line.bytes.size());
+    previous = line.lineid;
+  }
+  for (const auto& line : lines)
+    data_.append(line.bytes);
+  load();
+}
+
+// Loads encoded departures
+CompactDepartures::CompactDepartures(std::string data)
+    : data_(std::move(data)), count_(0) {
+  load();
+}
+
+// Reads the table of lines, checking it against the size of the data
+void CompactDepartures::load() {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(data_.data());
+  const uint8_t* end = in + data_.size();
+  const uint32_t line_count = get_varint(in, end);
+  std::vector<uint32_t> sizes;
+  lines_.clear();
+  count_ = 0;
+  uint32_t lineid = 0;
+  for (uint32_t i = 0; i < line_count; i++) {
+    lineid += get_varint(in, end);
+    const uint32_t count = get_varint(in, end);
+    lines_.push_back({ lineid, 0, count });
+    sizes.push_back(get_varint(in, end));
+    count_ += count;
+  }
+
+  uint32_t offset = in - reinterpret_cast<const uint8_t*>(data_.data());
+  for (uint32_t i = 0; i < line_count; i++) {
+    lines_[i].offset = offset;
+    offset += sizes[i];
+    if (offset > data_.size())
+      throw std::runtime_error("CompactDepartures: truncated data");
+  }
+}
+
+// Get the encoded departures
+const std::string& CompactDepartures::data() const {
+  return data_;
+}
+
+// Get the number of departures
+uint32_t CompactDepartures::size() const {
+  return count_;
+}
+
+// Get the departures of a line
+CompactDepartures::Line CompactDepartures::line(const uint32_t lineid) const {
+  const uint32_t low = branchless_lower_bound(lines_.data(), lines_.size(),
+      [lineid](const LineEntry& line) { return line.lineid < lineid; });
+  if (low < lines_.size() && lines_[low].lineid == lineid) {
+    return Line(reinterpret_cast<const uint8_t*>(data_.data()) + lines_[low].offset,
+                lineid, lines_[low].count);
+  }
+  return Line(nullptr, lineid, 0);
+}
+
+// Finds the next departure on a line at or after a time
+bool CompactDepartures::next_departure(const uint32_t lineid, const uint32_t time,
+                                       const std::vector<uint64_t>& active,
+                                       const bool wheelchair, const bool bicycle,
+                                       Fields& found) const {
+  const Line departures = line(lineid);
+  auto itr = departures.begin();
+  itr.seek(time);
+  for (; itr != departures.end(); ++itr) {
+    const Fields& d = *itr;
+    if (d.schedule_index / 64 < active.size() &&
+        ((active[d.schedule_index / 64] >> (d.schedule_index % 64)) & 1) &&
+        (!wheelchair || d.wheelchair_accessible) && (!bicycle || d.bicycle_accessible)) {
+      found = d;
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+}
@@ -0,0 +1,157 @@
+#include "baldr/concurrent_bucket_queue.h"
+
+#include <limits>
+#include <random>
+#include <thread>
+
+namespace {
+
+constexpr float kInfiniteCost = std::numeric_limits<float>::infinity();
+
+// Random queue index. Each thread keeps its own generator so choosing a
+// queue does not need any synchronization.
+uint32_t random_index(const uint32_t count) {
+  thread_local std::minstd_rand generator(static_cast<uint32_t>(
+      std::hash<std::thread::id>()(std::this_thread::get_id())));
+  return generator() % count;
+}
+
+}
+
+namespace valhalla {
+namespace baldr {
+
+// Constructor given the number of labels.
+AtomicLabelCosts::AtomicLabelCosts(const uint32_t count)
+    : count_(count),
+      costs_(new std::atomic<float>[count]) {
+  for (uint32_t i = 0; i < count_; i++) {
+    costs_[i].store(kInfiniteCost, std::memory_order_relaxed);
+  }
+}
+
+// Get the number of labels.
+uint32_t AtomicLabelCosts::size() const {
+  return count_;
+}
+
+// Get the current cost of a label.
+float AtomicLabelCosts::cost(const uint32_t label) const {
+  return costs_[label].load(std::memory_order_acquire);
+}
+
+// Lowers the cost of a label if the new cost is less than the current cost.
+bool AtomicLabelCosts::relax(const uint32_t label, const float newcost) {
+  float current = costs_[label].load(std::memory_order_relaxed);
+  while (newcost < current) {
+    if (costs_[label].compare_exchange_weak(current, newcost,
+                  std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Get a cost functor suitable for constructing bucket queues.
+LabelCost AtomicLabelCosts::labelcost() const {
+  return [this](const uint32_t label) { return cost(label); };
+}
+
+ConcurrentBucketQueue::Queue::Queue(const float mincost, const float range,
+                                    const uint32_t bucketsize,
+                                    const LabelCost& labelcost)
+    : mincost(kInfiniteCost),
+      queue(mincost, range, bucketsize, labelcost) {
+}
+
+// Constructor.
+ConcurrentBucketQueue::ConcurrentBucketQueue(const uint32_t queuecount,
+          const float mincost, const float range, const uint32_t bucketsize,
+          const LabelCost& labelcost)
+    : labelcost_(labelcost) {
+  queues_.reserve(queuecount == 0 ? 1 : queuecount);
+  for (uint32_t i = 0; i < queues_.capacity(); i++) {
+    queues_.emplace_back(new Queue(mincost, range, bucketsize, labelcost));
+  }
+}
+
+// Clear all labels from all queues.
+void ConcurrentBucketQueue::clear() {
+  for (auto& q : queues_) {
+    std::lock_guard<std::mutex> lock(q->lock);
+    q->queue.clear();
+    q->mincost.store(kInfiniteCost, std::memory_order_relaxed);
+  }
+}
+
+// Adds a label index to a randomly chosen queue.
+void ConcurrentBucketQueue::add(const uint32_t label, const float cost) {
+  const uint32_t count = queues_.size();
+  while (true) {
+    Queue& q = *queues_[random_index(count)];
+    if (q.lock.try_lock()) {
+      q.queue.add(label, cost);
+      if (cost < q.mincost.load(std::memory_order_relaxed)) {
+        q.mincost.store(cost, std::memory_order_relaxed);
+      }
+      q.lock.unlock();
+      return;
+    }
+  }
+}
+
+// Removes a low cost label index.
+uint32_t ConcurrentBucketQueue::pop() {
+  // Try the lower cost of two random queues a few times
+  const uint32_t count = queues_.size();
+  for (uint32_t attempt = 0; attempt < count; attempt++) {
+    Queue& q1 = *queues_[random_index(count)];
+    Queue& q2 = *queues_[random_index(count)];
+    float c1 = q1.mincost.load(std::memory_order_relaxed);
+    float c2 = q2.mincost.load(std::memory_order_relaxed);
+    if (c1 == kInfiniteCost && c2 == kInfiniteCost) {
+      continue;
+    }
+    uint32_t label = pop(c1 <= c2 ? q1 : q2, false);
+    if (label != kInvalidLabel) {
+      return label;
+    }
+  }
+
+  // Either the queues are nearly empty or heavily contended. Check each
+  // queue in turn before reporting that there is nothing to pop.
+  for (auto& q : queues_) {
+    if (q->mincost.load(std::memory_order_relaxed) != kInfiniteCost) {
+      uint32_t label = pop(*q, true);
+      if (label != kInvalidLabel) {
+        return label;
+      }
+    }
+  }
+  return kInvalidLabel;
+}
+
+// Get the number of queues.
+uint32_t ConcurrentBucketQueue::queuecount() const {
+  return queues_.size();
+}
+
+// Pops from the specified queue if its lock can be acquired.
+uint32_t ConcurrentBucketQueue::pop(Queue& q, const bool block) {
+  if (block) {
+    q.lock.lock();
+  } else if (!q.lock.try_lock()) {
+    return kInvalidLabel;
+  }
+
+  // Labels come out of a queue in (bucketed) cost order so the cost of the
+  // popped label is a lower bound for the labels left in it
+  uint32_t label = q.queue.pop();
+  q.mincost.store((label == kInvalidLabel) ? kInfiniteCost : labelcost_(label),
+                  std::memory_order_relaxed);
+  q.lock.unlock();
+  return label;
+}
+
+}
+}
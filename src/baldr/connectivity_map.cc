@@ -4,7 +4,11 @@
 #include "baldr/graphreader.h"
 
 #include <valhalla/midgard/pointll.h>
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/constants.h>
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cmath>
 #include <list>
 #include <iomanip>
 #include <random>
@@ -250,16 +254,22 @@ namespace valhalla {
         return result;
       const auto& tiles = tile_hierarchy.levels().find(hierarchy_level)->second.tiles;
       for(const auto& edge : location.edges) {
-        //TODO: generate more ids by intersecting this circle with the tiles object
-        //take the edge.projected and subtract radius in the x and y dimensions
-        //convert that into a tileid and get its col,row tile coords that will start the for loop
-        //add radius in the x and y to edge.projected to get the ending tile col,row for the for loop
-        //then while iterating create a tile for each tile col,row pair, get its aabb2 and call
-        //aabb2::intersects(edge.projected, radius), if it returns true, get the color as below
-        auto id = tiles.TileId(edge.projected);
-        auto color = level->second.find(id);
-        if(color != level->second.cend())
-          result.emplace(color->second);
+        //get the tiles in the bounding box of the circle
+        const auto& c = edge.projected;
+        float mx = kMetersPerDegreeLat * std::max(std::cos(c.lat() * kRadPerDeg), 0.0001f);
+        float dlng = radius / mx, dlat = radius / kMetersPerDegreeLat;
+        AABB2<PointLL> bbox(c.lng() - dlng, c.lat() - dlat, c.lng() + dlng, c.lat() + dlat);
+        for(const auto& id : tile_hierarchy.GetGraphIds(bbox, hierarchy_level)) {
+          //skip the corner tiles that dont actually reach the circle
+          auto box = tiles.TileBounds(id.tileid());
+          float dx = std::max(std::max(box.minx() - c.lng(), c.lng() - box.maxx()), 0.f) * mx;
+          float dy = std::max(std::max(box.miny() - c.lat(), c.lat() - box.maxy()), 0.f) * kMetersPerDegreeLat;
+          if(dx * dx + dy * dy > radius * radius)
+            continue;
+          auto color = level->second.find(id.tileid());
+          if(color != level->second.cend())
+            result.emplace(color->second);
+        }
       }
       return result;
     }
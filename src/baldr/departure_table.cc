@@ -0,0 +1,213 @@
+#include "baldr/departure_table.h"
+#include "baldr/sorted_lookup.h"
+
+#include <algorithm>
+
+namespace {
+
+// Index of the lowest set bit of a non-zero word
+inline uint32_t lowest_bit(const uint64_t word) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(word);
+#else
+  uint32_t i = 0;
+  while (!((word >> i) & 1))
+    ++i;
+  return i;
+#endif
+}
+
+}
+
+namespace valhalla {
+namespace baldr {
+
+// Constructor. Copies the departure times and flags into columns.
+DepartureTable::DepartureTable(const TransitDeparture* departures,
+                               const uint32_t count,
+                               const TransitSchedule* schedules,
+                               const uint32_t schedule_count)
+    : departures_(departures), schedules_(schedules),
+      schedule_count_(schedule_count), times_(count),
+      wheelchair_((count + 63) / 64, 0), bicycle_((count + 63) / 64, 0) {
+  for (uint32_t i = 0; i < count; i++) {
+    times_[i] = departures[i].departure_time();
+    wheelchair_[i / 64] |= uint64_t(departures[i].wheelchair_accessible()) << (i % 64);
+    bicycle_[i / 64] |= uint64_t(departures[i].bicycle_accessible()) << (i % 64);
+
+    // Add the departure's schedule to the days its line may run
+    ActiveDays& active = active_days_.emplace(departures[i].lineid(),
+                                              ActiveDays{0, 0}).first->second;
+    if (departures[i].schedule_index() < schedule_count) {
+      const TransitSchedule& schedule = schedules[departures[i].schedule_index()];
+      active.days |= schedule.days();
+      active.dow |= schedule.days_of_week();
+    }
+  }
+}
+
+// Get the number of departures
+uint32_t DepartureTable::size() const {
+  return times_.size();
+}
+
+// Get the days on which departures of a line may run
+ActiveDays DepartureTable::active_days(const uint32_t lineid) const {
+  auto found = active_days_.find(lineid);
+  return found == active_days_.end() ? ActiveDays{0, 0} : found->second;
+}
+
+// Finds the first departure of a range at or after a time
+uint32_t DepartureTable::lower_bound(const uint32_t begin, const uint32_t end,
+                                     const uint32_t time) const {
+  return begin + branchless_lower_bound(times_.data() + begin, end - begin,
+                   [time](const uint32_t t) { return t < time; });
+}
+
+// Finds the first departure of a range after a time
+uint32_t DepartureTable::upper_bound(const uint32_t begin, const uint32_t end,
+                                     const uint32_t time) const {
+  return begin + branchless_lower_bound(times_.data() + begin, end - begin,
+                   [time](const uint32_t t) { return t <= time; });
+}
+
+// Get the bitmap of a day from a cache, computing it if it is not there
+template <class compute_t>
+std::shared_ptr<const DepartureTable::bitmap_t> DepartureTable::cached(
+    day_cache_t& cache, const day_t& day, const compute_t& compute) const {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto itr = cache.begin(); itr != cache.end(); ++itr) {
+      if (itr->first == day) {
+        cache.splice(cache.begin(), cache, itr);
+        return cache.front().second;
+      }
+    }
+  }
+
+  // Compute outside of the lock. Two threads may both compute a new day,
+  // which only costs the work of one of them.
+  std::shared_ptr<const bitmap_t> bitmap = compute();
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache.emplace_front(day, bitmap);
+  if (cache.size() > kCachedDays)
+    cache.pop_back();
+  return bitmap;
+}
+
+// Get the bitset of the schedules valid on a day, computing it on first use
+std::shared_ptr<const DepartureTable::bitmap_t> DepartureTable::active_schedules(
+    const uint32_t day, const uint32_t dow, const bool date_before_tile) const {
+  return cached(schedule_days_, day_t(day, dow, date_before_tile), [&]() {
+    auto active = std::make_shared<bitmap_t>((schedule_count_ + 63) / 64, 0);
+    for (uint32_t i = 0; i < schedule_count_; i++) {
+      if (schedules_[i].IsValid(day, dow, date_before_tile))
+        (*active)[i / 64] |= uint64_t(1) << (i % 64);
+    }
+    return active;
+  });
+}
+
+// Get the validity bitmap of a day, computing it on first use
+std::shared_ptr<const DepartureTable::bitmap_t> DepartureTable::valid_on(
+    const uint32_t day, const uint32_t dow, const bool date_before_tile) const {
+  return cached(days_, day_t(day, dow, date_before_tile), [&]() {
+    // Mark the departures whose schedule is active
+    auto active = active_schedules(day, dow, date_before_tile);
+    auto valid = std::make_shared<bitmap_t>(wheelchair_.size(), 0);
+    for (uint32_t i = 0; i < times_.size(); i++) {
+      const uint32_t schedule = departures_[i].schedule_index();
+      if (schedule < schedule_count_ && test(*active, schedule))
+        (*valid)[i / 64] |= uint64_t(1) << (i % 64);
+    }
+    return valid;
+  });
+}
+
+// Finds the first valid departure of a range, 64 departures at a time
+uint32_t DepartureTable::next_valid(const uint32_t begin, const uint32_t end,
+                                    const bitmap_t& valid, const bool wheelchair,
+                                    const bool bicycle) const {
+  if (begin >= end)
+    return end;
+  const uint64_t any = ~uint64_t(0);
+  for (uint32_t word = begin / 64; word * 64 < end; ++word) {
+    uint64_t bits = valid[word] & (wheelchair ? wheelchair_[word] : any) &
+                    (bicycle ? bicycle_[word] : any);
+    if (word == begin / 64)
+      bits &= any << (begin % 64);
+    if (bits != 0) {
+      const uint32_t found = word * 64 + lowest_bit(bits);
+      return found < end ? found : end;
+    }
+  }
+  return end;
+}
+
+// Finds the first valid departure of a range, one schedule at a time
+uint32_t DepartureTable::next_valid_on(const uint32_t begin, const uint32_t end,
+                                       const uint32_t day, const uint32_t dow,
+                                       const bool date_before_tile,
+                                       const bool wheelchair,
+                                       const bool bicycle) const {
+  for (uint32_t i = begin; i < end; i++) {
+    if ((wheelchair && !test(wheelchair_, i)) || (bicycle && !test(bicycle_, i)))
+      continue;
+    const uint32_t schedule = departures_[i].schedule_index();
+    if (schedule < schedule_count_ &&
+        schedules_[schedule].IsValid(day, dow, date_before_tile))
+      return i;
+  }
+  return end;
+}
+
+// Get the departure indexes in time order, sorting them on first use
+const std::vector<uint32_t>& DepartureTable::by_time() const {
+  std::call_once(by_time_once_, [this]() {
+    by_time_.resize(times_.size());
+    for (uint32_t i = 0; i < by_time_.size(); i++)
+      by_time_[i] = i;
+    std::stable_sort(by_time_.begin(), by_time_.end(),
+        [this](const uint32_t a, const uint32_t b) { return times_[a] < times_[b]; });
+  });
+  return by_time_;
+}
+
+// Finds the departures in a time window within the time sorted order
+std::pair<uint32_t, uint32_t> DepartureTable::by_time_range(const uint32_t start,
+                                                            const uint32_t end) const {
+  const std::vector<uint32_t>& order = by_time();
+  auto first = branchless_lower_bound(order.data(), order.size(),
+      [this, start](const uint32_t i) { return times_[i] < start; });
+  auto last = branchless_lower_bound(order.data(), order.size(),
+      [this, end](const uint32_t i) { return times_[i] <= end; });
+  return std::make_pair(first, std::max(first, last));
+}
+
+// Constructor. Finds the window within the time sorted departures.
+DeparturesByTime::DeparturesByTime(const DepartureTable& table,
+                                   const uint32_t start, const uint32_t end,
+                                   std::shared_ptr<const DepartureTable::bitmap_t> valid,
+                                   const bool wheelchair, const bool bicycle)
+    : table_(&table), end_(nullptr), valid_(std::move(valid)),
+      wheelchair_(wheelchair), bicycle_(bicycle), begin_(nullptr) {
+  auto range = table.by_time_range(start, end);
+  end_ = table.by_time().data() + range.second;
+  begin_ = next(table.by_time().data() + range.first);
+}
+
+// Skips the departures that do not run or lack the requested accessibility
+const uint32_t* DeparturesByTime::next(const uint32_t* pos) const {
+  for (; pos < end_; ++pos) {
+    const uint32_t i = *pos;
+    const TransitDeparture& departure = table_->departure(i);
+    if ((!valid_ || DepartureTable::test(*valid_, i)) &&
+        (!wheelchair_ || departure.wheelchair_accessible()) &&
+        (!bicycle_ || departure.bicycle_accessible()))
+      break;
+  }
+  return pos;
+}
+
+}
+}
@@ -78,40 +78,59 @@ void DoubleBucketQueue::decrease(const uint32_t label, const float newcost,
 
 // Remove the label with the lowest cost
 uint32_t DoubleBucketQueue::pop() {
-  const auto nextlabel = [this]() {
-    uint32_t label = currentbucket_->front();
-    currentbucket_->pop_front();
-    return label;
-  };
+  if (!find_nonempty_bucket()) {
+    return kInvalidLabel;
+  }
+  uint32_t label = currentbucket_->front();
+  currentbucket_->pop_front();
+  return label;
+}
 
-  // Return a label from lowest non-empty bucket.
+// Remove all labels within the lowest cost bucket
+uint32_t DoubleBucketQueue::pop_bucket(std::vector<uint32_t>& labels) {
+  labels.clear();
+  if (!find_nonempty_bucket()) {
+    return 0;
+  }
+  labels.assign(currentbucket_->begin(), currentbucket_->end());
+  currentbucket_->clear();
+  return labels.size();
+}
+
+// Gets the lowest cost of the current bucket.
+float DoubleBucketQueue::current_cost() const {
+  return currentcost_;
+}
+
+// Advance to the lowest non-empty bucket.
+bool DoubleBucketQueue::find_nonempty_bucket() {
+  // Find the lowest non-empty bucket.
   for ( ; currentbucket_ != buckets_.end(); currentbucket_++,
           currentcost_ += bucketsize_) {
     if (!currentbucket_->empty()) {
-      return nextlabel();
+      return true;
     }
   }
 
-  // No labels found in the low-level buckets. Return an invalid label if no
+  // No labels found in the low-level buckets. Return false if no
   // labels are in the overflow buckets
   if (overflowbucket_.empty()) {
     // Reset currentbucket to the last bucket - in case another access of
     // adjacency list is done
     currentbucket_--;
-    return kInvalidLabel;
+    return false;
   }
 
   // Move labels from the overflow bucket to the low level buckets. Then find
-  // smallest bucket that is not empty and set it as the currentbucket and
-  // return its first label.
+  // smallest bucket that is not empty and set it as the currentbucket.
   empty_overflow();
   for (currentbucket_ = buckets_.begin(); currentbucket_ != buckets_.end();
            currentbucket_++, currentcost_ += bucketsize_) {
     if (!currentbucket_->empty()) {
-      return nextlabel();
+      return true;
     }
   }
-  return kInvalidLabel;
+  return false;
 }
 
 // Returns the bucket given the cost
@@ -141,10 +160,14 @@ void DoubleBucketQueue::empty_overflow() {
       uint32_t label = overflowbucket_.front();
       overflowbucket_.pop_front();
 
-      // Get the cost (using the label cost function)
+      // Get the cost (using the label cost function). The cost may have
+      // been lowered below the new range since the label was added (e.g. a
+      // stale entry left by re-adding an improved label), so keep it from
+      // underflowing the first bucket.
       float cost = labelcost_(label);
       if (cost < maxcost_) {
-        buckets_[static_cast<uint32_t>((cost-mincost_)*inv_)].push_back(label);
+        buckets_[(cost < mincost_) ? 0 :
+            static_cast<uint32_t>((cost-mincost_)*inv_)].push_back(label);
         found = true;
       } else {
         tmp.push_back(label);
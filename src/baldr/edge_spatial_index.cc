@@ -0,0 +1,311 @@
+#include "baldr/edge_spatial_index.h"
+#include "baldr/graphtile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <valhalla/midgard/constants.h>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// Position of a point along a 16 bit Hilbert curve. From "Fast Hilbert
+// curve generation, sorting, and range queries" (rawrunprotected).
+uint32_t hilbert(uint32_t x, uint32_t y) {
+  uint32_t a = x ^ y;
+  uint32_t b = 0xFFFF ^ a;
+  uint32_t c = 0xFFFF ^ (x | y);
+  uint32_t d = x & (y ^ 0xFFFF);
+
+  uint32_t A = a | (b >> 1);
+  uint32_t B = (a >> 1) ^ a;
+  uint32_t C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+  uint32_t D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+  a = A; b = B; c = C; d = D;
+  A = ((a & (a >> 2)) ^ (b & (b >> 2)));
+  B = ((a & (b >> 2)) ^ (b & ((a ^ b) >> 2)));
+  C ^= ((a & (c >> 2)) ^ (b & (d >> 2)));
+  D ^= ((b & (c >> 2)) ^ ((a ^ b) & (d >> 2)));
+
+  a = A; b = B; c = C; d = D;
+  A = ((a & (a >> 4)) ^ (b & (b >> 4)));
+  B = ((a & (b >> 4)) ^ (b & ((a ^ b) >> 4)));
+  C ^= ((a & (c >> 4)) ^ (b & (d >> 4)));
+  D ^= ((b & (c >> 4)) ^ ((a ^ b) & (d >> 4)));
+
+  a = A; b = B; c = C; d = D;
+  C ^= ((a & (c >> 8)) ^ (b & (d >> 8)));
+  D ^= ((b & (c >> 8)) ^ ((a ^ b) & (d >> 8)));
+
+  a = C ^ (C >> 1);
+  b = D ^ (D >> 1);
+
+  uint32_t i0 = x ^ y;
+  uint32_t i1 = b | (0xFFFF ^ (i0 | a));
+
+  i0 = (i0 | (i0 << 8)) & 0x00FF00FF;
+  i0 = (i0 | (i0 << 4)) & 0x0F0F0F0F;
+  i0 = (i0 | (i0 << 2)) & 0x33333333;
+  i0 = (i0 | (i0 << 1)) & 0x55555555;
+
+  i1 = (i1 | (i1 << 8)) & 0x00FF00FF;
+  i1 = (i1 | (i1 << 4)) & 0x0F0F0F0F;
+  i1 = (i1 | (i1 << 2)) & 0x33333333;
+  i1 = (i1 | (i1 << 1)) & 0x55555555;
+
+  return (i1 << 1) | i0;
+}
+
+// An entry in the search queue. Boxes are keyed by the distance to their
+// bounding box, which is a lower bound for anything inside. Resolved
+// segments are keyed by their exact distance.
+struct queue_entry_t {
+  float dist_sq;
+  uint32_t pos;
+  bool resolved;
+  PointLL projected;
+  bool operator>(const queue_entry_t& other) const {
+    return dist_sq > other.dist_sq;
+  }
+};
+
+}
+
+namespace valhalla {
+namespace baldr {
+
+constexpr uint32_t EdgeSpatialIndex::kNodeSize;
+
+// Constructor. Decodes the shape of each edge within the tile and builds
+// the index.
+EdgeSpatialIndex::EdgeSpatialIndex(const GraphTile& tile) {
+  // Find one directed edge per edge info (shape), preferring the one whose
+  // shape is stored in its direction of travel
+  std::vector<std::pair<GraphId, uint64_t>> edges;
+  std::unordered_map<uint64_t, size_t> offsets;
+  GraphId edgeid = tile.id();
+  for (const auto& edge : tile.GetDirectedEdges()) {
+    if (!edge.is_shortcut() && !edge.IsTransitLine()) {
+      auto inserted = offsets.emplace(edge.edgeinfo_offset(), edges.size());
+      if (inserted.second) {
+        edges.emplace_back(edgeid, edge.edgeinfo_offset());
+      } else if (edge.forward()) {
+        edges[inserted.first->second].first = edgeid;
+      }
+    }
+    edgeid++;
+  }
+
+  // Decode each shape (reusing one buffer) and build the tree
+  std::vector<PointLL> shape;
+  for (const auto& edge : edges) {
+    tile.edgeinfo_ref(edge.second).decode_shape(shape);
+    add(edge.first, shape);
+  }
+  build();
+}
+
+// Constructor given a list of edge shapes.
+EdgeSpatialIndex::EdgeSpatialIndex(
+    const std::vector<std::pair<GraphId, std::vector<PointLL>>>& shapes) {
+  for (const auto& shape : shapes) {
+    add(shape.first, shape.second);
+  }
+  build();
+}
+
+// Get the number of indexed segments.
+size_t EdgeSpatialIndex::size() const {
+  return segment_edges_.size();
+}
+
+// Adds an edge shape to the list of edges to index.
+void EdgeSpatialIndex::add(const GraphId& edgeid,
+                           const std::vector<PointLL>& shape) {
+  if (shape.size() < 2) {
+    return;
+  }
+  edges_.push_back(edgeid);
+  edge_points_.push_back(points_.size());
+  points_.insert(points_.end(), shape.begin(), shape.end());
+}
+
+// Builds the R-tree once all edges have been added.
+void EdgeSpatialIndex::build() {
+  edge_points_.push_back(points_.size());
+
+  // Create a leaf box per segment
+  Box extent{ std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+              std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+  for (uint32_t e = 0; e < edges_.size(); e++) {
+    for (uint32_t i = edge_points_[e]; i + 1 < edge_points_[e + 1]; i++) {
+      const PointLL& a = points_[i];
+      const PointLL& b = points_[i + 1];
+      Box box{ std::min(a.lng(), b.lng()), std::min(a.lat(), b.lat()),
+               std::max(a.lng(), b.lng()), std::max(a.lat(), b.lat()) };
+      extent.minx = std::min(extent.minx, box.minx);
+      extent.miny = std::min(extent.miny, box.miny);
+      extent.maxx = std::max(extent.maxx, box.maxx);
+      extent.maxy = std::max(extent.maxy, box.maxy);
+      boxes_.push_back(box);
+      indices_.push_back(i);
+      segment_edges_.push_back(e);
+    }
+  }
+  const uint32_t n = boxes_.size();
+  if (n == 0) {
+    return;
+  }
+
+  // Sort the leaves along a Hilbert curve through the extent
+  float width = extent.maxx - extent.minx;
+  float height = extent.maxy - extent.miny;
+  float sx = (width > 0.0f) ? 65535.0f / width : 0.0f;
+  float sy = (height > 0.0f) ? 65535.0f / height : 0.0f;
+  std::vector<uint32_t> values(n);
+  for (uint32_t i = 0; i < n; i++) {
+    const Box& b = boxes_[i];
+    values[i] = hilbert(
+        static_cast<uint32_t>(((b.minx + b.maxx) * 0.5f - extent.minx) * sx),
+        static_cast<uint32_t>(((b.miny + b.maxy) * 0.5f - extent.miny) * sy));
+  }
+  std::vector<uint32_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&values](uint32_t a, uint32_t b) {
+    return values[a] < values[b];
+  });
+  std::vector<Box> boxes(n);
+  std::vector<uint32_t> indices(n);
+  std::vector<uint32_t> segment_edges(n);
+  for (uint32_t i = 0; i < n; i++) {
+    boxes[i] = boxes_[order[i]];
+    indices[i] = indices_[order[i]];
+    segment_edges[i] = segment_edges_[order[i]];
+  }
+  boxes_.swap(boxes);
+  indices_.swap(indices);
+  segment_edges_.swap(segment_edges);
+
+  // Pack each level into parent nodes until a single root remains
+  level_bounds_.push_back(n);
+  uint32_t start = 0;
+  uint32_t end = n;
+  while (end - start > 1) {
+    for (uint32_t i = start; i < end; i += kNodeSize) {
+      Box node = boxes_[i];
+      uint32_t last = std::min(i + kNodeSize, end);
+      for (uint32_t j = i + 1; j < last; j++) {
+        node.minx = std::min(node.minx, boxes_[j].minx);
+        node.miny = std::min(node.miny, boxes_[j].miny);
+        node.maxx = std::max(node.maxx, boxes_[j].maxx);
+        node.maxy = std::max(node.maxy, boxes_[j].maxy);
+      }
+      boxes_.push_back(node);
+      indices_.push_back(i);
+    }
+    start = end;
+    end = boxes_.size();
+    level_bounds_.push_back(end);
+  }
+}
+
+// Visits segments in increasing distance from a point.
+void EdgeSpatialIndex::Visit(const PointLL& pt, const float max_distance,
+                             const visitor_t& visitor) const {
+  if (boxes_.empty()) {
+    return;
+  }
+
+  // Measure in meters using a local equirectangular approximation
+  const float mx = kMetersPerDegreeLat * std::cos(pt.lat() * kRadPerDeg);
+  const float my = kMetersPerDegreeLat;
+  const float max_dist_sq = max_distance * max_distance;
+  const auto box_dist_sq = [&pt, mx, my](const Box& b) {
+    float dx = std::max(std::max(b.minx - pt.lng(), pt.lng() - b.maxx), 0.0f) * mx;
+    float dy = std::max(std::max(b.miny - pt.lat(), pt.lat() - b.maxy), 0.0f) * my;
+    return dx * dx + dy * dy;
+  };
+
+  std::priority_queue<queue_entry_t, std::vector<queue_entry_t>,
+                      std::greater<queue_entry_t>> queue;
+  uint32_t root = boxes_.size() - 1;
+  queue.push({ box_dist_sq(boxes_[root]), root, false, {} });
+  const uint32_t leaves = level_bounds_.front();
+  while (!queue.empty()) {
+    queue_entry_t entry = queue.top();
+    queue.pop();
+    if (entry.dist_sq > max_dist_sq) {
+      break;
+    }
+
+    // Exact distance to a segment, nothing left in the queue is closer
+    if (entry.resolved) {
+      uint32_t e = segment_edges_[entry.pos];
+      Candidate candidate{ edges_[e], indices_[entry.pos] - edge_points_[e],
+                           std::sqrt(entry.dist_sq), entry.projected };
+      if (!visitor(candidate)) {
+        return;
+      }
+      continue;
+    }
+
+    // Segment, project the point onto it and queue it by exact distance
+    if (entry.pos < leaves) {
+      const PointLL& a = points_[indices_[entry.pos]];
+      const PointLL& b = points_[indices_[entry.pos] + 1];
+      float ax = (a.lng() - pt.lng()) * mx;
+      float ay = (a.lat() - pt.lat()) * my;
+      float bx = (b.lng() - pt.lng()) * mx;
+      float by = (b.lat() - pt.lat()) * my;
+      float dx = bx - ax;
+      float dy = by - ay;
+      float len_sq = dx * dx + dy * dy;
+      float t = (len_sq > 0.0f) ? -(ax * dx + ay * dy) / len_sq : 0.0f;
+      t = std::min(std::max(t, 0.0f), 1.0f);
+      float px = ax + t * dx;
+      float py = ay + t * dy;
+      queue.push({ px * px + py * py, entry.pos, true,
+                   PointLL(a.lng() + t * (b.lng() - a.lng()),
+                           a.lat() + t * (b.lat() - a.lat())) });
+      continue;
+    }
+
+    // Node, queue its children. They are in the level below this one.
+    auto level = std::upper_bound(level_bounds_.begin(), level_bounds_.end(),
+                                  entry.pos);
+    uint32_t first = indices_[entry.pos];
+    uint32_t last = std::min(first + kNodeSize, *(level - 1));
+    for (uint32_t i = first; i < last; i++) {
+      float d = box_dist_sq(boxes_[i]);
+      if (d <= max_dist_sq) {
+        queue.push({ d, i, false, {} });
+      }
+    }
+  }
+}
+
+// Get the closest edges to a point.
+std::vector<EdgeSpatialIndex::Candidate> EdgeSpatialIndex::Nearest(
+    const PointLL& pt, const size_t count, const float max_distance) const {
+  std::vector<Candidate> candidates;
+  if (count == 0) {
+    return candidates;
+  }
+  std::unordered_set<GraphId> seen;
+  Visit(pt, max_distance, [&candidates, &seen, count](const Candidate& c) {
+    if (seen.insert(c.edgeid).second) {
+      candidates.push_back(c);
+    }
+    return candidates.size() < count;
+  });
+  return candidates;
+}
+
+}
+}
@@ -1,6 +1,7 @@
 #include "baldr/edgeinfo.h"
 
 #include <valhalla/midgard/encoded.h>
+#include "baldr/graphtile.h"
 
 using namespace valhalla::baldr;
 
@@ -18,84 +19,70 @@ json::ArrayPtr names_json(const std::vector<std::string>& names) {
 namespace valhalla {
 namespace baldr {
 
-EdgeInfo::EdgeInfo(char* ptr, const char* names_list,
-                   const size_t names_list_length)
-  : names_list_(names_list), names_list_length_(names_list_length) {
-
-  wayid_ = *(reinterpret_cast<uint64_t*>(ptr));
-  ptr += sizeof(uint64_t);
-
-  item_ = reinterpret_cast<PackedItem*>(ptr);
-  ptr += sizeof(PackedItem);
-
-  // Set street_name_offset_list_ pointer
-  street_name_offset_list_ = reinterpret_cast<uint32_t*>(ptr);
-  ptr += (name_count() * sizeof(uint32_t));
+static_assert(sizeof(EdgeInfoRef) == 3 * sizeof(void*),
+              "EdgeInfoRef should be no more than two pointers and a size");
 
-  // Set encoded_shape_ pointer
-  encoded_shape_ = ptr;
-  ptr += (encoded_shape_size() * sizeof(char));
-}
-
-EdgeInfo::~EdgeInfo() {
-  //nothing to delete these are all shallow pointers for the moment held
-  //by another object
+// Get the name offset for the specified name index
+uint32_t EdgeInfoRef::GetStreetNameOffset(uint8_t index) const {
+  if(index < name_count())
+    return name_offsets()[index];
+  else
+    throw std::runtime_error("StreetNameOffset index was out of bounds");
 }
 
-// Gets the OSM way Id.
-uint64_t EdgeInfo::wayid() const {
-  return wayid_;
+// Get the names without copying them
+NameViews EdgeInfoRef::GetNameViews() const {
+  return NameViews(name_offsets(), name_count(), names_list_, names_list_length_);
 }
 
-// Get the number of names.
-uint32_t EdgeInfo::name_count() const {
-  return item_->name_count;
+EdgeInfo::EdgeInfo(char* ptr, const char* names_list,
+                   const size_t names_list_length)
+  : ref_(ptr, names_list, names_list_length) {
 }
 
-// Get the size of the encoded shape (number of bytes).
-uint32_t EdgeInfo::encoded_shape_size() const {
-  return item_->encoded_shape_size;
+EdgeInfo::EdgeInfo(const EdgeInfoRef& ref)
+  : ref_(ref) {
 }
 
 uint32_t EdgeInfo::GetStreetNameOffset(uint8_t index) const {
-  if(index < item_->name_count)
-    return street_name_offset_list_[index];
-  else
-    throw std::runtime_error("StreetNameOffset index was out of bounds");
+  return ref_.GetStreetNameOffset(index);
 }
 
 // Get a list of names
 std::vector<std::string> EdgeInfo::GetNames() const {
   // Get each name
   std::vector<std::string> names; names.reserve(name_count());
-  for (uint32_t i = 0; i < name_count(); i++) {
-    uint32_t offset = GetStreetNameOffset(i);
-
-    if (offset < names_list_length_) {
-      names.push_back(names_list_ + offset);
-    } else {
-      throw std::runtime_error("GetNames: offset exceeds size of text list");
-    }
-  }
+  for (const auto& name : GetNameViews())
+    names.emplace_back(name.data(), name.size());
   return names;
 }
 
+// Get the names without copying them
+NameViews EdgeInfo::GetNameViews() const {
+  return ref_.GetNameViews();
+}
+
 // Returns shape as a vector of PointLL
 const std::vector<PointLL>& EdgeInfo::shape() const {
   //if we haven't yet decoded the shape, do so
-  if(encoded_shape_ != nullptr && shape_.empty())
-    shape_ = midgard::decode7<std::vector<PointLL> >(encoded_shape_, item_->encoded_shape_size);
+  if(shape_.empty())
+    ref_.decode_shape(shape_);
   return shape_;
 }
 
+// Decode the shape into a caller provided buffer
+void EdgeInfo::decode_shape(std::vector<PointLL>& shape) const {
+  ref_.decode_shape(shape);
+}
+
 // Returns the encoded shape string
 std::string EdgeInfo::encoded_shape() const {
-  return encoded_shape_ == nullptr ? midgard::encode7(shape_) : std::string(encoded_shape_, item_->encoded_shape_size);
+  return std::string(encoded_shape_data(), encoded_shape_size());
 }
 
 json::MapPtr EdgeInfo::json() const {
   return json::map({
-    {"way_id", static_cast<uint64_t>(wayid_)},
+    {"way_id", static_cast<uint64_t>(wayid())},
     {"names", names_json(GetNames())},
     {"shape", midgard::encode(shape())},
   });
@@ -0,0 +1,194 @@
+#include "baldr/edgeshape.h"
+
+#include <cstring>
+#include <stdexcept>
+
+// The word at a time decoder needs the bytes of a load in memory order and
+// a count of trailing zeros. Elsewhere every varint is decoded a byte at a
+// time.
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define VARINT_WORD_DECODE 1
+#endif
+
+#if defined(VARINT_WORD_DECODE) && defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+using namespace valhalla::midgard;
+
+namespace {
+
+constexpr double kPrecision = 1e-6;
+constexpr uint64_t kContinuationBits = 0x8080808080808080ULL;
+
+// Slow path, one byte at a time. Used near the end of the buffer where an 8
+// byte load would read past it.
+inline uint32_t varint_scalar(const char*& begin, const char* end) {
+  uint32_t byte, shift = 0, result = 0;
+  do {
+    if (begin == end)
+      throw std::runtime_error("Bad encoded polyline");
+    byte = static_cast<uint8_t>(*begin++);
+    result |= (byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return result;
+}
+
+#if defined(VARINT_WORD_DECODE)
+// Fast path given at least 8 readable bytes. A coordinate delta needs at
+// most 5 bytes so the terminating byte is always within the load.
+inline uint32_t varint_word(const char*& begin) {
+  uint64_t word;
+  std::memcpy(&word, begin, sizeof(word));
+  uint64_t stops = ~word & kContinuationBits;
+  if (stops == 0)
+    throw std::runtime_error("Bad encoded polyline");
+  uint32_t bits = __builtin_ctzll(stops) + 1;
+  begin += bits >> 3;
+  word &= bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+#if defined(__BMI2__)
+  return static_cast<uint32_t>(_pext_u64(word, 0x7f7f7f7f7f7f7f7fULL));
+#else
+  // Compact the 7 bit groups: pairs of bytes, then pairs of 14 bits, then
+  // pairs of 28 bits
+  word &= 0x7f7f7f7f7f7f7f7fULL;
+  word = (word & 0x007f007f007f007fULL) | ((word & 0x7f007f007f007f00ULL) >> 1);
+  word = (word & 0x00003fff00003fffULL) | ((word & 0x3fff00003fff0000ULL) >> 2);
+  word = (word & 0x000000000fffffffULL) | ((word & 0x0fffffff00000000ULL) >> 4);
+  return static_cast<uint32_t>(word);
+#endif
+}
+#endif
+
+inline int32_t unzigzag(const uint32_t value) {
+  return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+// Decodes the next varint, using the fast path when a full word can be loaded
+inline uint32_t varint(const char*& begin, const char* end) {
+#if defined(VARINT_WORD_DECODE)
+  if (end - begin >= 8)
+    return varint_word(begin);
+#endif
+  return varint_scalar(begin, end);
+}
+
+// Decodes each point and hands it to the output functor. Returns the count.
+template <class output_t>
+size_t decode(const char* begin, const size_t length, const output_t& output) {
+  const char* end = begin + length;
+  int32_t lat = 0, lng = 0;
+  size_t count = 0;
+#if defined(VARINT_WORD_DECODE)
+  const auto fast = [&begin, end]() { return end - begin >= 8; };
+  // Take the fast path while a full word can be loaded
+  while (fast()) {
+    lat += unzigzag(varint_word(begin));
+    lng += unzigzag(fast() ? varint_word(begin) : varint_scalar(begin, end));
+    output(count++, PointLL(lng * kPrecision, lat * kPrecision));
+  }
+#endif
+  while (begin < end) {
+    lat += unzigzag(varint_scalar(begin, end));
+    lng += unzigzag(varint_scalar(begin, end));
+    output(count++, PointLL(lng * kPrecision, lat * kPrecision));
+  }
+  return count;
+}
+
+}
+
+namespace valhalla {
+namespace baldr {
+
+// Decode into a vector, reusing its capacity
+void decode_shape7(const char* encoded, const size_t length,
+                   std::vector<PointLL>& shape) {
+  shape.clear();
+  // Every point takes at least 2 bytes
+  shape.reserve(length / 2);
+  decode(encoded, length, [&shape](const size_t, const PointLL& pt) {
+    shape.push_back(pt);
+  });
+}
+
+// Decode into a fixed size buffer
+size_t decode_shape7(const char* encoded, const size_t length,
+                     PointLL* shape, const size_t max_points) {
+  return decode(encoded, length, [shape, max_points](const size_t i, const PointLL& pt) {
+    if (i < max_points)
+      shape[i] = pt;
+  });
+}
+
+ShapeStream::ShapeStream(const char* encoded, const size_t length)
+    : begin_(encoded), end_(encoded + length), lat_(0), lng_(0) {
+}
+
+// Decode the next point
+PointLL ShapeStream::pop() {
+  lat_ += unzigzag(varint(begin_, end_));
+  lng_ += unzigzag(varint(begin_, end_));
+  return PointLL(lng_ * kPrecision, lat_ * kPrecision);
+}
+
+ShapeCache::ShapeCache(const size_t max_shapes)
+    : max_shapes_(max_shapes) {
+}
+
+// Get a shape, decoding it on a miss
+ShapeCache::shape_t ShapeCache::get(const uint32_t edgeinfo_offset,
+                                    const char* encoded, const size_t length) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = shapes_.find(edgeinfo_offset);
+    if (found != shapes_.end()) {
+      lru_.splice(lru_.begin(), lru_, found->second);
+      return found->second->second;
+    }
+  }
+
+  // Decode outside the lock
+  auto decoded = std::make_shared<std::vector<PointLL>>();
+  decode_shape7(encoded, length, *decoded);
+  decoded->shrink_to_fit();
+  shape_t shape(decoded);
+  if (max_shapes_ == 0)
+    return shape;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Another thread may have added it in the mean time
+  auto found = shapes_.find(edgeinfo_offset);
+  if (found != shapes_.end())
+    return found->second->second;
+  if (shapes_.size() >= max_shapes_) {
+    shapes_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+  lru_.emplace_front(edgeinfo_offset, shape);
+  shapes_.emplace(edgeinfo_offset, lru_.begin());
+  return shape;
+}
+
+// Number of cached shapes
+size_t ShapeCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return shapes_.size();
+}
+
+// Maximum number of cached shapes
+size_t ShapeCache::max_size() const {
+  return max_shapes_;
+}
+
+// Remove all shapes
+void ShapeCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  shapes_.clear();
+  lru_.clear();
+}
+
+}
+}
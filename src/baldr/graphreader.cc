@@ -3,9 +3,15 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <cmath>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <unordered_set>
 #include <sys/stat.h>
 #include <boost/filesystem.hpp>
 
+#include <valhalla/midgard/constants.h>
 #include <valhalla/midgard/logging.h>
 #include <valhalla/midgard/sequence.h>
 
@@ -16,6 +22,44 @@ namespace {
   constexpr size_t DEFAULT_MAX_CACHE_SIZE = 1073741824; //1 gig
   constexpr size_t AVERAGE_TILE_SIZE = 2097152; //2 megs
   constexpr size_t AVERAGE_MM_TILE_SIZE = 1024; //1k
+
+  // Distance in meters from a point to a box, 0 if the point is inside
+  float distance_to_box(const PointLL& pt, const AABB2<PointLL>& box) {
+    float dx = std::max(std::max(box.minx() - pt.lng(), pt.lng() - box.maxx()), 0.f) *
+               kMetersPerDegreeLat * std::cos(pt.lat() * kRadPerDeg);
+    float dy = std::max(std::max(box.miny() - pt.lat(), pt.lat() - box.maxy()), 0.f) *
+               kMetersPerDegreeLat;
+    return std::sqrt(dx * dx + dy * dy);
+  }
+
+  // Does the segment a,b intersect the box (Liang-Barsky clipping)
+  bool intersects(const AABB2<PointLL>& box, const PointLL& a, const PointLL& b) {
+    float t0 = 0.f, t1 = 1.f;
+    float dx = b.lng() - a.lng(), dy = b.lat() - a.lat();
+    const float p[] = { -dx, dx, -dy, dy };
+    const float q[] = { a.lng() - box.minx(), box.maxx() - a.lng(),
+                        a.lat() - box.miny(), box.maxy() - a.lat() };
+    for (int i = 0; i < 4; ++i) {
+      if (p[i] == 0.f) {
+        if (q[i] < 0.f)
+          return false;
+      } else {
+        float t = q[i] / p[i];
+        if (p[i] < 0.f)
+          t0 = std::max(t0, t);
+        else
+          t1 = std::min(t1, t);
+        if (t0 > t1)
+          return false;
+      }
+    }
+    return true;
+  }
+
+  // Shifts a longitude by whole turns to within 180 degrees of a reference
+  float wrap_near(const float lng, const float reference) {
+    return lng + std::round((reference - lng) / 360.f) * 360.f;
+  }
 }
 
 namespace valhalla {
@@ -59,6 +103,7 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt)
       cache_size_(0),
       tile_extract_(get_extract_instance(pt)) {
   max_cache_size_ = pt.get<size_t>("max_cache_size", DEFAULT_MAX_CACHE_SIZE);
+  shape_cache_size_ = pt.get<size_t>("shape_cache_size", 0);
 
   // Reserve cache (based on whether using individual tile files or shared,
   // mmap'd file
@@ -103,34 +148,37 @@ const GraphTile* GraphReader::GetGraphTile(const GraphId& graphid) {
   }
 
   // It wasn't in cache so create a GraphTile object.
+  GraphTile tile = ReadTile(base);
+  if (tile.size() == 0) {
+    return nullptr;
+  }
+
+  // Keep a copy in the cache and return it
+  if (!tile_extract_->tiles.empty()) {
+    cache_size_ += AVERAGE_MM_TILE_SIZE; // tile.size();  // TODO what size??
+  } else {
+    cache_size_ += tile.size();
+  }
+  tile.EnableShapeCache(shape_cache_size_);
+  tile.SetRealtimeOverlay(realtime_);
+  auto inserted = cache_.emplace(base, std::move(tile));
+  return &inserted.first->second;
+}
+
+// Reads a tile without caching it
+GraphTile GraphReader::ReadTile(const GraphId& base) const {
   if (!tile_extract_->tiles.empty()) {
     // Do we have this tile
     auto t = tile_extract_->tiles.find(base);
     if(t == tile_extract_->tiles.cend())
-      return nullptr;
+      return GraphTile();
 
     // This initializes the tile from mmap
-    GraphTile tile(base, t->second.first, t->second.second);
-    if (tile.size() == 0) {
-      return nullptr;
-    }
-
-    // Keep a copy in the cache and return it
-    cache_size_ += AVERAGE_MM_TILE_SIZE; // tile.size();  // TODO what size??
-    auto inserted = cache_.emplace(base, std::move(tile));
-    return &inserted.first->second;
-  } else {
-    // This reads the tile from disk
-    GraphTile tile(tile_hierarchy_, base);
-    if (tile.size() == 0) {
-      return nullptr;
-    }
-
-    // Keep a copy in the cache and return it
-    cache_size_ += tile.size();
-    auto inserted = cache_.emplace(base, std::move(tile));
-    return &inserted.first->second;
+    return GraphTile(base, t->second.first, t->second.second);
   }
+
+  // This reads the tile from disk
+  return GraphTile(tile_hierarchy_, base);
 }
 
 const GraphTile* GraphReader::GetGraphTile(const PointLL& pointll, const uint8_t level){
@@ -151,6 +199,13 @@ void GraphReader::Clear() {
   cache_.clear();
 }
 
+// Lays realtime updates over the cached tiles and those read later
+void GraphReader::SetRealtimeOverlay(std::shared_ptr<const RealtimeOverlay> overlay) {
+  realtime_ = std::move(overlay);
+  for (auto& tile : cache_)
+    tile.second.SetRealtimeOverlay(realtime_);
+}
+
 // Returns true if the cache is over committed with respect to the limit
 bool GraphReader::OverCommitted() const {
   return max_cache_size_ < cache_size_;
@@ -250,16 +305,33 @@ std::unordered_set<GraphId> GraphReader::GetTileSet() const {
   else {
     //for each level
     for(uint8_t level = 0; level < tile_hierarchy_.levels().rbegin()->first + 1; ++level) {
-      //crack open this level of tiles directory
-      boost::filesystem::path root_dir(tile_hierarchy_.tile_dir() + '/' + std::to_string(level) + '/');
-      if(boost::filesystem::exists(root_dir) && boost::filesystem::is_directory(root_dir)) {
-        //iterate over all the files in there
-        for (boost::filesystem::recursive_directory_iterator i(root_dir), end; i != end; ++i) {
-          if (!boost::filesystem::is_directory(i->path())) {
-            //add it if it can be parsed as a valid tile file name
-            try { tiles.emplace(GraphTile::GetTileId(i->path().string(), tile_hierarchy_.tile_dir())); }
-            catch (...) { }
-          }
+      auto level_tiles = GetTileSet(level);
+      tiles.insert(level_tiles.begin(), level_tiles.end());
+    }
+  }
+
+  //give them back
+  return tiles;
+}
+
+std::unordered_set<GraphId> GraphReader::GetTileSet(const uint8_t level) const {
+  //either mmap'd tiles
+  std::unordered_set<GraphId> tiles;
+  if(tile_extract_->tiles.size()) {
+    for(const auto& t : tile_extract_->tiles)
+      if(GraphId(t.first).level() == level)
+        tiles.emplace(t.first);
+  }//or individually on disk
+  else {
+    //crack open this level of tiles directory
+    boost::filesystem::path root_dir(tile_hierarchy_.tile_dir() + '/' + std::to_string(level) + '/');
+    if(boost::filesystem::exists(root_dir) && boost::filesystem::is_directory(root_dir)) {
+      //iterate over all the files in there
+      for (boost::filesystem::recursive_directory_iterator i(root_dir), end; i != end; ++i) {
+        if (!boost::filesystem::is_directory(i->path())) {
+          //add it if it can be parsed as a valid tile file name
+          try { tiles.emplace(GraphTile::GetTileId(i->path().string(), tile_hierarchy_.tile_dir())); }
+          catch (...) { }
         }
       }
     }
@@ -269,5 +341,236 @@ std::unordered_set<GraphId> GraphReader::GetTileSet() const {
   return tiles;
 }
 
+// Finds the edges whose shape is within a radius of a point.
+size_t GraphReader::EdgesInRadius(const PointLL& center, const float radius,
+                                  const uint8_t level,
+                                  const SpatialEdgeVisitor& visitor,
+                                  const size_t max_shapes) {
+  // Bounding box of the circle
+  float dlat = radius / kMetersPerDegreeLat;
+  float dlng = radius / (kMetersPerDegreeLat *
+                std::max(std::cos(center.lat() * kRadPerDeg), 0.0001f));
+  AABB2<PointLL> bbox(center.lng() - dlng, center.lat() - dlat,
+                      center.lng() + dlng, center.lat() + dlat);
+
+  return VisitBinnedEdges(bbox, level,
+    [&center, radius](const AABB2<PointLL>& bin) {
+      return distance_to_box(center, bin) <= radius;
+    },
+    [&center, radius](const std::vector<PointLL>& shape, SpatialEdge& edge) {
+      auto closest = center.ClosestPoint(shape);
+      edge.projected = std::get<0>(closest);
+      edge.distance = std::get<1>(closest);
+      return edge.distance <= radius;
+    }, visitor, max_shapes);
+}
+
+// Finds the edges whose shape intersects a bounding box.
+size_t GraphReader::EdgesInBoundingBox(const AABB2<PointLL>& bbox,
+                                       const uint8_t level,
+                                       const SpatialEdgeVisitor& visitor,
+                                       const size_t max_shapes) {
+  // A box crossing the antimeridian may come with minx > maxx, take it
+  // past 180 so it stays one box
+  AABB2<PointLL> box(bbox.minx(), bbox.miny(),
+                     bbox.maxx() + (bbox.minx() > bbox.maxx() ? 360.f : 0.f),
+                     bbox.maxy());
+  const PointLL center(wrap_near(box.Center().lng(), 0.f), box.Center().lat());
+  return VisitBinnedEdges(box, level,
+    [&box](const AABB2<PointLL>& bin) {
+      return bin.Intersects(box);
+    },
+    [&box, &center](const std::vector<PointLL>& shape, SpatialEdge& edge) {
+      edge.projected = center;
+      edge.distance = 0.f;
+      for (size_t i = 0; i + 1 < shape.size(); ++i) {
+        if (intersects(box, shape[i], shape[i + 1]))
+          return true;
+      }
+      return shape.size() == 1 && box.Contains(shape.front());
+    }, visitor, max_shapes);
+}
+
+// Decodes the shape of each edge in the bins that pass the bin filter.
+// Bins and shapes are moved by whole turns to within 180 degrees of the
+// center of the box so the filters work across the antimeridian.
+size_t GraphReader::VisitBinnedEdges(const AABB2<PointLL>& bbox,
+    const uint8_t level,
+    const std::function<bool (const AABB2<PointLL>&)>& bin_filter,
+    const std::function<bool (const std::vector<PointLL>&, SpatialEdge&)>& filter,
+    const SpatialEdgeVisitor& visitor, const size_t max_shapes) {
+  size_t decoded = 0;
+  auto tile_level = tile_hierarchy_.levels().find(level);
+  if (tile_level == tile_hierarchy_.levels().end())
+    return decoded;
+
+  // Edges show up in every bin they pass through so only look at them once
+  const float center_lng = bbox.Center().lng();
+  std::unordered_set<GraphId> seen;
+  std::vector<PointLL> wrapped;
+  for (const auto& tile_id : tile_hierarchy_.GetGraphIds(bbox, level)) {
+    const GraphTile* tile = GetGraphTile(tile_id);
+    if (tile == nullptr)
+      continue;
+
+    // Check each bin of the tile that may hold edges of interest
+    auto tile_box = tile_level->second.tiles.TileBounds(tile_id.tileid());
+    float tile_minx = wrap_near(tile_box.Center().lng(), center_lng) -
+                      (tile_box.maxx() - tile_box.minx()) * 0.5f;
+    float bin_width = (tile_box.maxx() - tile_box.minx()) / kBinsDim;
+    float bin_height = (tile_box.maxy() - tile_box.miny()) / kBinsDim;
+    for (size_t row = 0; row < kBinsDim; ++row) {
+      for (size_t col = 0; col < kBinsDim; ++col) {
+        AABB2<PointLL> bin(tile_minx + col * bin_width,
+                           tile_box.miny() + row * bin_height,
+                           tile_minx + (col + 1) * bin_width,
+                           tile_box.miny() + (row + 1) * bin_height);
+        if (!bin_filter(bin))
+          continue;
+
+        for (const auto& edge_id : tile->GetBin(col, row)) {
+          if (!seen.insert(edge_id).second)
+            continue;
+
+          // The edge may live in a neighboring tile
+          const GraphTile* edge_tile = (edge_id.Tile_Base() == tile_id) ?
+                                         tile : GetGraphTile(edge_id);
+          if (edge_tile == nullptr)
+            continue;
+
+          // Stop once we have decoded as many shapes as we are allowed
+          if (max_shapes != 0 && decoded == max_shapes)
+            return decoded;
+          const DirectedEdge* edge = edge_tile->directededge(edge_id);
+          auto shape = edge_tile->GetShape(edge->edgeinfo_offset());
+          ++decoded;
+
+          // Only copy the shape if some of it is on the far side
+          const std::vector<PointLL>* points = shape.get();
+          for (size_t i = 0; i < shape->size(); ++i) {
+            float lng = wrap_near((*shape)[i].lng(), center_lng);
+            if (lng != (*shape)[i].lng()) {
+              if (points != &wrapped) {
+                wrapped.assign(shape->begin(), shape->end());
+                points = &wrapped;
+              }
+              wrapped[i].Set(lng, wrapped[i].lat());
+            }
+          }
+
+          SpatialEdge found{edge_id, edge_tile, edge, 0.f, {}};
+          if (!filter(*points, found))
+            continue;
+          found.projected.Set(wrap_near(found.projected.lng(), 0.f), found.projected.lat());
+          if (!visitor(found))
+            return decoded;
+        }
+      }
+    }
+  }
+  return decoded;
+}
+
+// Sums the statistics of the tiles of a level within a bounding box
+TileStatistics GraphReader::GetStatistics(const AABB2<PointLL>& bbox,
+                                          const uint8_t level,
+                                          const size_t threads) {
+  return SumStatistics(tile_hierarchy_.GetGraphIds(bbox, level), threads);
+}
+
+// Sums the statistics of all the tiles of a level
+TileStatistics GraphReader::GetStatistics(const uint8_t level, const size_t threads) {
+  auto tiles = GetTileSet(level);
+  return SumStatistics(std::vector<GraphId>(tiles.begin(), tiles.end()), threads);
+}
+
+// Sums the statistics of a list of tiles using several threads
+TileStatistics GraphReader::SumStatistics(const std::vector<GraphId>& tiles,
+                                          size_t threads) {
+  // Cached tiles keep their statistics. The others are read, summed and
+  // dropped by the worker threads so the cache is not touched while they
+  // run (the reader is not thread safe).
+  std::vector<const GraphTile*> cached(tiles.size(), nullptr);
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    auto found = cache_.find(tiles[i].Tile_Base());
+    if (found != cache_.end())
+      cached[i] = &found->second;
+  }
+
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  threads = std::max(std::min(threads, tiles.size()), size_t(1));
+
+  // Each thread takes the next tile until there are none left
+  std::atomic<size_t> next(0);
+  std::vector<TileStatistics> sums(threads);
+  std::vector<std::exception_ptr> errors(threads);
+  auto work = [&](const size_t t) {
+    try {
+      for (size_t i = next++; i < tiles.size(); i = next++) {
+        if (cached[i] != nullptr) {
+          sums[t] += cached[i]->GetStatistics();
+        } else {
+          GraphTile tile = ReadTile(tiles[i].Tile_Base());
+          if (tile.size() > 0)
+            sums[t] += TileStatistics(tile);
+        }
+      }
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < threads; ++t)
+    workers.emplace_back(work, t);
+  work(0);
+  for (auto& worker : workers)
+    worker.join();
+
+  TileStatistics total;
+  for (size_t t = 0; t < threads; ++t) {
+    if (errors[t])
+      std::rethrow_exception(errors[t]);
+    total += sums[t];
+  }
+  return total;
+}
+
+// Get the onestop indexes of all the transit tiles, built on first use
+std::shared_ptr<const OneStopIndexes> GraphReader::GetOneStopIndexes() {
+  if (onestop_indexes_) {
+    return onestop_indexes_;
+  }
+
+  // Transit tiles are one level past the hierarchy. Tiles that are not
+  // cached are read and kept only until their indexes are merged.
+  uint8_t transit_level = tile_hierarchy_.levels().rbegin()->second.level + 1;
+  std::vector<GraphTile> read;
+  std::vector<const OneStopIndexes*> tiles;
+  for (const auto& tile_id : GetTileSet(transit_level)) {
+    auto cached = cache_.find(tile_id);
+    if (cached == cache_.end()) {
+      read.emplace_back(ReadTile(tile_id));
+      if (read.back().size() == 0) {
+        read.pop_back();
+        continue;
+      }
+    }
+    const GraphTile& tile = cached == cache_.end() ? read.back() : cached->second;
+    tiles.push_back(&tile.GetOneStopIndexes());
+  }
+
+  // Merge them
+  std::vector<const OneStopIndex*> stops, routes, operators;
+  for (const auto* indexes : tiles) {
+    stops.push_back(&indexes->stops);
+    routes.push_back(&indexes->routes);
+    operators.push_back(&indexes->operators);
+  }
+  onestop_indexes_.reset(new OneStopIndexes{ OneStopIndex::merge(stops),
+      OneStopIndex::merge(routes), OneStopIndex::merge(operators) });
+  return onestop_indexes_;
+}
+
 }
 }
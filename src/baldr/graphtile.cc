@@ -1,4 +1,5 @@
 #include "baldr/graphtile.h"
+#include "baldr/sorted_lookup.h"
 #include "baldr/datetime.h"
 #include <valhalla/midgard/tiles.h>
 #include <valhalla/midgard/aabb2.h>
@@ -6,8 +7,10 @@
 #include <valhalla/midgard/logging.h>
 
 #include <ctime>
+#include <limits>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <locale>
@@ -37,6 +40,13 @@ namespace {
   }
   const std::locale dir_locale(std::locale("C"), new dir_facet());
   const AABB2<PointLL> world_box(PointLL(-180, -90), PointLL(180, 90));
+
+  // Logs a departure lookup that found nothing. Kept out of line so the
+  // message is not built in the lookup itself.
+  VALHALLA_COLD void log_no_departure(const uint32_t lineid, const uint32_t tripid) {
+    LOG_INFO("No departures found for lineid = " + std::to_string(lineid) +
+             " and tripid = " + std::to_string(tripid));
+  }
 }
 
 namespace valhalla {
@@ -84,25 +94,24 @@ GraphTile::GraphTile(const TileHierarchy& hierarchy, const GraphId& graphid)
     file.close();
 
     // Set pointers to internal data structures
-    Initialize(graphid, graphtile_.get(), filesize);
+    Initialize(graphtile_.get(), filesize);
   }
   else {
     LOG_DEBUG("Tile " + file_location + " was not found");
   }
 }
 
-GraphTile::GraphTile(const GraphId& graphid, char* ptr, size_t size) {
+GraphTile::GraphTile(const GraphId& /*graphid*/, char* ptr, size_t size) {
   // Initialize the internal tile data structures using a pointer to the
   // tile and the tile size
-  Initialize(graphid, ptr, size);
+  Initialize(ptr, size);
 }
 
 GraphTile::~GraphTile() {
 }
 
 // Set pointers to internal tile data structures
-void GraphTile::Initialize(const GraphId& graphid, char* tile_ptr,
-                           const size_t tile_size) {
+void GraphTile::Initialize(char* tile_ptr, const size_t tile_size) {
   char* ptr = tile_ptr;
   header_ = reinterpret_cast<GraphTileHeader*>(ptr);
   ptr += sizeof(GraphTileHeader);
@@ -156,53 +165,69 @@ void GraphTile::Initialize(const GraphId& graphid, char* tile_ptr,
   textlist_ = tile_ptr + header_->textlist_offset();
   textlist_size_ = tile_size - header_->textlist_offset();
 
-  // Set the size to indicate success
+  // Set the size to indicate success. Onestop Ids of transit tiles are
+  // associated on first use.
   size_ = tile_size;
-
-  // Associate one stop Ids for transit tiles
-  if (graphid.level() == 3) {
-    AssociateOneStopIds(graphid);
-  }
 }
 
 // For transit tiles we need to save off the pair<tileid,lineid> lookup via
 // onestop_ids.  This will be used for including or excluding transit lines
-// for transit routes.  We save 2 maps because operators contain all of their
-// route's tile_line pairs and it is used to include or exclude the operator
-// as a whole. Also associates stops.
-void GraphTile::AssociateOneStopIds(const GraphId& graphid) {
-  // Associate stop Ids
-  stop_one_stops.reserve(header_->stopcount());
-  for (uint32_t i = 0; i < header_->stopcount(); i++) {
-    const auto& stop = GetName(transit_stops_[i].one_stop_offset());
-    stop_one_stops[stop] = tile_index_pair(graphid.tileid(), i);
-  }
-
-  // Associate route and operator Ids
-  auto deps = GetTransitDepartures();
-  for (auto const& dep: deps) {
-    const auto* t = GetTransitRoute(dep.second->routeid());
-    const auto& route_one_stop = GetName(t->one_stop_offset());
-    auto stops = route_one_stops.find(route_one_stop);
-    if (stops == route_one_stops.end()) {
-      std::list<tile_index_pair> tile_line_ids;
-      tile_line_ids.emplace_back(tile_index_pair(graphid.tileid(), dep.second->lineid()));
-      route_one_stops[route_one_stop] = tile_line_ids;
-    } else {
-      route_one_stops[route_one_stop].emplace_back(tile_index_pair(graphid.tileid(), dep.second->lineid()));
+// for transit routes.  We save 2 indexes because operators contain all of
+// their route's tile_line pairs and it is used to include or exclude the
+// operator as a whole. Also associates stops. Built on first use since most
+// requests never filter by onestop Id.
+const OneStopIndexes& GraphTile::GetOneStopIndexes() const {
+  return one_stop_indexes_.get([this]() {
+    std::vector<OneStopIndex::item_t> stops, routes, operators;
+    if (header_ != nullptr && header_->graphid().level() == 3) {
+      const uint32_t tileid = header_->graphid().tileid();
+
+      // Associate stop Ids
+      for (uint32_t i = 0; i < header_->stopcount(); i++) {
+        stops.emplace_back(GetNameView(transit_stops_[i].one_stop_offset()),
+                           tile_index_pair(tileid, i));
+      }
+
+      // Associate route and operator Ids, once per line. Departures are
+      // sorted by line Id so each line starts where the line Id changes.
+      for (uint32_t i = 0; i < header_->departurecount(); i++) {
+        const TransitDeparture& dep = departures_[i];
+        if (i > 0 && departures_[i - 1].lineid() == dep.lineid())
+          continue;
+        const auto* t = GetTransitRoute(dep.routeid());
+        const tile_index_pair tile_line(tileid, dep.lineid());
+        routes.emplace_back(GetNameView(t->one_stop_offset()), tile_line);
+
+        // operators contain all of their route's tile_line pairs.
+        operators.emplace_back(GetNameView(t->op_by_onestop_id_offset()), tile_line);
+      }
     }
-
-    // operators contain all of their route's tile_line pairs.
-    const auto& op_one_stop = GetName(t->op_by_onestop_id_offset());
-    stops = oper_one_stops.find(op_one_stop);
-    if (stops == oper_one_stops.end()) {
-      std::list<tile_index_pair> tile_line_ids;
-      tile_line_ids.emplace_back(tile_index_pair(graphid.tileid(), dep.second->lineid()));
-      oper_one_stops[op_one_stop] = tile_line_ids;
-    } else {
-      oper_one_stops[op_one_stop].emplace_back(tile_index_pair(graphid.tileid(), dep.second->lineid()));
+    return std::shared_ptr<const OneStopIndexes>(new OneStopIndexes{
+        OneStopIndex(std::move(stops)), OneStopIndex(std::move(routes)),
+        OneStopIndex(std::move(operators)) });
+  });
+}
+
+// Get the onestop Id maps, building them from the indexes on first use.
+const GraphTile::OneStopMaps& GraphTile::one_stops() const {
+  return one_stops_.get([this]() {
+    const OneStopIndexes& indexes = GetOneStopIndexes();
+    auto maps = std::make_shared<OneStopMaps>();
+    maps->stops.reserve(indexes.stops.size());
+    for (size_t i = 0; i < indexes.stops.size(); i++) {
+      auto entry = indexes.stops.entry(i);
+      maps->stops[entry.onestop.str()] = *(entry.pairs.end() - 1);
     }
-  }
+    for (size_t i = 0; i < indexes.routes.size(); i++) {
+      auto entry = indexes.routes.entry(i);
+      maps->routes[entry.onestop.str()].assign(entry.pairs.begin(), entry.pairs.end());
+    }
+    for (size_t i = 0; i < indexes.operators.size(); i++) {
+      auto entry = indexes.operators.entry(i);
+      maps->operators[entry.onestop.str()].assign(entry.pairs.begin(), entry.pairs.end());
+    }
+    return std::shared_ptr<const OneStopMaps>(std::move(maps));
+  });
 }
 
 std::string GraphTile::FileSuffix(const GraphId& graphid, const TileHierarchy& hierarchy) {
@@ -312,43 +337,67 @@ const GraphTileHeader* GraphTile::header() const {
 const NodeInfo* GraphTile::node(const GraphId& node) const {
   if (node.id() < header_->nodecount())
     return &nodes_[node.id()];
-  throw std::runtime_error("GraphTile NodeInfo index out of bounds: " +
-                             std::to_string(node.tileid()) + "," +
-                             std::to_string(node.level()) + "," +
-                             std::to_string(node.id()) + " nodecount= " +
-                             std::to_string(header_->nodecount()));
+  throw_out_of_bounds("NodeInfo", "nodecount", node.tileid(), node.level(),
+                      node.id(), header_->nodecount());
 }
 
 const NodeInfo* GraphTile::node(const size_t idx) const {
   if (idx < header_->nodecount())
     return &nodes_[idx];
-  throw std::runtime_error("GraphTile NodeInfo index out of bounds: " +
-                           std::to_string(header_->graphid().tileid()) + "," +
-                           std::to_string(header_->graphid().level()) + "," +
-                           std::to_string(idx)  + " nodecount= " +
-                           std::to_string(header_->nodecount()));
+  node_out_of_bounds(idx);
 }
 
 // Get the directed edge given a GraphId
 const DirectedEdge* GraphTile::directededge(const GraphId& edge) const {
   if (edge.id() < header_->directededgecount())
     return &directededges_[edge.id()];
-  throw std::runtime_error("GraphTile DirectedEdge index out of bounds: " +
-                           std::to_string(header_->graphid().tileid()) + "," +
-                           std::to_string(header_->graphid().level()) + "," +
-                           std::to_string(edge.id())  + " directededgecount= " +
-                           std::to_string(header_->directededgecount()));
+  directededge_out_of_bounds(edge.id());
 }
 
 // Get the directed edge at the specified index.
 const DirectedEdge* GraphTile::directededge(const size_t idx) const {
   if (idx < header_->directededgecount())
     return &directededges_[idx];
-  throw std::runtime_error("GraphTile DirectedEdge index out of bounds: " +
-                           std::to_string(header_->graphid().tileid()) + "," +
-                           std::to_string(header_->graphid().level()) + "," +
-                           std::to_string(idx)  + " directededgecount= " +
-                           std::to_string(header_->directededgecount()));
+  directededge_out_of_bounds(idx);
+}
+
+// Throws for a node index outside of this tile
+void GraphTile::node_out_of_bounds(const size_t idx) const {
+  throw_out_of_bounds("NodeInfo", "nodecount", header_->graphid().tileid(),
+                      header_->graphid().level(), idx, header_->nodecount());
+}
+
+// Throws for a directed edge index outside of this tile
+void GraphTile::directededge_out_of_bounds(const size_t idx) const {
+  throw_out_of_bounds("DirectedEdge", "directededgecount",
+                      header_->graphid().tileid(), header_->graphid().level(),
+                      idx, header_->directededgecount());
+}
+
+// Throws for a text list offset outside of this tile
+void GraphTile::textlist_out_of_bounds() const {
+  throw std::runtime_error("GetName: offset exceeds size of text list");
+}
+
+// Get all the nodes in this tile.
+midgard::iterable_t<const NodeInfo> GraphTile::GetNodes() const {
+  return iterable_t<const NodeInfo>{nodes_, header_->nodecount()};
+}
+
+// Get all the directed edges in this tile.
+midgard::iterable_t<const DirectedEdge> GraphTile::GetDirectedEdges() const {
+  return iterable_t<const DirectedEdge>{directededges_, header_->directededgecount()};
+}
+
+// Get the outbound directed edges of a node.
+midgard::iterable_t<const DirectedEdge> GraphTile::GetDirectedEdges(const size_t idx) const {
+  return GetNodeEdges().at(node(idx) - nodes_).edges;
+}
+
+// Get every node in this tile together with its outbound directed edges.
+NodeEdgesRange GraphTile::GetNodeEdges() const {
+  return NodeEdgesRange(nodes_, header_->nodecount(), directededges_,
+                        header_->directededgecount());
 }
 
 // Convenience method to get opposing edge Id given a directed edge.
@@ -361,7 +410,12 @@ GraphId GraphTile::GetOpposingEdgeId(const DirectedEdge* edge) const {
 
 // Get a pointer to edge info.
 EdgeInfo GraphTile::edgeinfo(const size_t offset) const {
-  return EdgeInfo(edgeinfo_ + offset, textlist_, textlist_size_);
+  return EdgeInfo(edgeinfo_ref(offset));
+}
+
+// Get a lightweight handle to edge info.
+EdgeInfoRef GraphTile::edgeinfo_ref(const size_t offset) const {
+  return EdgeInfoRef(edgeinfo_ + offset, textlist_, textlist_size_);
 }
 
 // Get the directed edges outbound from the specified node index.
@@ -380,13 +434,44 @@ std::vector<std::string> GraphTile::GetNames(const uint32_t edgeinfo_offset) con
   return edgeinfo(edgeinfo_offset).GetNames();
 }
 
+// Get the shape of an edge, from the shape cache if enabled
+ShapeCache::shape_t GraphTile::GetShape(const uint32_t edgeinfo_offset) const {
+  EdgeInfoRef info = edgeinfo_ref(edgeinfo_offset);
+  if (shape_cache_) {
+    return shape_cache_->get(edgeinfo_offset, info.encoded_shape_data(),
+                             info.encoded_shape_size());
+  }
+  auto shape = std::make_shared<std::vector<PointLL>>();
+  info.decode_shape(*shape);
+  return shape;
+}
+
+// Enable the shape cache
+void GraphTile::EnableShapeCache(const size_t max_shapes) {
+  if (max_shapes == 0)
+    shape_cache_.reset();
+  else
+    shape_cache_ = std::make_shared<ShapeCache>(max_shapes);
+}
+
+// Get the names for an edge without copying them
+NameViews GraphTile::GetNameViews(const uint32_t edgeinfo_offset) const {
+  return edgeinfo_ref(edgeinfo_offset).GetNameViews();
+}
+
 // Get the admininfo at the specified index.
 AdminInfo GraphTile::admininfo(const size_t idx) const {
+  AdminView admin = admin_view(idx);
+  return AdminInfo(admin.country_text.str(), admin.state_text.str(),
+                   admin.country_iso.str(), admin.state_iso.str());
+}
+
+// Get the admin text at the specified index without copying it.
+AdminView GraphTile::admin_view(const size_t idx) const {
   if (idx < header_->admincount()) {
     const Admin& admin = admins_[idx];
-    return AdminInfo(textlist_ + admin.country_offset(),
-                     textlist_ + admin.state_offset(),
-                     admin.country_iso(), admin.state_iso());
+    return { GetNameView(admin.country_offset()), GetNameView(admin.state_offset()),
+             admin.country_iso_view(), admin.state_iso_view() };
   }
   throw std::runtime_error("GraphTile AdminInfo index out of bounds");
 }
@@ -401,106 +486,194 @@ const Admin* GraphTile::admin(const size_t idx) const {
 
 // Convenience method to get the text/name for a given offset to the textlist
 std::string GraphTile::GetName(const uint32_t textlist_offset) const {
+  return GetNameView(textlist_offset).str();
+}
 
-  if (textlist_offset < textlist_size_) {
-    return textlist_ + textlist_offset;
-  } else {
+// Get the text/name for a given offset to the textlist without copying it
+TextView GraphTile::GetNameView(const uint32_t textlist_offset) const {
+  if (VALHALLA_UNLIKELY(textlist_offset >= textlist_size_))
+    textlist_out_of_bounds();
+  return TextView::terminated(textlist_ + textlist_offset,
+                              textlist_size_ - textlist_offset);
+}
+
+// Get the tile name id of a name
+uint32_t GraphTile::GetNameId(const uint32_t textlist_offset) const {
+  if (textlist_offset >= textlist_size_)
     throw std::runtime_error("GetName: offset exceeds size of text list");
-  }
+  return name_ids().local(textlist_offset);
+}
+
+// Get the process wide name id of a name
+uint32_t GraphTile::GetGlobalNameId(const uint32_t textlist_offset) const {
+  return name_ids().global(textlist_offset);
+}
+
+// Get the sorted process wide name ids of an edge
+void GraphTile::GetNameIds(const uint32_t edgeinfo_offset,
+                           std::vector<uint32_t>& ids) const {
+  EdgeInfoRef info = edgeinfo_ref(edgeinfo_offset);
+  ids.clear();
+  for (uint32_t i = 0; i < info.name_count(); i++)
+    ids.push_back(GetGlobalNameId(info.GetStreetNameOffset(i)));
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+// Get the name ids of the text list, building them on first use.
+const TileNameIds& GraphTile::name_ids() const {
+  return name_ids_.get([this]() {
+    return std::make_shared<const TileNameIds>(textlist_, textlist_size_);
+  });
 }
 
 // Convenience method to get the signs for an edge given the
 // directed edge index.
 std::vector<SignInfo> GraphTile::GetSigns(const uint32_t idx) const {
-  uint32_t count = header_->signcount();
+  SignViews views = GetSignViews(idx);
   std::vector<SignInfo> signs;
-  if (count == 0) {
-    return signs;
-  }
+  signs.reserve(views.size());
+  for (const auto& sign : views)
+    signs.emplace_back(sign.type, sign.text.str());
+  return signs;
+}
 
-  // Signs are sorted by edge index.
-  // Binary search to find a sign with matching edge index.
-  int32_t low = 0;
-  int32_t high = count-1;
-  int32_t mid;
-  int32_t found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& sign = signs_[mid];
-    //matching edge index
-    if (idx == sign.edgeindex()) {
-      found = mid;
-      high = mid - 1;
-    }//need a smaller index
-    else if (idx < sign.edgeindex()) {
-      high = mid - 1;
-    }//need a bigger index
-    else {
-      low = mid + 1;
-    }
+// Get the signs for an edge without copying their text
+SignViews GraphTile::GetSignViews(const uint32_t idx) const {
+  if (header_->signcount() == 0) {
+    return SignViews(signs_, 0, textlist_, textlist_size_);
   }
 
-  // Add signs
-  for(; found < count && signs_[found].edgeindex() == idx; ++found) {
-    if (signs_[found].text_offset() < textlist_size_)
-      signs.emplace_back(signs_[found].type(), (textlist_ + signs_[found].text_offset()));
-    else
-      throw std::runtime_error("GetSigns: offset exceeds size of text list");
-  }
-  if (signs.size() == 0)
-    LOG_ERROR("No signs found for idx = " + std::to_string(idx));
-  return signs;
+  // Signs are sorted by edge index. Jump straight to this edge's signs.
+  auto range = sign_index().range(idx);
+  return SignViews(signs_ + range.first, range.second - range.first,
+                   textlist_, textlist_size_);
 }
 
 // Get the next departure given the directed line Id and the current
-// time (seconds from midnight).
+// time (seconds from midnight). Uses the scheduled times only, since the
+// caller has no way to receive the delay.
 const TransitDeparture* GraphTile::GetNextDeparture(const uint32_t lineid,
                  const uint32_t current_time, const uint32_t day,
                  const uint32_t dow, bool date_before_tile,
                  bool wheelchair, bool bicycle) const {
+  return next_departure(lineid, current_time, day, dow, date_before_tile,
+                        wheelchair, bicycle, 0, false).departure;
+}
+
+// Get the next departure given the line Id and current time, searching the
+// following days up to the horizon
+DayDeparture GraphTile::GetNextDeparture(const uint32_t lineid,
+                 const uint32_t current_time, const uint32_t day,
+                 const uint32_t dow, bool date_before_tile,
+                 bool wheelchair, bool bicycle,
+                 const uint32_t horizon_days) const {
+  return next_departure(lineid, current_time, day, dow, date_before_tile,
+                        wheelchair, bicycle, horizon_days, true);
+}
+
+// Get the next departure of a line, optionally applying the realtime updates
+DayDeparture GraphTile::next_departure(const uint32_t lineid,
+                 const uint32_t current_time, const uint32_t day,
+                 const uint32_t dow, bool date_before_tile,
+                 bool wheelchair, bool bicycle,
+                 const uint32_t horizon_days, const bool use_realtime) const {
   uint32_t count = header_->departurecount();
   if (count == 0) {
-    return nullptr;
+    return { nullptr, 0, 0 };
   }
 
-  // Departures are sorted by edge Id and then by departure time.
-  // Binary search to find a departure with matching line Id.
-  int32_t low = 0;
-  int32_t high = count-1;
-  int32_t mid;
-  int32_t found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& dep = departures_[mid];
-    //matching lineid and a workable time
-    if (lineid == dep.lineid() && current_time <= dep.departure_time()) {
-      found = mid;
-      high = mid - 1;
-    }//need a smaller lineid
-    else if (lineid < dep.lineid()) {
-      high = mid - 1;
-    }//either need a bigger lineid or a later time
-    else {
-      low = mid + 1;
-    }
+  // Departures are sorted by line Id and then by departure time. Find the
+  // departures on this line.
+  auto range = departure_index().range(lineid);
+  if (range.first == range.second) {
+    return { nullptr, 0, 0 };
   }
-
-  // Iterate through departures until one is found with valid date, dow or
-  // calendar date, and does not have a calendar exception.
-  for(; found < count && departures_[found].lineid() == lineid; ++found) {
-    // Make sure valid departure time
-    if (departures_[found].departure_time() >= current_time &&
-      GetTransitSchedule(departures_[found].schedule_index())->IsValid(day, dow, date_before_tile) &&
-      (!wheelchair || departures_[found].wheelchair_accessible()) &&
-      (!bicycle || departures_[found].bicycle_accessible())) {
-      return &departures_[found];
+  const DepartureTable& table = departure_table();
+  const ActiveDays active = table.active_days(lineid);
+  RealtimeOverlay::Reader realtime(use_realtime ? realtime_.get() : nullptr);
+  const RealtimeDelays::TileDelays* delays = realtime_delays(realtime);
+
+  uint32_t d = day;
+  uint32_t w = dow;
+  for (uint32_t offset = 0; offset <= horizon_days; offset++) {
+    // Skip days on which none of the line's schedules run
+    if (active.may_run(d, w, date_before_tile)) {
+      // Find the first departure at or after the current time (midnight on
+      // the following days) with a schedule valid on this day (by date, dow
+      // or calendar date) and the requested accessibility.
+      // Realtime updates only apply to the current day. Days past those the
+      // table caches are checked on this line only, so a long horizon does
+      // not evict the cached days.
+      int32_t delay = 0;
+      uint32_t found;
+      if (offset >= DepartureTable::kCachedDays) {
+        found = table.next_valid_on(range.first, range.second, d, w,
+                                    date_before_tile, wheelchair, bicycle);
+      } else if (offset == 0 && delays != nullptr) {
+        found = next_delayed(*delays, range.first, range.second, current_time,
+                             *table.valid_on(d, w, date_before_tile),
+                             wheelchair, bicycle, delay);
+      } else {
+        found = table.lower_bound(range.first, range.second,
+                                  offset == 0 ? current_time : 0);
+        found = table.next_valid(found, range.second,
+                                 *table.valid_on(d, w, date_before_tile),
+                                 wheelchair, bicycle);
+      }
+      if (found < range.second) {
+        return { &departures_[found], offset, delay };
+      }
     }
+
+    // Move to the next day and day of week
+    d++;
+    w = (w == kSaturday) ? kSunday : (w << 1);
   }
 
-  // TODO - maybe wrap around, try next day?
   LOG_DEBUG("No more departures found for lineid = " + std::to_string(lineid) +
            " current_time = " + std::to_string(current_time));
-  return nullptr;
+  return { nullptr, 0, 0 };
+}
+
+// Get the bitset of the schedules valid on a day
+std::shared_ptr<const DepartureTable::bitmap_t> GraphTile::GetActiveSchedules(
+    const uint32_t day, const uint32_t dow, bool date_before_tile) const {
+  return departure_table().active_schedules(day, dow, date_before_tile);
+}
+
+// Get the departures on a line within a time window that run on a day
+DepartureWindow GraphTile::GetDepartures(const uint32_t lineid,
+                 const uint32_t start, const uint32_t end, const uint32_t day,
+                 const uint32_t dow, bool date_before_tile, bool wheelchair,
+                 bool bicycle) const {
+  // Departures of a line are sorted by time so the window is the range
+  // from the first departure at or after the start to the first one after
+  // the end.
+  auto range = departure_index().range(lineid);
+  const DepartureTable& table = departure_table();
+  const uint32_t first = table.lower_bound(range.first, range.second, start);
+  const uint32_t last = (end < start) ? first :
+      table.upper_bound(first, range.second, end);
+  return DepartureWindow(table, first, last,
+                         table.valid_on(day, dow, date_before_tile),
+                         wheelchair, bicycle);
+}
+
+// Get the departures of all lines within a time window in time order
+DeparturesByTime GraphTile::GetDeparturesByTime(const uint32_t start,
+                 const uint32_t end) const {
+  return DeparturesByTime(departure_table(), start, end, nullptr, false, false);
+}
+
+// Get the departures of all lines within a time window that run on a day
+DeparturesByTime GraphTile::GetDeparturesByTime(const uint32_t start,
+                 const uint32_t end, const uint32_t day, const uint32_t dow,
+                 bool date_before_tile, bool wheelchair, bool bicycle) const {
+  const DepartureTable& table = departure_table();
+  return DeparturesByTime(table, start, end,
+                          table.valid_on(day, dow, date_before_tile),
+                          wheelchair, bicycle);
 }
 
 // Get the departure given the line Id and tripid
@@ -511,38 +684,59 @@ const TransitDeparture* GraphTile::GetTransitDeparture(const uint32_t lineid,
     return nullptr;
   }
 
-  // Departures are sorted by edge Id and then by departure time.
-  // Binary search to find a departure with matching line Id.
-  int32_t low = 0;
-  int32_t high = count-1;
-  int32_t mid;
-  int32_t found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& dep = departures_[mid];
-    //find the first matching lineid in the list
-    if (lineid == dep.lineid()) {
-      found = mid;
-      high = mid - 1;
-    }//need a smaller lineid
-    else if (lineid < dep.lineid()) {
-      high = mid - 1;
-    }//need a bigger lineid
-    else {
-      low = mid + 1;
-    }
+  // A cancelled trip does not depart on any of its lines
+  if (IsTripCancelled(tripid)) {
+    return nullptr;
   }
 
-  // Iterate through departures until one is found with matching trip id
-  for(; found < count && departures_[found].lineid() == lineid; ++found)
-    if (departures_[found].tripid() == tripid)
+  // Look through the few departures of the trip for the one on this line
+  for (const uint32_t found : trip_index().trip(tripid))
+    if (departures_[found].lineid() == lineid)
       return &departures_[found];
 
-  LOG_INFO("No departures found for lineid = " + std::to_string(lineid) +
-           " and tripid = " + std::to_string(tripid));
+  log_no_departure(lineid, tripid);
   return nullptr;
 }
 
+// Lays realtime updates over the departures of this tile
+void GraphTile::SetRealtimeOverlay(std::shared_ptr<const RealtimeOverlay> overlay) {
+  realtime_ = std::move(overlay);
+}
+
+// Get the realtime delay of a departure
+int32_t GraphTile::GetDepartureDelay(const TransitDeparture& departure) const {
+  RealtimeOverlay::Reader realtime(realtime_.get());
+  const RealtimeDelays::TileDelays* delays = realtime_delays(realtime);
+  const TripUpdate* update = delays ? delays->trip(departure.tripid()) : nullptr;
+  return update ? update->delay_at(departure.lineid()) : 0;
+}
+
+// Is a trip cancelled by a realtime update
+bool GraphTile::IsTripCancelled(const uint32_t tripid) const {
+  RealtimeOverlay::Reader realtime(realtime_.get());
+  const RealtimeDelays::TileDelays* delays = realtime_delays(realtime);
+  const TripUpdate* update = delays ? delays->trip(tripid) : nullptr;
+  return update && update->cancelled;
+}
+
+// Get the next departure of a trip at or after a time
+const TransitDeparture* GraphTile::GetNextTripDeparture(const uint32_t tripid,
+                     const uint32_t time) const {
+  if (header_->departurecount() == 0) {
+    return nullptr;
+  }
+  return first_departure_after(trip_index().trip(tripid), time);
+}
+
+// Get the next departure of a block at or after a time
+const TransitDeparture* GraphTile::GetNextBlockDeparture(const uint32_t blockid,
+                     const uint32_t time) const {
+  if (header_->departurecount() == 0) {
+    return nullptr;
+  }
+  return first_departure_after(trip_index().block(blockid), time);
+}
+
 // Get a map of departures based on lineid.  No dups exist in the map.
 std::unordered_map<uint32_t,TransitDeparture*> GraphTile::GetTransitDepartures() const {
 
@@ -556,21 +750,21 @@ std::unordered_map<uint32_t,TransitDeparture*> GraphTile::GetTransitDepartures()
 }
 
 // Get the stop onestops in this tile
-std::unordered_map<std::string, tile_index_pair>
+const std::unordered_map<std::string, tile_index_pair>&
 GraphTile::GetStopOneStops() const {
-  return stop_one_stops;
+  return one_stops().stops;
 }
 
 // Get the route onestops in this tile.
-std::unordered_map<std::string, std::list<tile_index_pair>>
+const std::unordered_map<std::string, std::list<tile_index_pair>>&
 GraphTile::GetRouteOneStops() const {
-  return route_one_stops;
+  return one_stops().routes;
 }
 
 // Get the operator onestops in this tile.
-std::unordered_map<std::string, std::list<tile_index_pair>>
+const std::unordered_map<std::string, std::list<tile_index_pair>>&
 GraphTile::GetOperatorOneStops() const {
-  return oper_one_stops;
+  return one_stops().operators;
 }
 
 // Get the transit stop given its index within the tile.
@@ -618,35 +812,13 @@ std::vector<AccessRestriction> GraphTile::GetAccessRestrictions(const uint32_t i
     return restrictions;
   }
 
-  // Access restriction are sorted by edge Id.
-  // Binary search to find a access restriction with matching edge Id.
-  int32_t low = 0;
-  int32_t high = count-1;
-  int32_t mid;
-  int32_t found = count;
-  while (low <= high) {
-    mid = (low + high) / 2;
-    const auto& res = access_restrictions_[mid];
-    //find the first matching index in the list
-    if (idx == res.edgeindex()) {
-      found = mid;
-      high = mid - 1;
-    }//need a smaller index
-    else if (idx < res.edgeindex()) {
-      high = mid - 1;
-    }//need a bigger index
-    else {
-      low = mid + 1;
-    }
-  }
-
-  // Add restrictions for only the access that we are interested in
-  for (; found < count && access_restrictions_[found].edgeindex() == idx; ++found)
+  // Access restrictions are sorted by edge index. Jump straight to this
+  // edge's restrictions and add only those for the access that we are
+  // interested in.
+  auto range = restriction_index().range(idx);
+  for (uint32_t found = range.first; found < range.second; ++found)
     if (access_restrictions_[found].modes() & access)
       restrictions.emplace_back(access_restrictions_[found]);
-
-  if (restrictions.size() == 0)
-    LOG_ERROR("No restrictions found for edge index = " + std::to_string(idx));
   return restrictions;
 }
 
@@ -661,5 +833,147 @@ midgard::iterable_t<GraphId> GraphTile::GetBin(size_t index) const {
   return iterable_t<GraphId>{edge_bins_ + offsets.first, edge_bins_ + offsets.second};
 }
 
+// Get the spatial index over the edge shapes, building it on first use.
+const EdgeSpatialIndex& GraphTile::GetSpatialIndex() const {
+  return spatial_index_.get([this]() {
+    return std::make_shared<const EdgeSpatialIndex>(*this);
+  });
+}
+
+// Get the fixed point edge shapes, building them on first use.
+const QuantizedShapes& GraphTile::GetQuantizedShapes() const {
+  return quantized_shapes_.get([this]() {
+    return std::make_shared<const QuantizedShapes>(*this);
+  });
+}
+
+// Get the summary statistics of this tile, computing them on first use.
+const TileStatistics& GraphTile::GetStatistics() const {
+  return statistics_.get([this]() {
+    return std::make_shared<const TileStatistics>(*this);
+  });
+}
+
+// Get the departure table, building it on first use.
+const DepartureTable& GraphTile::departure_table() const {
+  return departure_table_.get([this]() {
+    return std::make_shared<const DepartureTable>(departures_,
+        header_->departurecount(), transit_schedules_, header_->schedulecount());
+  });
+}
+
+// Get the index of the departures by trip and block Id, building it on first
+// use.
+const TripIndex& GraphTile::trip_index() const {
+  return trip_index_.get([this]() {
+    return std::make_shared<const TripIndex>(departures_,
+        header_->departurecount());
+  });
+}
+
+// Finds the first of a trip's or block's departures at or after a time
+const TransitDeparture* GraphTile::first_departure_after(
+    const TripIndex::positions_t& positions, const uint32_t time) const {
+  // With realtime updates check each of the (few) departures for
+  // cancellation and compare their delayed times
+  RealtimeOverlay::Reader realtime(realtime_.get());
+  const RealtimeDelays::TileDelays* delays = realtime_delays(realtime);
+  if (delays != nullptr) {
+    const TransitDeparture* best = nullptr;
+    int64_t best_time = std::numeric_limits<int64_t>::max();
+    for (const uint32_t i : positions) {
+      int64_t t = departures_[i].departure_time();
+      if (const TripUpdate* update = delays->trip(departures_[i].tripid())) {
+        if (update->cancelled)
+          continue;
+        t += update->delay_at(departures_[i].lineid());
+      }
+      if (t >= time && t < best_time) {
+        best = &departures_[i];
+        best_time = t;
+      }
+    }
+    return best;
+  }
+
+  const uint32_t found = branchless_lower_bound(positions.begin(), positions.size(),
+      [this, time](const uint32_t i) { return departures_[i].departure_time() < time; });
+  return found < positions.size() ? &departures_[*(positions.begin() + found)] : nullptr;
+}
+
+// Get the realtime updates of this tile
+const RealtimeDelays::TileDelays* GraphTile::realtime_delays(
+    const RealtimeOverlay::Reader& reader) const {
+  const RealtimeDelays* delays = reader.delays();
+  return delays ? delays->tile(header_->graphid()) : nullptr;
+}
+
+// Finds the valid departure that leaves first at or after a time once
+// delays are applied
+uint32_t GraphTile::next_delayed(const RealtimeDelays::TileDelays& delays,
+                                 const uint32_t begin, const uint32_t end,
+                                 const uint32_t time,
+                                 const DepartureTable::bitmap_t& valid,
+                                 const bool wheelchair, const bool bicycle,
+                                 int32_t& delay) const {
+  // Departures scheduled up to the largest delay before the time may now
+  // leave at or after it
+  const DepartureTable& table = departure_table();
+  const uint32_t earliest = static_cast<uint32_t>(
+      std::max<int64_t>(0, int64_t(time) - delays.max_delay));
+  uint32_t best = end;
+  int64_t best_time = std::numeric_limits<int64_t>::max();
+  for (uint32_t i = table.next_valid(table.lower_bound(begin, end, earliest),
+                                     end, valid, wheelchair, bicycle);
+       i < end; i = table.next_valid(i + 1, end, valid, wheelchair, bicycle)) {
+    // Later departures can not leave before the best one found so far
+    if (int64_t(table.time(i)) + delays.min_delay >= best_time) {
+      break;
+    }
+    int32_t d = 0;
+    if (const TripUpdate* update = delays.trip(departures_[i].tripid())) {
+      if (update->cancelled) {
+        continue;
+      }
+      d = update->delay_at(departures_[i].lineid());
+    }
+    const int64_t t = int64_t(table.time(i)) + d;
+    if (t >= time && t < best_time) {
+      best = i;
+      best_time = t;
+      delay = d;
+    }
+  }
+  return best;
+}
+
+// Get the index of the signs by edge index, building it on first use.
+const RecordIndex& GraphTile::sign_index() const {
+  return sign_index_.get([this]() {
+    return std::make_shared<const RecordIndex>(signs_, header_->signcount(),
+        [](const Sign& sign) { return sign.edgeindex(); });
+  });
+}
+
+// Get the index of the access restrictions by edge index, building it on
+// first use.
+const RecordIndex& GraphTile::restriction_index() const {
+  return restriction_index_.get([this]() {
+    return std::make_shared<const RecordIndex>(access_restrictions_,
+        header_->access_restriction_count(),
+        [](const AccessRestriction& res) { return res.edgeindex(); });
+  });
+}
+
+// Get the index of the transit departures by line Id, building it on first
+// use.
+const RecordIndex& GraphTile::departure_index() const {
+  return departure_index_.get([this]() {
+    return std::make_shared<const RecordIndex>(departures_,
+        header_->departurecount(),
+        [](const TransitDeparture& dep) { return dep.lineid(); });
+  });
+}
+
 }
 }
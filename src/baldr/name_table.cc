@@ -0,0 +1,106 @@
+#include "baldr/name_table.h"
+#include "baldr/sorted_lookup.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace valhalla {
+namespace baldr {
+
+// Get the process wide table
+NameTable& NameTable::instance() {
+  static NameTable table;
+  return table;
+}
+
+// Get the id of a name, adding it if it is new
+uint32_t NameTable::Intern(const TextView& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = ids_.find(name);
+  if (found != ids_.end())
+    return found->second;
+  if (names_.size() == kInvalidNameId)
+    throw std::runtime_error("NameTable is full");
+  names_.push_back(name.str());
+  const uint32_t id = static_cast<uint32_t>(names_.size() - 1);
+  ids_.emplace(TextView(names_.back().data(), names_.back().size()), id);
+  return id;
+}
+
+// Get the id of a name without adding it
+uint32_t NameTable::Find(const TextView& name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = ids_.find(name);
+  return found == ids_.end() ? kInvalidNameId : found->second;
+}
+
+// Get the name given its id
+const std::string& NameTable::Name(const uint32_t id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (id >= names_.size())
+    throw std::runtime_error("NameTable id is out of bounds");
+  return names_[id];
+}
+
+// Get the number of names
+size_t NameTable::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return names_.size();
+}
+
+// Scan the text list for repeated strings, interning each one the first
+// time it is seen
+TileNameIds::TileNameIds(const char* text, const size_t text_size)
+    : text_(text), text_size_(text_size) {
+  NameTable& table = NameTable::instance();
+  std::unordered_map<TextView, std::pair<uint32_t, uint32_t>, TextViewHash> first;
+  size_t offset = 0;
+  while (offset < text_size) {
+    TextView name = TextView::terminated(text + offset, text_size - offset);
+    auto found = first.find(name);
+    if (found == first.end()) {
+      found = first.emplace(name, std::make_pair(static_cast<uint32_t>(offset),
+                                                 table.Intern(name))).first;
+    } else {
+      duplicates_.emplace_back(offset, found->second.first);
+    }
+    global_.emplace_back(offset, found->second.second);
+    offset += name.size() + 1;
+  }
+}
+
+// Get the tile name id of a name
+uint32_t TileNameIds::local(const uint32_t offset) const {
+  uint32_t found = branchless_lower_bound(duplicates_.data(), duplicates_.size(),
+      [offset](const std::pair<uint32_t, uint32_t>& d) { return d.first < offset; });
+  if (found < duplicates_.size() && duplicates_[found].first == offset)
+    return duplicates_[found].second;
+  return offset;
+}
+
+// Get the process wide name id of a name
+uint32_t TileNameIds::global(const uint32_t offset) const {
+  if (offset >= text_size_)
+    throw std::runtime_error("GetName: offset exceeds size of text list");
+  uint32_t found = branchless_lower_bound(global_.data(), global_.size(),
+      [offset](const std::pair<uint32_t, uint32_t>& g) { return g.first < offset; });
+  if (found < global_.size() && global_[found].first == offset)
+    return global_[found].second;
+
+  // An offset within a string names its tail, which is not precomputed
+  return NameTable::instance().Intern(
+      TextView::terminated(text_ + offset, text_size_ - offset));
+}
+
+// Intersection of two sorted lists of name ids
+void common_name_ids(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                     std::vector<uint32_t>& common) {
+  common.clear();
+  std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                        std::back_inserter(common));
+}
+
+}
+}
@@ -0,0 +1,74 @@
+#include "baldr/onestop_index.h"
+#include "baldr/sorted_lookup.h"
+
+#include <algorithm>
+
+namespace valhalla {
+namespace baldr {
+
+// Empty index
+OneStopIndex::OneStopIndex() : offsets_(1, std::make_pair(0u, 0u)) {
+}
+
+// Sorts the items and lays them out flat
+OneStopIndex::OneStopIndex(std::vector<item_t> items) {
+  std::sort(items.begin(), items.end(), [](const item_t& a, const item_t& b) {
+    return a.first < b.first || (a.first == b.first && a.second < b.second);
+  });
+  items.erase(std::unique(items.begin(), items.end()), items.end());
+
+  pairs_.reserve(items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    if (i == 0 || items[i].first != items[i - 1].first) {
+      offsets_.emplace_back(text_.size(), pairs_.size());
+      text_.append(items[i].first.data(), items[i].first.size());
+      text_.push_back('\0');
+    }
+    pairs_.push_back(items[i].second);
+  }
+  offsets_.emplace_back(text_.size(), pairs_.size());
+}
+
+// Merges several indexes
+OneStopIndex OneStopIndex::merge(const std::vector<const OneStopIndex*>& indexes) {
+  std::vector<item_t> items;
+  for (const auto* index : indexes) {
+    for (size_t i = 0; i < index->size(); ++i) {
+      Entry e = index->entry(i);
+      for (const auto& pair : e.pairs)
+        items.emplace_back(e.onestop, pair);
+    }
+  }
+  return OneStopIndex(std::move(items));
+}
+
+// Get the pairs of a onestop Id
+midgard::iterable_t<const tile_index_pair> OneStopIndex::find(const TextView& onestop) const {
+  const uint32_t found = branchless_lower_bound(offsets_.data(), size(),
+      [this, &onestop](const std::pair<uint32_t, uint32_t>& offset) {
+        return this->onestop(&offset - offsets_.data()) < onestop;
+      });
+  if (found < size() && this->onestop(found) == onestop)
+    return entry(found).pairs;
+  return midgard::iterable_t<const tile_index_pair>(pairs_.data(), size_t(0));
+}
+
+// Get the number of distinct onestop Ids
+size_t OneStopIndex::size() const {
+  return offsets_.size() - 1;
+}
+
+// Get an entry given its position
+OneStopIndex::Entry OneStopIndex::entry(const size_t i) const {
+  return { onestop(i), midgard::iterable_t<const tile_index_pair>(
+               pairs_.data() + offsets_[i].second, pairs_.data() + offsets_[i + 1].second) };
+}
+
+// Get the onestop Id of an entry
+TextView OneStopIndex::onestop(const size_t i) const {
+  return TextView(text_.data() + offsets_[i].first,
+                  offsets_[i + 1].first - offsets_[i].first - 1);
+}
+
+}
+}
@@ -0,0 +1,272 @@
+#include "baldr/quantized_shapes.h"
+#include "baldr/graphtile.h"
+#include "baldr/sorted_lookup.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <valhalla/midgard/constants.h>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// Words in the buffer header
+constexpr uint32_t kHeaderSize = 4;
+
+// Segments measured at a time by QuantizedShapes::closest
+constexpr uint32_t kChunkSize = 64;
+
+int32_t quantize(const float value) {
+  return static_cast<int32_t>(std::round(value / valhalla::baldr::QuantizedShapes::kPrecision));
+}
+
+// Squared distance from the origin to one segment, coordinates already
+// relative to the query point and scaled to meters
+inline float segment_distance(const float ax, const float ay, const float dx,
+                              const float dy) {
+  const float len2 = dx * dx + dy * dy;
+  float t = len2 > 0.0f ? -(ax * dx + ay * dy) / len2 : 0.0f;
+  t = std::min(std::max(t, 0.0f), 1.0f);
+  const float px = ax + t * dx, py = ay + t * dy;
+  return px * px + py * py;
+}
+
+}
+
+namespace valhalla {
+namespace baldr {
+
+// Squared distance from a query point to each segment of a run
+void squared_segment_distances(const int32_t* x, const int32_t* y,
+                               const uint32_t count, const int32_t qx,
+                               const int32_t qy, const float scale_x,
+                               const float scale_y, float* distances) {
+  uint32_t i = 0;
+#if defined(__AVX2__)
+  const __m256i vqx = _mm256_set1_epi32(qx), vqy = _mm256_set1_epi32(qy);
+  const __m256 vsx = _mm256_set1_ps(scale_x), vsy = _mm256_set1_ps(scale_y);
+  const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+  for (; i + 8 < count; i += 8) {
+    const __m256i xa = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+    const __m256i xb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i + 1));
+    const __m256i ya = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+    const __m256i yb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i + 1));
+    const __m256 ax = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(xa, vqx)), vsx);
+    const __m256 ay = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(ya, vqy)), vsy);
+    const __m256 dx = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(xb, xa)), vsx);
+    const __m256 dy = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(yb, ya)), vsy);
+    const __m256 len2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    const __m256 dot = _mm256_add_ps(_mm256_mul_ps(ax, dx), _mm256_mul_ps(ay, dy));
+    // Zero length segments divide by zero, the mask turns that into t = 0
+    __m256 t = _mm256_div_ps(_mm256_sub_ps(zero, dot), len2);
+    t = _mm256_and_ps(t, _mm256_cmp_ps(len2, zero, _CMP_GT_OQ));
+    t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+    const __m256 px = _mm256_add_ps(ax, _mm256_mul_ps(t, dx));
+    const __m256 py = _mm256_add_ps(ay, _mm256_mul_ps(t, dy));
+    _mm256_storeu_ps(distances + i, _mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py)));
+  }
+#elif defined(__SSE2__)
+  const __m128i vqx = _mm_set1_epi32(qx), vqy = _mm_set1_epi32(qy);
+  const __m128 vsx = _mm_set1_ps(scale_x), vsy = _mm_set1_ps(scale_y);
+  const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+  for (; i + 4 < count; i += 4) {
+    const __m128i xa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+    const __m128i xb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i + 1));
+    const __m128i ya = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+    const __m128i yb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i + 1));
+    const __m128 ax = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(xa, vqx)), vsx);
+    const __m128 ay = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(ya, vqy)), vsy);
+    const __m128 dx = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(xb, xa)), vsx);
+    const __m128 dy = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(yb, ya)), vsy);
+    const __m128 len2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    const __m128 dot = _mm_add_ps(_mm_mul_ps(ax, dx), _mm_mul_ps(ay, dy));
+    // Zero length segments divide by zero, the mask turns that into t = 0
+    __m128 t = _mm_div_ps(_mm_sub_ps(zero, dot), len2);
+    t = _mm_and_ps(t, _mm_cmpgt_ps(len2, zero));
+    t = _mm_min_ps(_mm_max_ps(t, zero), one);
+    const __m128 px = _mm_add_ps(ax, _mm_mul_ps(t, dx));
+    const __m128 py = _mm_add_ps(ay, _mm_mul_ps(t, dy));
+    _mm_storeu_ps(distances + i, _mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)));
+  }
+#endif
+  // Remaining segments (or all of them without SIMD)
+  for (; i + 1 < count; i++) {
+    distances[i] = segment_distance((x[i] - qx) * scale_x, (y[i] - qy) * scale_y,
+                                    (x[i + 1] - x[i]) * scale_x, (y[i + 1] - y[i]) * scale_y);
+  }
+}
+
+// Constructor given a tile, one shape per edge info
+QuantizedShapes::QuantizedShapes(const GraphTile& tile) {
+  std::vector<std::pair<uint32_t, std::vector<PointLL>>> shapes;
+  std::unordered_set<uint32_t> offsets;
+  for (const auto& edge : tile.GetDirectedEdges()) {
+    if (offsets.insert(edge.edgeinfo_offset()).second) {
+      shapes.emplace_back(edge.edgeinfo_offset(), std::vector<PointLL>());
+      tile.edgeinfo_ref(edge.edgeinfo_offset()).decode_shape(shapes.back().second);
+    }
+  }
+  build(std::move(shapes));
+}
+
+// Constructor given edge info offsets and shapes
+QuantizedShapes::QuantizedShapes(
+    const std::vector<std::pair<uint32_t, std::vector<PointLL>>>& shapes) {
+  build(shapes);
+}
+
+// Constructor given a previously built buffer
+QuantizedShapes::QuantizedShapes(const char* data, const size_t size) {
+  set_pointers(data, size);
+}
+
+// Build the buffer
+void QuantizedShapes::build(
+    std::vector<std::pair<uint32_t, std::vector<PointLL>>> shapes) {
+  std::sort(shapes.begin(), shapes.end(),
+            [](const std::pair<uint32_t, std::vector<PointLL>>& a,
+               const std::pair<uint32_t, std::vector<PointLL>>& b) {
+              return a.first < b.first;
+            });
+
+  // Origin is the lower left of all the points
+  uint32_t point_count = 0;
+  float minx = std::numeric_limits<float>::max(), miny = minx;
+  for (const auto& shape : shapes) {
+    point_count += shape.second.size();
+    for (const auto& p : shape.second) {
+      minx = std::min(minx, p.lng());
+      miny = std::min(miny, p.lat());
+    }
+  }
+  const int32_t origin_x = point_count > 0 ? quantize(minx) : 0;
+  const int32_t origin_y = point_count > 0 ? quantize(miny) : 0;
+
+  const uint32_t edge_count = shapes.size();
+  buffer_.resize(kHeaderSize + edge_count + (edge_count + 1) + 2 * point_count);
+  uint32_t* header = buffer_.data();
+  uint32_t* keys = header + kHeaderSize;
+  uint32_t* starts = keys + edge_count;
+  int32_t* x = reinterpret_cast<int32_t*>(starts + edge_count + 1);
+  int32_t* y = x + point_count;
+  header[0] = edge_count;
+  header[1] = point_count;
+  header[2] = static_cast<uint32_t>(origin_x);
+  header[3] = static_cast<uint32_t>(origin_y);
+
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < edge_count; i++) {
+    keys[i] = shapes[i].first;
+    starts[i] = n;
+    for (const auto& p : shapes[i].second) {
+      x[n] = quantize(p.lng()) - origin_x;
+      y[n] = quantize(p.lat()) - origin_y;
+      n++;
+    }
+  }
+  starts[edge_count] = n;
+  set_pointers(reinterpret_cast<const char*>(buffer_.data()),
+               buffer_.size() * sizeof(uint32_t));
+}
+
+// Set pointers to each section of the buffer
+void QuantizedShapes::set_pointers(const char* data, const size_t size) {
+  if (size < kHeaderSize * sizeof(uint32_t))
+    throw std::runtime_error("QuantizedShapes buffer is too small");
+  header_ = reinterpret_cast<const uint32_t*>(data);
+  const uint32_t edge_count = header_[0], point_count = header_[1];
+  if (size < (kHeaderSize + 2 * edge_count + 1 + 2 * point_count) * sizeof(uint32_t))
+    throw std::runtime_error("QuantizedShapes buffer is too small");
+  keys_ = header_ + kHeaderSize;
+  starts_ = keys_ + edge_count;
+  x_ = reinterpret_cast<const int32_t*>(starts_ + edge_count + 1);
+  y_ = x_ + point_count;
+  size_ = size;
+}
+
+// Get the buffer
+const char* QuantizedShapes::data() const {
+  return reinterpret_cast<const char*>(header_);
+}
+
+// Get the size of the buffer
+size_t QuantizedShapes::size() const {
+  return size_;
+}
+
+// Get the number of edge shapes
+uint32_t QuantizedShapes::edge_count() const {
+  return header_[0];
+}
+
+// Get the run of points of an edge shape
+QuantizedShapes::Run QuantizedShapes::shape(const uint32_t edgeinfo_offset) const {
+  uint32_t i = branchless_lower_bound(keys_, edge_count(),
+      [edgeinfo_offset](const uint32_t key) { return key < edgeinfo_offset; });
+  if (i == edge_count() || keys_[i] != edgeinfo_offset)
+    return { x_, y_, 0 };
+  return { x_ + starts_[i], y_ + starts_[i], starts_[i + 1] - starts_[i] };
+}
+
+// Get a point of a run
+PointLL QuantizedShapes::point(const Run& run, const uint32_t i) const {
+  const int32_t origin_x = static_cast<int32_t>(header_[2]);
+  const int32_t origin_y = static_cast<int32_t>(header_[3]);
+  return PointLL((origin_x + run.x[i]) * kPrecision, (origin_y + run.y[i]) * kPrecision);
+}
+
+// Find the closest segment of an edge to a point
+QuantizedShapes::Closest QuantizedShapes::closest(const uint32_t edgeinfo_offset,
+                                                  const PointLL& pt) const {
+  Closest result{ std::numeric_limits<float>::max(), 0 };
+  const Run run = shape(edgeinfo_offset);
+  if (run.count == 0)
+    return result;
+
+  // The query relative to the origin, moved by whole turns to within half a
+  // turn of it. Far away queries then fit in 32 bits and queries across the
+  // antimeridian are measured the short way around.
+  const int64_t turn = static_cast<int64_t>(std::round(360.0 / kPrecision));
+  int64_t dx = static_cast<int64_t>(quantize(pt.lng())) - static_cast<int32_t>(header_[2]);
+  dx -= turn * static_cast<int64_t>(std::floor(static_cast<double>(dx + turn / 2) / turn));
+  const int32_t qx = static_cast<int32_t>(dx);
+  const int32_t qy = quantize(pt.lat()) - static_cast<int32_t>(header_[3]);
+  const float scale_y = kMetersPerDegreeLat * kPrecision;
+  const float scale_x = scale_y * std::cos(pt.lat() * kRadPerDeg);
+
+  // A single point shape
+  if (run.count == 1) {
+    const float dx = (run.x[0] - qx) * scale_x, dy = (run.y[0] - qy) * scale_y;
+    result.distance = std::sqrt(dx * dx + dy * dy);
+    return result;
+  }
+
+  // Measure a chunk of segments at a time, chunks overlap by one point
+  float distances[kChunkSize];
+  float best = std::numeric_limits<float>::max();
+  for (uint32_t start = 0; start + 1 < run.count; start += kChunkSize) {
+    const uint32_t count = std::min(kChunkSize + 1, run.count - start);
+    squared_segment_distances(run.x + start, run.y + start, count, qx, qy,
+                              scale_x, scale_y, distances);
+    for (uint32_t i = 0; i + 1 < count; i++) {
+      if (distances[i] < best) {
+        best = distances[i];
+        result.segment = start + i;
+      }
+    }
+  }
+  result.distance = std::sqrt(best);
+  return result;
+}
+
+}
+}
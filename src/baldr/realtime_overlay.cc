@@ -0,0 +1,100 @@
+#include "baldr/realtime_overlay.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace valhalla {
+namespace baldr {
+
+// Get the delay of the trip's departure on a line
+int32_t TripUpdate::delay_at(const uint32_t lineid) const {
+  auto found = std::lower_bound(stop_delays.begin(), stop_delays.end(),
+                                std::make_pair(lineid, std::numeric_limits<int32_t>::min()));
+  return (found != stop_delays.end() && found->first == lineid) ? found->second : delay;
+}
+
+// Get the update of a trip
+const TripUpdate* RealtimeDelays::TileDelays::trip(const uint32_t tripid) const {
+  auto found = trips.find(tripid);
+  return found == trips.end() ? nullptr : &found->second;
+}
+
+// Adds the update of a trip and widens the tile's range of delays
+void RealtimeDelays::Add(const GraphId& tile, const uint32_t tripid,
+                         TripUpdate update) {
+  std::sort(update.stop_delays.begin(), update.stop_delays.end());
+  auto inserted = tiles_.emplace(tile.Tile_Base(), TileDelays{ {}, 0, 0 });
+  TileDelays& delays = inserted.first->second;
+  delays.min_delay = std::min(delays.min_delay, update.delay);
+  delays.max_delay = std::max(delays.max_delay, update.delay);
+  for (const auto& stop : update.stop_delays) {
+    delays.min_delay = std::min(delays.min_delay, stop.second);
+    delays.max_delay = std::max(delays.max_delay, stop.second);
+  }
+  delays.trips[tripid] = std::move(update);
+}
+
+// Get the trip updates of a tile
+const RealtimeDelays::TileDelays* RealtimeDelays::tile(const GraphId& tile) const {
+  auto found = tiles_.find(tile.Tile_Base());
+  return found == tiles_.end() ? nullptr : &found->second;
+}
+
+// Counts the reader in the current epoch and reads the current updates.
+// If the epoch moves on before the reader is counted, a publisher may
+// already be past waiting for that epoch's readers, so count it again.
+RealtimeOverlay::Reader::Reader(const RealtimeOverlay* overlay)
+    : readers_(nullptr), current_(nullptr) {
+  if (overlay == nullptr)
+    return;
+  uint64_t epoch = overlay->epoch_.load();
+  while (true) {
+    readers_ = &overlay->readers_[epoch & 1];
+    readers_->fetch_add(1);
+    const uint64_t now = overlay->epoch_.load();
+    if (now == epoch)
+      break;
+    readers_->fetch_sub(1);
+    epoch = now;
+  }
+  current_ = overlay->current_.load();
+}
+
+RealtimeOverlay::Reader::~Reader() {
+  if (readers_ != nullptr)
+    readers_->fetch_sub(1);
+}
+
+// Constructor with no updates
+RealtimeOverlay::RealtimeOverlay()
+    : current_(new std::shared_ptr<const RealtimeDelays>()), epoch_(0) {
+  readers_[0] = 0;
+  readers_[1] = 0;
+}
+
+RealtimeOverlay::~RealtimeOverlay() {
+  delete current_.load();
+}
+
+// Swaps in a new batch of updates. A reader that saw the old batch started
+// before the swap, so it is counted in the previous epoch: once that count
+// drains the old batch can be dropped. Readers holding a shared copy of it
+// keep it until they are done with it.
+void RealtimeOverlay::Publish(std::shared_ptr<const RealtimeDelays> delays) {
+  std::lock_guard<std::mutex> lock(publish_mutex_);
+  auto previous = current_.exchange(new std::shared_ptr<const RealtimeDelays>(std::move(delays)));
+  const uint64_t epoch = epoch_.fetch_add(1);
+  while (readers_[epoch & 1].load() != 0)
+    std::this_thread::yield();
+  delete previous;
+}
+
+// Get the current updates
+std::shared_ptr<const RealtimeDelays> RealtimeOverlay::delays() const {
+  Reader reader(this);
+  return *reader.current_;
+}
+
+}
+}
@@ -0,0 +1,50 @@
+#include "baldr/record_index.h"
+
+namespace {
+
+// Number of set bits in a word
+inline uint32_t popcount(const uint64_t word) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(word);
+#else
+  uint64_t v = word - ((word >> 1) & 0x5555555555555555ULL);
+  v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+  v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<uint32_t>((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+}
+
+namespace valhalla {
+namespace baldr {
+
+// Get the first record of a key and one past its last
+std::pair<uint32_t, uint32_t> RecordIndex::range(const uint32_t key) const {
+  if (!has(key))
+    return std::make_pair(count_, count_);
+
+  // Entry of this key is the number of keys with records before it
+  const uint32_t word = key / 64;
+  const uint64_t below = bits_[word] & ((uint64_t(1) << (key % 64)) - 1);
+  const uint32_t rank = ranks_[word] + popcount(below);
+  return std::make_pair(starts_[rank], starts_[rank + 1]);
+}
+
+// Get the number of distinct keys with records
+uint32_t RecordIndex::key_count() const {
+  return starts_.empty() ? 0 : starts_.size() - 1;
+}
+
+// Running count of set bits before each word
+void RecordIndex::finish() {
+  ranks_.resize(bits_.size());
+  uint32_t rank = 0;
+  for (size_t i = 0; i < bits_.size(); ++i) {
+    ranks_[i] = rank;
+    rank += popcount(bits_[i]);
+  }
+}
+
+}
+}
@@ -0,0 +1,19 @@
+#include "baldr/tile_ranges.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace valhalla {
+namespace baldr {
+
+// Throws for a node whose edges are outside the tile
+void NodeEdgesRange::edges_out_of_bounds(const uint32_t id, const uint32_t first,
+                                         const uint32_t count) const {
+  throw std::runtime_error("NodeEdgesRange node " + std::to_string(id) +
+                           " has edges " + std::to_string(first) + " to " +
+                           std::to_string(first + count) + " directededgecount= " +
+                           std::to_string(edge_count_));
+}
+
+}
+}
@@ -0,0 +1,82 @@
+#include "baldr/tile_statistics.h"
+#include "baldr/graphtile.h"
+
+namespace valhalla {
+namespace baldr {
+
+// Constructor with all counts 0
+TileStatistics::TileStatistics()
+    : tile_count(0), tile_bytes(0), node_count(0), edge_count(0),
+      shortcut_count(0), transit_line_count(0), length(0), edgeinfo_bytes(0),
+      textlist_bytes(0), sign_count(0), restriction_count(0),
+      departure_count(0) {
+  edges_by_class.fill(0);
+  length_by_class.fill(0);
+  edges_by_use.fill(0);
+  forward_access.fill(0);
+  reverse_access.fill(0);
+}
+
+// Computes the statistics of a tile in one pass over its directed edges
+TileStatistics::TileStatistics(const GraphTile& tile)
+    : TileStatistics() {
+  if (tile.header_ == nullptr)
+    return;
+
+  const GraphTileHeader* header = tile.header();
+  tile_count = 1;
+  tile_bytes = tile.size();
+  node_count = header->nodecount();
+  edgeinfo_bytes = tile.edgeinfo_size_;
+  textlist_bytes = tile.textlist_size_;
+  sign_count = header->signcount();
+  restriction_count = header->access_restriction_count();
+  departure_count = header->departurecount();
+
+  for (const auto& edge : tile.GetDirectedEdges()) {
+    const uint32_t rc = static_cast<uint32_t>(edge.classification());
+    edge_count++;
+    shortcut_count += edge.is_shortcut();
+    transit_line_count += edge.IsTransitLine();
+    length += edge.length();
+    edges_by_class[rc]++;
+    length_by_class[rc] += edge.length();
+    edges_by_use[static_cast<uint32_t>(edge.use()) % kUseCount]++;
+    const uint32_t forward = edge.forwardaccess();
+    const uint32_t reverse = edge.reverseaccess();
+    for (uint32_t mode = 0; mode < kAccessModeCount; mode++) {
+      forward_access[mode] += (forward >> mode) & 1;
+      reverse_access[mode] += (reverse >> mode) & 1;
+    }
+  }
+}
+
+// Adds the statistics of other tiles
+TileStatistics& TileStatistics::operator+=(const TileStatistics& other) {
+  tile_count += other.tile_count;
+  tile_bytes += other.tile_bytes;
+  node_count += other.node_count;
+  edge_count += other.edge_count;
+  shortcut_count += other.shortcut_count;
+  transit_line_count += other.transit_line_count;
+  length += other.length;
+  edgeinfo_bytes += other.edgeinfo_bytes;
+  textlist_bytes += other.textlist_bytes;
+  sign_count += other.sign_count;
+  restriction_count += other.restriction_count;
+  departure_count += other.departure_count;
+  for (size_t i = 0; i < edges_by_class.size(); i++) {
+    edges_by_class[i] += other.edges_by_class[i];
+    length_by_class[i] += other.length_by_class[i];
+  }
+  for (size_t i = 0; i < edges_by_use.size(); i++)
+    edges_by_use[i] += other.edges_by_use[i];
+  for (size_t i = 0; i < kAccessModeCount; i++) {
+    forward_access[i] += other.forward_access[i];
+    reverse_access[i] += other.reverse_access[i];
+  }
+  return *this;
+}
+
+}
+}
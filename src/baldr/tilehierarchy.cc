@@ -1,6 +1,9 @@
 #include "baldr/tilehierarchy.h"
 #include "baldr/graphtileheader.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace valhalla::midgard;
 
 namespace valhalla {
@@ -33,6 +36,66 @@ GraphId TileHierarchy::GetGraphId(const midgard::PointLL& pointll, const unsigne
   return id;
 }
 
+std::vector<GraphId> TileHierarchy::GetGraphIds(const AABB2<PointLL>& bbox,
+                                                const uint8_t level) const {
+  std::vector<GraphId> ids;
+  const auto& tl = levels_.find(level);
+  if(tl == levels_.end())
+    return ids;
+
+  //a box crossing the antimeridian (minx > maxx or past +/-180) is split
+  //into the part west of it and the part east of it
+  float minx = bbox.minx(), maxx = bbox.maxx();
+  if(minx > maxx)
+    maxx += 360.f;
+  std::vector<std::pair<float, float>> spans;
+  if(maxx - minx >= 360.f) {
+    spans.emplace_back(-180.f, 180.f);
+  }
+  else {
+    const float shift = std::floor((minx + 180.f) / 360.f) * 360.f;
+    minx -= shift;
+    maxx -= shift;
+    if(maxx > 180.f)
+      spans.emplace_back(-180.f, maxx - 360.f);
+    spans.emplace_back(minx, std::min(maxx, 180.f));
+  }
+
+  //clamp the corners inside the world so they always map to a tile
+  const auto clamp = [](float v, float lo, float hi) {
+    return std::max(lo, std::min(v, hi));
+  };
+  const auto& tiles = tl->second.tiles;
+  const auto rc = [&tiles, &clamp](float x, float y) {
+    return tiles.GetRowColumn(tiles.TileId(
+        PointLL(clamp(x, -180.f, 179.99999f), clamp(y, -90.f, 89.99999f))));
+  };
+  std::vector<std::pair<int32_t, int32_t>> cols;
+  int32_t minrow = 0, maxrow = 0;
+  for(const auto& span : spans) {
+    auto minrc = rc(span.first, bbox.miny());
+    auto maxrc = rc(span.second, bbox.maxy());
+    minrow = minrc.first;
+    maxrow = maxrc.first;
+    //both parts may reach into the same column when the box is almost as
+    //wide as the world
+    if(!cols.empty() && minrc.second <= cols.back().second)
+      cols.back().second = tiles.ncolumns() - 1;
+    else
+      cols.emplace_back(minrc.second, maxrc.second);
+  }
+
+  //every tile between the corners, row major
+  for(int32_t row = minrow; row <= maxrow; ++row) {
+    for(const auto& range : cols) {
+      for(int32_t col = range.first; col <= range.second; ++col) {
+        ids.emplace_back(row * tiles.ncolumns() + col, level, 0);
+      }
+    }
+  }
+  return ids;
+}
+
 // Gets the hierarchy level given the road class.
 uint8_t TileHierarchy::get_level(const RoadClass roadclass) const {
   if (roadclass <= levels_.find(0)->second.importance) {
@@ -0,0 +1,73 @@
+#include "baldr/transfer_index.h"
+#include "baldr/sorted_lookup.h"
+
+#include <algorithm>
+
+namespace valhalla {
+namespace baldr {
+
+namespace {
+
+// Copy of the transfers sorted by from stop Id then to stop Id
+std::vector<TransitTransfer> sorted(const TransitTransfer* transfers,
+                                    const uint32_t count) {
+  std::vector<TransitTransfer> copy(transfers, transfers + count);
+  std::stable_sort(copy.begin(), copy.end());
+  return copy;
+}
+
+}
+
+constexpr uint32_t TransferIndex::kNotPossible;
+
+// Constructor. Sorts a copy of the transfers and indexes them by from stop.
+TransferIndex::TransferIndex(const TransitTransfer* transfers,
+                             const uint32_t count)
+    : transfers_(sorted(transfers, count)),
+      index_(transfers_.data(), count,
+             [](const TransitTransfer& transfer) { return transfer.from_stopid(); }) {
+}
+
+// Get all transfers from a stop
+midgard::iterable_t<const TransitTransfer> TransferIndex::from(
+    const uint32_t stopid) const {
+  auto range = index_.range(stopid);
+  return midgard::iterable_t<const TransitTransfer>(
+      transfers_.data() + range.first, transfers_.data() + range.second);
+}
+
+// Get the transfer between two stops
+const TransitTransfer* TransferIndex::find(const uint32_t from_stopid,
+                                           const uint32_t to_stopid) const {
+  auto transfers = from(from_stopid);
+  const uint32_t found = branchless_lower_bound(transfers.begin(), transfers.size(),
+      [to_stopid](const TransitTransfer& t) { return t.to_stopid() < to_stopid; });
+  if (found < transfers.size() && transfers.begin()[found].to_stopid() == to_stopid)
+    return transfers.begin() + found;
+  return nullptr;
+}
+
+// Get the minimum time to transfer between two stops
+uint32_t TransferIndex::min_transfer_time(const uint32_t from_stopid,
+                                          const uint32_t to_stopid,
+                                          const uint32_t default_time) const {
+  const TransitTransfer* transfer = find(from_stopid, to_stopid);
+  if (transfer == nullptr)
+    return default_time;
+  switch (transfer->type()) {
+    case TransferType::kMinTime:
+      return transfer->mintime();
+    case TransferType::kNotPossible:
+      return kNotPossible;
+    default:
+      return 0;
+  }
+}
+
+// Get the number of transfers
+uint32_t TransferIndex::size() const {
+  return transfers_.size();
+}
+
+}
+}
@@ -0,0 +1,71 @@
+#include "baldr/trip_index.h"
+#include "baldr/sorted_lookup.h"
+
+#include <algorithm>
+
+namespace valhalla {
+namespace baldr {
+
+namespace {
+
+// (Id, time, index) of each departure, skipping those whose Id is 0 if asked
+template <class id_t>
+std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> keyed(
+    const TransitDeparture* departures, const uint32_t count, const id_t& id,
+    const bool skip_zero) {
+  std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> keys;
+  keys.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const uint32_t key = id(departures[i]);
+    if (key != 0 || !skip_zero)
+      keys.emplace_back(key, departures[i].departure_time(), i);
+  }
+  return keys;
+}
+
+}
+
+// Constructor. Groups the departures by trip and by block.
+TripIndex::TripIndex(const TransitDeparture* departures, const uint32_t count)
+    : trips_(keyed(departures, count,
+                   [](const TransitDeparture& d) { return d.tripid(); }, false)),
+      blocks_(keyed(departures, count,
+                    [](const TransitDeparture& d) { return d.blockid(); }, true)) {
+}
+
+// Get the departures of a trip
+TripIndex::positions_t TripIndex::trip(const uint32_t tripid) const {
+  return trips_.find(tripid);
+}
+
+// Get the departures of a block
+TripIndex::positions_t TripIndex::block(const uint32_t blockid) const {
+  return blockid == 0 ? positions_t(blocks_.positions.data(), size_t(0))
+                      : blocks_.find(blockid);
+}
+
+// Sorts the departures by Id then time and lays them out flat
+TripIndex::Groups::Groups(std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> keyed) {
+  std::sort(keyed.begin(), keyed.end());
+  positions.reserve(keyed.size());
+  for (size_t i = 0; i < keyed.size(); i++) {
+    if (i == 0 || std::get<0>(keyed[i]) != std::get<0>(keyed[i - 1])) {
+      ids.push_back(std::get<0>(keyed[i]));
+      starts.push_back(positions.size());
+    }
+    positions.push_back(std::get<2>(keyed[i]));
+  }
+  starts.push_back(positions.size());
+}
+
+// Get the departures with an Id
+TripIndex::positions_t TripIndex::Groups::find(const uint32_t id) const {
+  const uint32_t found = branchless_lower_bound(ids.data(), ids.size(),
+      [id](const uint32_t i) { return i < id; });
+  if (found < ids.size() && ids[found] == id)
+    return positions_t(positions.data() + starts[found], positions.data() + starts[found + 1]);
+  return positions_t(positions.data(), size_t(0));
+}
+
+}
+}
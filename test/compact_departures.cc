@@ -0,0 +1,134 @@
+#include "test.h"
+
+#include "baldr/compact_departures.h"
+#include "baldr/departure_table.h"
+
+#include <random>
+#include <vector>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// Lines running mostly at a fixed headway with consecutive trips, and some
+// irregular departures with other schedules and flags mixed in
+std::vector<TransitDeparture> make_departures(std::mt19937& gen, const uint32_t lines,
+                                              const uint32_t per_line) {
+  std::uniform_int_distribution<uint32_t> coin(0, 9), jitter(1, 900), schedule(0, 3);
+  std::vector<TransitDeparture> departures;
+  uint32_t tripid = 1000;
+  for (uint32_t line = 1; line <= lines; ++line) {
+    uint32_t time = 18000;
+    for (uint32_t i = 0; i < per_line; ++i) {
+      const bool irregular = coin(gen) == 0;
+      time += irregular ? jitter(gen) : 300;
+      departures.emplace_back(line * 3, irregular ? tripid + 50000 : tripid++, line % 7, line,
+                              100 + line, time, 120, irregular ? schedule(gen) : 0,
+                              !irregular || coin(gen) < 5, irregular && coin(gen) < 5);
+    }
+  }
+  return departures;
+}
+
+bool same(const CompactDepartures::Fields& f, const TransitDeparture& d) {
+  return f.lineid == d.lineid() && f.tripid == d.tripid() && f.routeid == d.routeid() &&
+         f.blockid == d.blockid() && f.headsign_offset == d.headsign_offset() &&
+         f.departure_time == d.departure_time() && f.elapsed_time == d.elapsed_time() &&
+         f.schedule_index == d.schedule_index() &&
+         f.wheelchair_accessible == d.wheelchair_accessible() &&
+         f.bicycle_accessible == d.bicycle_accessible();
+}
+
+void round_trip() {
+  std::mt19937 gen(19);
+  for (uint32_t per_line : { 0u, 1u, 2u, 5u, 200u }) {
+    auto departures = make_departures(gen, 20, per_line);
+    CompactDepartures compact(departures.data(), departures.size());
+    CompactDepartures loaded(compact.data());
+    if (compact.size() != departures.size() || loaded.size() != departures.size())
+      throw std::logic_error("Wrong number of departures");
+    //every line decodes to the same departures, in order
+    uint32_t i = 0;
+    for (uint32_t lineid = 0; lineid <= 63; ++lineid) {
+      for (const auto& f : loaded.line(lineid)) {
+        if (i >= departures.size() || !same(f, departures[i]) ||
+            f.departure().tripid() != departures[i].tripid())
+          throw std::logic_error("Decoded departure should match");
+        ++i;
+      }
+    }
+    if (i != departures.size())
+      throw std::logic_error("Every departure should be decoded");
+  }
+
+  //unsorted departures and truncated data are rejected
+  std::vector<TransitDeparture> unsorted = {
+    {1, 1, 0, 0, 0, 200, 60, 0, false, false}, {1, 2, 0, 0, 0, 100, 60, 0, false, false}
+  };
+  try {
+    CompactDepartures compact(unsorted.data(), unsorted.size());
+    throw std::logic_error("Unsorted departures should throw");
+  } catch (const std::runtime_error&) {}
+  std::mt19937 gen2(23);
+  auto departures = make_departures(gen2, 3, 10);
+  std::string data = CompactDepartures(departures.data(), departures.size()).data();
+  try {
+    CompactDepartures loaded(data.substr(0, data.size() - 1));
+    throw std::logic_error("Truncated data should throw");
+  } catch (const std::runtime_error&) {}
+}
+
+void next_departure() {
+  std::mt19937 gen(29);
+  std::vector<TransitSchedule> schedules = {
+    {0, kAllDaysOfWeek, 0}, {0, kSaturday, 0}, {0, kMonday | kTuesday, 0}, {0, 0, 0}
+  };
+  auto departures = make_departures(gen, 10, 150);
+  CompactDepartures compact(departures.data(), departures.size());
+  DepartureTable table(departures.data(), departures.size(), schedules.data(), schedules.size());
+  auto active = table.active_schedules(10, kMonday, false);
+  auto valid = table.valid_on(10, kMonday, false);
+  for (uint32_t lineid = 3; lineid <= 30; lineid += 3) {
+    //departures of the line in the table, as GraphTile::GetNextDeparture finds them
+    uint32_t begin = 0;
+    while (departures[begin].lineid() != lineid)
+      ++begin;
+    const uint32_t end = begin + 150;
+    for (uint32_t time = 18000; time < 70000; time += 777) {
+      for (int flags = 0; flags < 4; ++flags) {
+        const uint32_t expected = table.next_valid(table.lower_bound(begin, end, time), end,
+                                                   *valid, flags & 1, flags & 2);
+        CompactDepartures::Fields found;
+        const bool has = compact.next_departure(lineid, time, *active, flags & 1, flags & 2, found);
+        if (has != (expected < end) || (has && !same(found, departures[expected])))
+          throw std::logic_error("Next departure should match");
+      }
+    }
+  }
+  CompactDepartures::Fields found;
+  if (compact.next_departure(4, 0, *active, false, false, found))
+    throw std::logic_error("Line without departures should have none");
+}
+
+void size() {
+  //a busy metro tile encodes to a fraction of its departure records
+  std::mt19937 gen(31);
+  auto departures = make_departures(gen, 400, 250);
+  CompactDepartures compact(departures.data(), departures.size());
+  if (compact.data().size() * 4 > departures.size() * sizeof(TransitDeparture))
+    throw std::logic_error("Compact departures should be much smaller");
+}
+
+}
+
+int main() {
+  test::suite suite("compact_departures");
+
+  suite.test(TEST_CASE(round_trip));
+
+  suite.test(TEST_CASE(next_departure));
+
+  suite.test(TEST_CASE(size));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,214 @@
+#include "test.h"
+#include <vector>
+#include <queue>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <functional>
+#include "config.h"
+#include "baldr/concurrent_bucket_queue.h"
+
+using namespace std;
+using namespace valhalla::baldr;
+
+namespace {
+
+uint32_t thread_count() {
+  uint32_t n = std::thread::hardware_concurrency();
+  return n < 2 ? 2 : (n > 8 ? 8 : n);
+}
+
+void run_threads(const uint32_t count, const std::function<void(uint32_t)>& f) {
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < count; i++)
+    threads.emplace_back(f, i);
+  for (auto& t : threads)
+    t.join();
+}
+
+void TestRelax() {
+  // Many threads race to lower the same costs, the lowest must win
+  AtomicLabelCosts costs(100);
+  run_threads(thread_count(), [&costs](uint32_t t) {
+    for (uint32_t c = 1000; c > 0; c--)
+      for (uint32_t label = 0; label < costs.size(); label++)
+        costs.relax(label, static_cast<float>(c + t + label));
+  });
+  for (uint32_t label = 0; label < costs.size(); label++) {
+    if (costs.cost(label) != static_cast<float>(1 + label))
+      throw runtime_error("TestRelax: lowest cost did not win");
+  }
+  if (costs.relax(0, 5.0f) || !costs.relax(0, 0.5f))
+    throw runtime_error("TestRelax: relax returned the wrong result");
+}
+
+void TestStress() {
+  // Threads add and pop concurrently, every label must come out exactly once
+  const uint32_t nthreads = thread_count();
+  const uint32_t perthread = 20000;
+  std::vector<float> labelcosts(nthreads * perthread);
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<uint32_t> dist(0, 50000);
+  for (auto& c : labelcosts)
+    c = dist(gen);
+  const auto labelcost = [&labelcosts](const uint32_t label) {
+    return labelcosts[label];
+  };
+
+  ConcurrentBucketQueue queue(nthreads * 2, 0, 10000, 5, labelcost);
+  std::vector<std::atomic<uint32_t>> popped(labelcosts.size());
+  for (auto& p : popped)
+    p.store(0);
+  std::atomic<uint32_t> remaining(labelcosts.size());
+
+  run_threads(nthreads, [&](uint32_t t) {
+    for (uint32_t i = 0; i < perthread; i++) {
+      uint32_t label = t * perthread + i;
+      queue.add(label, labelcosts[label]);
+      // Interleave pops with the adds
+      if (i % 2 == 1) {
+        label = queue.pop();
+        if (label != kInvalidLabel) {
+          popped[label]++;
+          remaining--;
+        }
+      }
+    }
+    while (remaining.load() > 0) {
+      uint32_t label = queue.pop();
+      if (label != kInvalidLabel) {
+        popped[label]++;
+        remaining--;
+      }
+    }
+  });
+
+  for (const auto& p : popped) {
+    if (p.load() != 1)
+      throw runtime_error("TestStress: label was not popped exactly once");
+  }
+  if (queue.pop() != kInvalidLabel)
+    throw runtime_error("TestStress: queue should be empty");
+}
+
+void TestStaleOverflow() {
+  // A label added beyond the bucket range sits in an overflow bucket. When
+  // it improves it is added again and the stale entry stays behind with a
+  // live cost below the range it is moved into. Both entries must drain.
+  AtomicLabelCosts costs(3);
+  ConcurrentBucketQueue queue(2, 0, 100, 5, costs.labelcost());
+  costs.relax(0, 10.0f);
+  queue.add(0, 10.0f);
+  costs.relax(1, 500.0f);
+  queue.add(1, 500.0f);
+  costs.relax(2, 700.0f);
+  queue.add(2, 700.0f);
+  costs.relax(1, 50.0f);
+  queue.add(1, 50.0f);
+
+  std::vector<uint32_t> popped(costs.size());
+  for (uint32_t label = queue.pop(); label != kInvalidLabel; label = queue.pop())
+    popped[label]++;
+  if (popped[0] != 1 || popped[1] != 2 || popped[2] != 1)
+    throw runtime_error("TestStaleOverflow: every entry should be popped once");
+}
+
+// Grid graph with random edge weights. Node index is row * dim + column.
+struct grid_t {
+  uint32_t dim;
+  std::vector<float> weights;   // weight of entering each node
+  grid_t(const uint32_t d) : dim(d), weights(d * d) {
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<uint32_t> dist(1, 20);
+    for (auto& w : weights)
+      w = dist(gen);
+  }
+  template <class visitor_t>
+  void neighbors(const uint32_t n, const visitor_t& v) const {
+    uint32_t r = n / dim, c = n % dim;
+    if (c > 0) v(n - 1);
+    if (c + 1 < dim) v(n + 1);
+    if (r > 0) v(n - dim);
+    if (r + 1 < dim) v(n + dim);
+  }
+};
+
+std::vector<float> sequential(const grid_t& grid) {
+  std::vector<float> costs(grid.weights.size(), std::numeric_limits<float>::infinity());
+  using entry_t = std::pair<float, uint32_t>;
+  std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> pq;
+  costs[0] = 0.0f;
+  pq.emplace(0.0f, 0);
+  while (!pq.empty()) {
+    auto e = pq.top();
+    pq.pop();
+    if (e.first > costs[e.second])
+      continue;
+    grid.neighbors(e.second, [&](uint32_t n) {
+      float c = e.first + grid.weights[n];
+      if (c < costs[n]) {
+        costs[n] = c;
+        pq.emplace(c, n);
+      }
+    });
+  }
+  return costs;
+}
+
+std::vector<float> parallel(const grid_t& grid, const uint32_t nthreads) {
+  AtomicLabelCosts costs(grid.weights.size());
+  ConcurrentBucketQueue queue(nthreads * 2, 0, 10000, 5, costs.labelcost());
+  std::atomic<uint32_t> pending(1);
+  costs.relax(0, 0.0f);
+  queue.add(0, 0.0f);
+
+  run_threads(nthreads, [&](uint32_t) {
+    while (pending.load() > 0) {
+      uint32_t label = queue.pop();
+      if (label == kInvalidLabel) {
+        std::this_thread::yield();
+        continue;
+      }
+      float cost = costs.cost(label);
+      grid.neighbors(label, [&](uint32_t n) {
+        if (costs.relax(n, cost + grid.weights[n])) {
+          pending++;
+          queue.add(n, cost + grid.weights[n]);
+        }
+      });
+      pending--;
+    }
+  });
+
+  std::vector<float> result(grid.weights.size());
+  for (uint32_t i = 0; i < result.size(); i++)
+    result[i] = costs.cost(i);
+  return result;
+}
+
+void TestParallel() {
+  // Parallel expansion must give the same costs as a sequential one with
+  // any number of threads
+  grid_t grid(300);
+  auto expected = sequential(grid);
+  for (uint32_t n = 1; n <= thread_count(); n *= 2) {
+    if (parallel(grid, n) != expected)
+      throw runtime_error("TestParallel: parallel costs do not match");
+  }
+}
+
+}
+
+int main() {
+  test::suite suite("concurrentbucketqueue");
+
+  suite.test(TEST_CASE(TestRelax));
+
+  suite.test(TEST_CASE(TestStress));
+
+  suite.test(TEST_CASE(TestStaleOverflow));
+
+  suite.test(TEST_CASE(TestParallel));
+
+  return suite.tear_down();
+}
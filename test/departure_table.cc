@@ -0,0 +1,235 @@
+#include "test.h"
+
+#include "baldr/departure_table.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// One line of departures at a fixed interval with random schedules and flags
+std::vector<TransitDeparture> make_departures(std::mt19937& gen, const uint32_t count,
+                                              const uint32_t schedule_count,
+                                              const uint32_t interval = 60) {
+  std::uniform_int_distribution<uint32_t> schedule(0, schedule_count - 1), coin(0, 1);
+  std::vector<TransitDeparture> departures;
+  for (uint32_t i = 0; i < count; ++i)
+    departures.emplace_back(1, i, 0, 0, 0, i * interval, 60, schedule(gen), coin(gen), coin(gen));
+  return departures;
+}
+
+// First valid departure at or after a time: a binary search on time then
+// a schedule check per departure
+uint32_t naive(const std::vector<TransitDeparture>& departures,
+               const std::vector<TransitSchedule>& schedules, const uint32_t time,
+               const uint32_t day, const uint32_t dow, const bool wheelchair,
+               const bool bicycle) {
+  auto first = std::lower_bound(departures.begin(), departures.end(), time,
+      [](const TransitDeparture& d, const uint32_t t) { return d.departure_time() < t; });
+  for (uint32_t i = first - departures.begin(); i < departures.size(); ++i) {
+    const auto& d = departures[i];
+    if (schedules[d.schedule_index()].IsValid(day, dow, false) &&
+        (!wheelchair || d.wheelchair_accessible()) && (!bicycle || d.bicycle_accessible()))
+      return i;
+  }
+  return departures.size();
+}
+
+void next_valid() {
+  std::mt19937 gen(11);
+  //a schedule valid on day 0 only, every other day, weekends and never
+  std::vector<TransitSchedule> schedules = {
+    {1, 0, 63}, {0x5555555555555555ULL, 0, 63}, {0, kSaturday | kSunday, 0}, {0, 0, 63}
+  };
+  for (uint32_t count : { 0u, 1u, 63u, 64u, 65u, 500u }) {
+    auto departures = make_departures(gen, count, schedules.size());
+    DepartureTable table(departures.data(), count, schedules.data(), schedules.size());
+    for (uint32_t day = 0; day < 3; ++day) {
+      auto valid = table.valid_on(day, kMonday, false);
+      for (uint32_t time = 0; time <= count * 60 + 60; time += 45) {
+        for (int flags = 0; flags < 4; ++flags) {
+          uint32_t found = table.next_valid(table.lower_bound(0, count, time), count,
+                                            *valid, flags & 1, flags & 2);
+          if (found != naive(departures, schedules, time, day, kMonday, flags & 1, flags & 2))
+            throw std::logic_error("Wrong next valid departure");
+          //the same without the day's validity bitmap
+          if (table.next_valid_on(table.lower_bound(0, count, time), count, day, kMonday,
+                                  false, flags & 1, flags & 2) != found)
+            throw std::logic_error("Wrong next valid departure without a bitmap");
+        }
+      }
+    }
+  }
+}
+
+void day_cache() {
+  std::vector<TransitSchedule> schedules = { {1, 0, 63} };
+  std::vector<TransitDeparture> departures = { {1, 1, 0, 0, 0, 60, 60, 0, false, false} };
+  DepartureTable table(departures.data(), 1, schedules.data(), 1);
+  auto day0 = table.valid_on(0, kMonday, false);
+  if(table.valid_on(0, kMonday, false) != day0 || (*day0)[0] != 1 ||
+     (*table.valid_on(1, kTuesday, false))[0] != 0)
+    throw std::logic_error("Wrong cached validity");
+  //a day dropped from the cache is recomputed the same
+  for (uint32_t day = 1; day <= DepartureTable::kCachedDays; ++day)
+    table.valid_on(day, kMonday, false);
+  auto again = table.valid_on(0, kMonday, false);
+  if(again == day0 || *again != *day0)
+    throw std::logic_error("Recomputed validity should match");
+}
+
+void active_schedules() {
+  //more schedules than fit in one word
+  std::vector<TransitSchedule> schedules;
+  for (uint32_t i = 0; i < 100; ++i)
+    schedules.emplace_back(1ULL << (i % 64), 1 << (i % 7), i % 2 ? 63 : 0);
+  std::vector<TransitDeparture> departures = { {1, 1, 0, 0, 0, 60, 60, 99, false, false} };
+  DepartureTable table(departures.data(), 1, schedules.data(), schedules.size());
+  const uint8_t dows[] = { kSunday, kWednesday, kSaturday };
+  for (uint32_t day = 0; day < 64; day += 3) {
+    for (uint8_t dow : dows) {
+      auto active = table.active_schedules(day, dow, false);
+      for (uint32_t i = 0; i < schedules.size(); ++i)
+        if (DepartureTable::test(*active, i) != schedules[i].IsValid(day, dow, false))
+          throw std::logic_error("Wrong active schedule");
+      if (DepartureTable::test(*table.valid_on(day, dow, false), 0) != schedules[99].IsValid(day, dow, false))
+        throw std::logic_error("Wrong departure validity");
+    }
+  }
+  //the same day is computed once
+  auto active = table.active_schedules(70, kMonday, true);
+  if (table.active_schedules(70, kMonday, true) != active)
+    throw std::logic_error("Active schedules should be cached");
+}
+
+void active_days() {
+  //line 1 runs every other day, line 2 on weekends after the schedule ends
+  std::vector<TransitSchedule> schedules = {
+    {0x5555555555555555ULL, 0, 63}, {0, kSaturday | kSunday, 0}, {0, 0, 63}
+  };
+  std::vector<TransitDeparture> departures = {
+    {1, 10, 0, 0, 0, 60, 60, 0, false, false},
+    {1, 11, 0, 0, 0, 120, 60, 2, false, false},
+    {2, 20, 0, 0, 0, 60, 60, 1, false, false}
+  };
+  DepartureTable table(departures.data(), departures.size(), schedules.data(), schedules.size());
+  //a line may run on any day one of its departures is valid
+  const uint8_t dows[] = { kSunday, kMonday, kSaturday };
+  for (uint32_t day = 0; day < 70; ++day) {
+    for (uint8_t dow : dows) {
+      for (bool before : { false, true }) {
+        auto valid = table.valid_on(day, dow, before);
+        for (uint32_t i = 0; i < departures.size(); ++i) {
+          if (((*valid)[0] >> i & 1) &&
+              !table.active_days(departures[i].lineid()).may_run(day, dow, before))
+            throw std::logic_error("Line should be active");
+        }
+      }
+    }
+  }
+  if (table.active_days(1).may_run(1, kMonday, false) ||
+      table.active_days(2).may_run(0, kMonday, false) ||
+      table.active_days(3).may_run(0, kSunday, false))
+    throw std::logic_error("Line should not be active");
+}
+
+void windows() {
+  std::mt19937 gen(7);
+  std::vector<TransitSchedule> schedules = {
+    {1, 0, 63}, {0x5555555555555555ULL, 0, 63}, {0, kSaturday | kSunday, 0}
+  };
+  auto departures = make_departures(gen, 300, schedules.size());
+  DepartureTable table(departures.data(), departures.size(), schedules.data(), schedules.size());
+  auto valid = table.valid_on(1, kMonday, false);
+  for (uint32_t start = 0; start < 300 * 60; start += 1234) {
+    for (uint32_t end : { start, start + 59, start + 600, 300u * 60 }) {
+      //every valid departure in the window, in order
+      std::vector<uint32_t> expected;
+      for (uint32_t i = 0; i < departures.size(); ++i) {
+        const auto& d = departures[i];
+        if (d.departure_time() >= start && d.departure_time() <= end &&
+            schedules[d.schedule_index()].IsValid(1, kMonday, false) && d.wheelchair_accessible())
+          expected.push_back(i);
+      }
+      DepartureWindow window(table, table.lower_bound(0, departures.size(), start),
+                             table.upper_bound(0, departures.size(), end), valid, true, false);
+      std::vector<uint32_t> found;
+      for (auto itr = window.begin(); itr != window.end(); ++itr)
+        found.push_back(itr.index());
+      if (found != expected || window.empty() != expected.empty())
+        throw std::logic_error("Wrong departures in window");
+
+      //the same departures across lines in time order
+      DeparturesByTime by_time(table, start, end, valid, true, false);
+      found.clear();
+      for (auto itr = by_time.begin(); itr != by_time.end(); ++itr)
+        found.push_back(itr.index());
+      if (found != expected)
+        throw std::logic_error("Wrong departures by time");
+    }
+  }
+}
+
+void by_time() {
+  //two lines interleaved in time
+  std::vector<TransitSchedule> schedules = { {0, kAllDaysOfWeek, 0} };
+  std::vector<TransitDeparture> departures = {
+    {1, 10, 0, 0, 0, 100, 60, 0, false, false},
+    {1, 11, 0, 0, 0, 300, 60, 0, false, false},
+    {2, 20, 0, 0, 0, 50, 60, 0, false, false},
+    {2, 21, 0, 0, 0, 100, 60, 0, false, false},
+    {2, 22, 0, 0, 0, 200, 60, 0, false, false}
+  };
+  DepartureTable table(departures.data(), departures.size(), schedules.data(), schedules.size());
+  std::vector<uint32_t> trips;
+  for (const auto& departure : DeparturesByTime(table, 0, ~0u, nullptr, false, false))
+    trips.push_back(departure.tripid());
+  if (trips != std::vector<uint32_t>{ 20, 10, 21, 22, 11 })
+    throw std::logic_error("Departures should be in time order");
+  if (!DeparturesByTime(table, 301, ~0u, nullptr, false, false).empty() ||
+      !DeparturesByTime(table, 200, 100, nullptr, false, false).empty())
+    throw std::logic_error("Window should be empty");
+}
+
+void many_schedules() {
+  //a busy line where most departures run on other days
+  std::mt19937 gen(3);
+  std::vector<TransitSchedule> schedules = { {1, 0, 63} };
+  for (uint32_t i = 1; i < 64; ++i)
+    schedules.emplace_back(1ULL << i, 0, 63);
+  auto departures = make_departures(gen, 2000, schedules.size(), 5);
+  DepartureTable table(departures.data(), departures.size(), schedules.data(), schedules.size());
+
+  auto valid = table.valid_on(5, kMonday, false);
+  for (uint32_t time = 0; time < 10000; time += 100) {
+    if (table.next_valid(table.lower_bound(0, departures.size(), time), departures.size(),
+                         *valid, false, false) !=
+        naive(departures, schedules, time, 5, kMonday, false, false))
+      throw std::logic_error("Departures should match");
+  }
+}
+
+}
+
+int main() {
+  test::suite suite("departure_table");
+
+  suite.test(TEST_CASE(next_valid));
+
+  suite.test(TEST_CASE(day_cache));
+
+  suite.test(TEST_CASE(active_schedules));
+
+  suite.test(TEST_CASE(active_days));
+
+  suite.test(TEST_CASE(windows));
+
+  suite.test(TEST_CASE(by_time));
+
+  suite.test(TEST_CASE(many_schedules));
+
+  return suite.tear_down();
+}
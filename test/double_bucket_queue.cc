@@ -66,6 +66,80 @@ void TestClear() {
   TryClear(costs);
 }
 
+void TryPopBucket(const std::vector<uint32_t>& costs, const uint32_t bucketsize) {
+  std::vector<float> edgelabels;
+  const auto edgecost = [&edgelabels](const uint32_t label) {
+    return edgelabels[label];
+  };
+
+  uint32_t i = 0;
+  DoubleBucketQueue adjlist(0, 10000, bucketsize, edgecost);
+  for (auto cost : costs) {
+    edgelabels.emplace_back(cost);
+    adjlist.add(i, cost);
+    i++;
+  }
+
+  // Each batch must lie within one bucket and batches must come out in
+  // increasing cost order
+  std::vector<uint32_t> batch;
+  std::vector<bool> seen(costs.size(), false);
+  float prevcost = 0.0f;
+  uint32_t total = 0;
+  while (adjlist.pop_bucket(batch) > 0) {
+    float lo = adjlist.current_cost();
+    if (lo < prevcost)
+      throw runtime_error("TryPopBucket: buckets out of order");
+    for (auto label : batch) {
+      if (seen[label])
+        throw runtime_error("TryPopBucket: label returned twice");
+      seen[label] = true;
+      if (edgelabels[label] < lo || edgelabels[label] >= lo + bucketsize)
+        throw runtime_error("TryPopBucket: label cost outside of bucket");
+    }
+    total += batch.size();
+    prevcost = lo;
+  }
+  if (total != costs.size() || !batch.empty())
+    throw runtime_error("TryPopBucket: not all labels were returned");
+  if (adjlist.pop() != kInvalidLabel)
+    throw runtime_error("TryPopBucket: queue should be empty");
+}
+
+void TestPopBucket() {
+  std::vector<uint32_t> costs = { 67, 325, 25, 466, 1000, 100005, 758, 167,
+            258, 16442, 278, 1111110, 66, 68, 26, 29 };
+  TryPopBucket(costs, 5);
+  TryPopBucket(costs, 50);
+}
+
+void TestPopBucketRelax() {
+  std::vector<float> edgelabels = { 10.0f, 11.0f, 12.0f };
+  const auto edgecost = [&edgelabels](const uint32_t label) {
+    return edgelabels[label];
+  };
+  DoubleBucketQueue adjlist(0, 10000, 5, edgecost);
+  for (uint32_t i = 0; i < edgelabels.size(); i++)
+    adjlist.add(i, edgelabels[i]);
+
+  std::vector<uint32_t> batch;
+  if (adjlist.pop_bucket(batch) != 3)
+    throw runtime_error("TestPopBucketRelax: expected all 3 labels in one bucket");
+
+  // Relaxing the batch produces a label within the same bucket, it must be
+  // returned by the next call before any higher cost bucket
+  edgelabels.push_back(13.0f);
+  adjlist.add(3, 13.0f);
+  edgelabels.push_back(20.0f);
+  adjlist.add(4, 20.0f);
+  if (adjlist.pop_bucket(batch) != 1 || batch.front() != 3)
+    throw runtime_error("TestPopBucketRelax: expected re-added label in current bucket");
+  if (adjlist.pop_bucket(batch) != 1 || batch.front() != 4)
+    throw runtime_error("TestPopBucketRelax: expected next bucket");
+  if (adjlist.pop_bucket(batch) != 0)
+    throw runtime_error("TestPopBucketRelax: expected empty queue");
+}
+
 /**
 void TestDecreseCost() {
   std::vector<uint32_t> costs = { 67, 325, 25, 466, 1000, 100005, 758, 167,
@@ -86,6 +160,10 @@ int main() {
 
   suite.test(TEST_CASE(TestClear));
 
+  suite.test(TEST_CASE(TestPopBucket));
+
+  suite.test(TEST_CASE(TestPopBucketRelax));
+
 //  suite.test(TEST_CASE(TestDecreaseCost));
 
   return suite.tear_down();
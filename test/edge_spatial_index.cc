@@ -0,0 +1,123 @@
+#include "test.h"
+
+#include "baldr/edge_spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <valhalla/midgard/constants.h>
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace {
+
+using shapes_t = std::vector<std::pair<GraphId, std::vector<PointLL>>>;
+
+shapes_t make_shapes(const size_t count) {
+  std::mt19937 gen(17);
+  std::uniform_real_distribution<float> start(0.f, .25f);
+  std::uniform_real_distribution<float> step(-.002f, .002f);
+  std::uniform_int_distribution<int> length(2, 12);
+  shapes_t shapes;
+  for (size_t i = 0; i < count; i++) {
+    std::vector<PointLL> shape{ PointLL(start(gen) + 4.f, start(gen) + 52.f) };
+    for (int j = length(gen); j > 1; j--)
+      shape.emplace_back(shape.back().lng() + step(gen), shape.back().lat() + step(gen));
+    shapes.emplace_back(GraphId(42, 2, i), shape);
+  }
+  return shapes;
+}
+
+// Brute force distance (same approximation as the index) to an edge
+float distance(const PointLL& pt, const std::vector<PointLL>& shape) {
+  float mx = kMetersPerDegreeLat * std::cos(pt.lat() * kRadPerDeg);
+  float best = std::numeric_limits<float>::max();
+  for (size_t i = 0; i + 1 < shape.size(); i++) {
+    float ax = (shape[i].lng() - pt.lng()) * mx, ay = (shape[i].lat() - pt.lat()) * kMetersPerDegreeLat;
+    float bx = (shape[i + 1].lng() - pt.lng()) * mx, by = (shape[i + 1].lat() - pt.lat()) * kMetersPerDegreeLat;
+    float dx = bx - ax, dy = by - ay, len = dx * dx + dy * dy;
+    float t = len > 0 ? std::min(std::max(-(ax * dx + ay * dy) / len, 0.f), 1.f) : 0.f;
+    best = std::min(best, std::sqrt((ax + t * dx) * (ax + t * dx) + (ay + t * dy) * (ay + t * dy)));
+  }
+  return best;
+}
+
+void nearest() {
+  auto shapes = make_shapes(2000);
+  EdgeSpatialIndex index(shapes);
+  size_t segments = 0;
+  for (const auto& s : shapes)
+    segments += s.second.size() - 1;
+  if (index.size() != segments)
+    throw std::logic_error("Wrong number of segments indexed");
+
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<float> coord(0.f, .25f);
+  for (int q = 0; q < 50; q++) {
+    PointLL pt(coord(gen) + 4.f, coord(gen) + 52.f);
+    std::vector<float> expected;
+    for (const auto& s : shapes)
+      expected.push_back(distance(pt, s.second));
+    std::sort(expected.begin(), expected.end());
+
+    auto candidates = index.Nearest(pt, 10);
+    if (candidates.size() != 10)
+      throw std::logic_error("Wrong number of candidates");
+    for (size_t i = 0; i < candidates.size(); i++) {
+      if (std::fabs(candidates[i].distance - expected[i]) > .01f)
+        throw std::logic_error("Candidates are not in increasing distance order");
+      const auto& shape = shapes[candidates[i].edgeid.id()].second;
+      if (candidates[i].segment + 1 >= shape.size())
+        throw std::logic_error("Candidate segment out of range");
+    }
+  }
+}
+
+void max_distance() {
+  auto shapes = make_shapes(500);
+  EdgeSpatialIndex index(shapes);
+  PointLL pt(4.1f, 52.1f);
+  size_t visited = 0;
+  float last = 0.f;
+  index.Visit(pt, 200.f, [&visited, &last](const EdgeSpatialIndex::Candidate& c) {
+    if (c.distance > 200.f || c.distance < last)
+      throw std::logic_error("Candidate out of order or beyond the max distance");
+    last = c.distance;
+    ++visited;
+    return true;
+  });
+  size_t expected = 0;
+  for (const auto& s : shapes)
+    for (size_t i = 0; i + 1 < s.second.size(); i++)
+      if (distance(pt, { s.second[i], s.second[i + 1] }) <= 200.f)
+        ++expected;
+  if (visited != expected)
+    throw std::logic_error("Wrong number of segments within the max distance");
+
+  // Far away from everything
+  if (!index.Nearest(PointLL(10.f, 10.f), 5, 1000.f).empty())
+    throw std::logic_error("Should not find anything");
+}
+
+void empty() {
+  EdgeSpatialIndex index(shapes_t{});
+  if (index.size() != 0 || !index.Nearest(PointLL(4.f, 52.f), 5).empty())
+    throw std::logic_error("Empty index should not find anything");
+}
+
+}
+
+int main() {
+  test::suite suite("edge_spatial_index");
+
+  suite.test(TEST_CASE(nearest));
+
+  suite.test(TEST_CASE(max_distance));
+
+  suite.test(TEST_CASE(empty));
+
+  return suite.tear_down();
+}
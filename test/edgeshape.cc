@@ -0,0 +1,116 @@
+#include "test.h"
+
+#include "baldr/edgeshape.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace {
+
+// Reference encode7: zigzag varint deltas, lat then lng, 1e-6 precision
+void serialize(const int32_t number, std::string& output) {
+  uint32_t value = number < 0 ? ~(static_cast<uint32_t>(number) << 1) : number << 1;
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>(0x80 | (value & 0x7f)));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+std::string encode(const std::vector<std::pair<int32_t, int32_t>>& points) {
+  std::string output;
+  int32_t lat = 0, lng = 0;
+  for (const auto& p : points) {
+    serialize(p.second - lat, output);
+    serialize(p.first - lng, output);
+    lng = p.first;
+    lat = p.second;
+  }
+  return output;
+}
+
+std::vector<std::pair<int32_t, int32_t>> random_points(std::mt19937& gen, const size_t count) {
+  // Mix of small steps and the occasional jump across the world so every
+  // varint length is exercised
+  std::uniform_int_distribution<int32_t> step(-2000, 2000);
+  std::uniform_int_distribution<int32_t> lng(-180000000, 180000000);
+  std::uniform_int_distribution<int32_t> lat(-90000000, 90000000);
+  std::vector<std::pair<int32_t, int32_t>> points{ { lng(gen), lat(gen) } };
+  while (points.size() < count) {
+    if (gen() % 10 == 0)
+      points.emplace_back(lng(gen), lat(gen));
+    else
+      points.emplace_back(points.back().first + step(gen), points.back().second + step(gen));
+  }
+  return points;
+}
+
+void decode() {
+  std::mt19937 gen(5);
+  std::vector<PointLL> shape;
+  for (size_t count = 1; count < 200; count++) {
+    auto points = random_points(gen, count);
+    auto encoded = encode(points);
+    decode_shape7(encoded.data(), encoded.size(), shape);
+    if (shape.size() != points.size())
+      throw std::logic_error("Wrong number of points decoded");
+    for (size_t i = 0; i < points.size(); i++) {
+      if (shape[i] != PointLL(points[i].first * 1e-6, points[i].second * 1e-6))
+        throw std::logic_error("Wrong point decoded");
+    }
+
+    // Fixed size buffer, may be too small
+    std::vector<PointLL> buffer(count / 2);
+    if (decode_shape7(encoded.data(), encoded.size(), buffer.data(), buffer.size()) != count ||
+        !std::equal(buffer.begin(), buffer.end(), shape.begin()))
+      throw std::logic_error("Wrong points decoded into the buffer");
+  }
+
+  // Truncated shape
+  auto encoded = encode({ { 170000000, 80000000 }, { -170000000, -80000000 } });
+  try {
+    decode_shape7(encoded.data(), encoded.size() - 1, shape);
+    throw std::logic_error("Truncated shape should throw");
+  } catch (const std::runtime_error&) { }
+}
+
+void cache() {
+  std::mt19937 gen(9);
+  std::vector<std::string> encoded;
+  for (size_t i = 0; i < 4; i++)
+    encoded.push_back(encode(random_points(gen, 10)));
+
+  ShapeCache cache(2);
+  auto a = cache.get(0, encoded[0].data(), encoded[0].size());
+  auto b = cache.get(100, encoded[1].data(), encoded[1].size());
+  if (cache.size() != 2 || a->size() != 10 || cache.get(0, nullptr, 0) != a)
+    throw std::logic_error("Cached shape should be returned");
+
+  // 100 is the least recently used and is dropped but stays valid
+  cache.get(200, encoded[2].data(), encoded[2].size());
+  if (cache.size() != 2 || cache.get(0, nullptr, 0) != a || b->size() != 10)
+    throw std::logic_error("Least recently used shape should be dropped");
+  auto c = cache.get(100, encoded[1].data(), encoded[1].size());
+  if (c == b || *c != *b)
+    throw std::logic_error("Dropped shape should be decoded again");
+
+  cache.clear();
+  if (cache.size() != 0)
+    throw std::logic_error("Cache should be empty");
+}
+
+}
+
+int main() {
+  test::suite suite("edgeshape");
+
+  suite.test(TEST_CASE(decode));
+
+  suite.test(TEST_CASE(cache));
+
+  return suite.tear_down();
+}
@@ -4,6 +4,9 @@
 #include "baldr/connectivity_map.h"
 
 #include <fcntl.h>
+#include <fstream>
+#include <set>
+#include <cmath>
 #include <boost/filesystem.hpp>
 
 using namespace std;
@@ -120,9 +123,259 @@ void TestConnectivityMap() {
   if(conn.get_color({a2, 2, 0}) == conn.get_color({d0, 2, 0}))
     throw std::runtime_error("a is disjoint from d");
 
+  //a circle on the corner of a1 reaches diagonally into c0
+  auto corner = level.tiles.TileBounds(a1).maxpt();
+  PointLL near_corner(corner.lng() - .0001f, corner.lat() - .0001f);
+  PathLocation location(Location{near_corner});
+  location.edges.emplace_back(GraphId(a1, 2, 0), 0.f, near_corner, 0.f);
+  auto colors = conn.get_colors(2, location, 5);
+  if(colors.size() != 1 || colors.find(conn.get_color({a1, 2, 0})) == colors.cend())
+    throw std::runtime_error("Small circle should only touch a");
+  colors = conn.get_colors(2, location, 50);
+  if(colors.size() != 2 || colors.find(conn.get_color({c0, 2, 0})) == colors.cend())
+    throw std::runtime_error("Larger circle should reach c");
+
   boost::filesystem::remove_all(th.tile_dir());
 }
 
+void TestStatistics() {
+  //no tiles on disk sums to nothing with any number of threads
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", "test/gphrdr_stats_test");
+  boost::filesystem::remove_all("test/gphrdr_stats_test");
+  GraphReader reader(pt);
+  for (size_t threads : { 0, 1, 4 }) {
+    auto stats = reader.GetStatistics(2, threads);
+    if(stats.tile_count != 0 || stats.edge_count != 0)
+      throw std::runtime_error("Level without tiles should have no statistics");
+    const auto& level = reader.GetTileHierarchy().levels().find(2)->second;
+    stats = reader.GetStatistics(level.tiles.TileBounds(0), 2, threads);
+    if(stats.tile_count != 0)
+      throw std::runtime_error("Bounding box without tiles should have no statistics");
+  }
+}
+
+void write_transit_tile(const GraphId& id, const TileHierarchy& tile_hierarchy,
+                        const std::string& stop, const std::string& route,
+                        const uint32_t lineid) {
+  //one stop and one route of operator o-op with one departure on the line
+  std::string text = '\0' + stop + '\0' + route + '\0' + "o-op" + '\0';
+  const uint32_t route_offset = stop.size() + 2;
+  TransitStop transit_stop(1, 1);
+  TransitRoute transit_route(0, route_offset, route_offset + route.size() + 1,
+                             0, 0, 0, 0, 0, 0, 0);
+  TransitDeparture departure(lineid, 1, 0, 0, 0, 100, 10, 0, false, false);
+  TransitSchedule schedule(1, 0x7f, 0);
+
+  GraphTileHeader header;
+  header.set_graphid(id);
+  header.set_departurecount(1);
+  header.set_stopcount(1);
+  header.set_routecount(1);
+  header.set_schedulecount(1);
+  const uint32_t text_offset = sizeof(header) + sizeof(departure) +
+      sizeof(transit_stop) + sizeof(transit_route) + sizeof(schedule);
+  header.set_edgeinfo_offset(text_offset);
+  header.set_textlist_offset(text_offset);
+
+  auto fullpath = tile_hierarchy.tile_dir() + '/' + GraphTile::FileSuffix(id, tile_hierarchy);
+  boost::filesystem::create_directories(boost::filesystem::path(fullpath).parent_path());
+  std::ofstream file(fullpath, std::ios::out | std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(&departure), sizeof(departure));
+  file.write(reinterpret_cast<const char*>(&transit_stop), sizeof(transit_stop));
+  file.write(reinterpret_cast<const char*>(&transit_route), sizeof(transit_route));
+  file.write(reinterpret_cast<const char*>(&schedule), sizeof(schedule));
+  file.write(text.data(), text.size());
+}
+
+void TestOneStopIndexes() {
+  //no transit tiles on disk
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", "test/gphrdr_onestop_test");
+  boost::filesystem::remove_all("test/gphrdr_onestop_test");
+  GraphReader empty(pt);
+  auto indexes = empty.GetOneStopIndexes();
+  if(indexes->stops.size() != 0 || indexes->routes.size() != 0 || indexes->operators.size() != 0)
+    throw std::runtime_error("Tile set without transit tiles should have no onestops");
+
+  //two transit tiles of one operator, one of them already cached
+  TileHierarchy th("test/gphrdr_onestop_test");
+  const uint8_t transit_level = th.levels().rbegin()->first + 1;
+  write_transit_tile({7, transit_level, 0}, th, "s-a", "r-a", 3);
+  write_transit_tile({8, transit_level, 0}, th, "s-b", "r-b", 5);
+  GraphReader reader(pt);
+  if(reader.GetTileSet(transit_level).size() != 2)
+    throw std::runtime_error("Transit tiles should be found on disk");
+  if(reader.GetGraphTile({8, transit_level, 0}) == nullptr)
+    throw std::runtime_error("Transit tile should be read");
+  indexes = reader.GetOneStopIndexes();
+  auto stop = indexes->stops.find(TextView("s-b", 3));
+  auto route = indexes->routes.find(TextView("r-a", 3));
+  auto op = indexes->operators.find(TextView("o-op", 4));
+  if(indexes->stops.size() != 2 || indexes->routes.size() != 2 ||
+     std::vector<tile_index_pair>(stop.begin(), stop.end()) !=
+       std::vector<tile_index_pair>{ {8, 0} } ||
+     std::vector<tile_index_pair>(route.begin(), route.end()) !=
+       std::vector<tile_index_pair>{ {7, 3} } ||
+     std::vector<tile_index_pair>(op.begin(), op.end()) !=
+       std::vector<tile_index_pair>{ {7, 3}, {8, 5} })
+    throw std::runtime_error("Wrong merged onestop indexes");
+
+  //built once per reader, which does not see another reader's tile set
+  if(reader.GetOneStopIndexes() != indexes || empty.GetOneStopIndexes()->stops.size() != 0)
+    throw std::runtime_error("Onestop indexes should be kept by their reader");
+
+  boost::filesystem::remove_all("test/gphrdr_onestop_test");
+}
+
+// encode7: zigzag varint deltas, lat then lng, 1e-6 precision
+std::string encode7(const std::vector<PointLL>& points) {
+  std::string encoded;
+  int32_t last[] = { 0, 0 };
+  for (const auto& p : points) {
+    const int32_t values[] = { int32_t(std::round(p.lat() * 1e6)),
+                               int32_t(std::round(p.lng() * 1e6)) };
+    for (int i = 0; i < 2; ++i) {
+      int32_t delta = values[i] - last[i];
+      last[i] = values[i];
+      uint32_t zigzag = (static_cast<uint32_t>(delta) << 1) ^ (delta >> 31);
+      while (zigzag >= 0x80) {
+        encoded.push_back(static_cast<char>((zigzag & 0x7f) | 0x80));
+        zigzag >>= 7;
+      }
+      encoded.push_back(static_cast<char>(zigzag));
+    }
+  }
+  return encoded;
+}
+
+void write_road_tile(const GraphId& id, const TileHierarchy& tile_hierarchy,
+                     const std::vector<PointLL>& shape) {
+  //one node and one edge, binned where the shape starts
+  const auto& tiles = tile_hierarchy.levels().find(id.level())->second.tiles;
+  auto box = tiles.TileBounds(id.tileid());
+  size_t col = (shape.front().lng() - box.minx()) / ((box.maxx() - box.minx()) / kBinsDim);
+  size_t row = (shape.front().lat() - box.miny()) / ((box.maxy() - box.miny()) / kBinsDim);
+  uint32_t offsets[kBinCount];
+  for (size_t i = 0; i < kBinCount; ++i)
+    offsets[i] = i < row * kBinsDim + col ? 0 : 1;
+  GraphId edge_id(id.tileid(), id.level(), 0);
+
+  NodeInfo node;
+  DirectedEdge edge;
+  edge.set_edgeinfo_offset(0);
+  uint64_t wayid = id.tileid();
+  std::string encoded = encode7(shape);
+  EdgeInfo::PackedItem item{0, static_cast<uint32_t>(encoded.size()), 0};
+
+  GraphTileHeader header;
+  header.set_graphid(id);
+  header.set_nodecount(1);
+  header.set_directededgecount(1);
+  header.set_edge_bin_offsets(offsets);
+  const uint32_t edgeinfo_offset = sizeof(header) + sizeof(node) + sizeof(edge) + sizeof(edge_id);
+  header.set_edgeinfo_offset(edgeinfo_offset);
+  header.set_textlist_offset(edgeinfo_offset + sizeof(wayid) + sizeof(item) + encoded.size());
+
+  auto fullpath = tile_hierarchy.tile_dir() + '/' + GraphTile::FileSuffix(id, tile_hierarchy);
+  boost::filesystem::create_directories(boost::filesystem::path(fullpath).parent_path());
+  std::ofstream file(fullpath, std::ios::out | std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(&node), sizeof(node));
+  file.write(reinterpret_cast<const char*>(&edge), sizeof(edge));
+  file.write(reinterpret_cast<const char*>(&edge_id), sizeof(edge_id));
+  file.write(reinterpret_cast<const char*>(&wayid), sizeof(wayid));
+  file.write(reinterpret_cast<const char*>(&item), sizeof(item));
+  file.write(encoded.data(), encoded.size());
+  file.write("", 1);
+}
+
+void TestEdgesAcrossAntimeridian() {
+  //an edge on either side of 180
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", "test/gphrdr_antimeridian_test");
+  boost::filesystem::remove_all("test/gphrdr_antimeridian_test");
+  TileHierarchy th("test/gphrdr_antimeridian_test");
+  const auto& tiles = th.levels().find(2)->second.tiles;
+  GraphId west(tiles.TileId(PointLL(-179.9f, 0.12f)), 2, 0);
+  GraphId east(tiles.TileId(PointLL(179.9f, 0.12f)), 2, 0);
+  write_road_tile(west, th, { { -179.999f, 0.12f }, { -179.99f, 0.12f } });
+  write_road_tile(east, th, { { 179.99f, 0.12f }, { 179.999f, 0.12f } });
+  GraphReader reader(pt);
+
+  //a radius around a point just west of 180 reaches both of them
+  std::set<uint32_t> found;
+  bool projected_in_range = true;
+  reader.EdgesInRadius({ 179.995f, 0.12f }, 2000.f, 2,
+    [&found, &projected_in_range](const GraphReader::SpatialEdge& edge) {
+      found.insert(edge.id.tileid());
+      projected_in_range = projected_in_range && edge.distance < 700.f &&
+          edge.projected.lng() >= -180.f && edge.projected.lng() <= 180.f;
+      return true;
+    });
+  if(found != std::set<uint32_t>{ west.tileid(), east.tileid() } || !projected_in_range)
+    throw std::runtime_error("Radius across the antimeridian should find the edges on both sides");
+
+  //so does a box given from its west to its east corner
+  found.clear();
+  reader.EdgesInBoundingBox({ 179.98f, 0.1f, -179.98f, 0.14f }, 2,
+    [&found](const GraphReader::SpatialEdge& edge) {
+      found.insert(edge.id.tileid());
+      return true;
+    });
+  if(found != std::set<uint32_t>{ west.tileid(), east.tileid() })
+    throw std::runtime_error("Box across the antimeridian should find the edges on both sides");
+
+  //but a radius that does not reach across stays on its side
+  found.clear();
+  reader.EdgesInRadius({ 179.9f, 0.12f }, 2000.f, 2,
+    [&found](const GraphReader::SpatialEdge& edge) {
+      found.insert(edge.id.tileid());
+      return true;
+    });
+  if(!found.empty())
+    throw std::runtime_error("Radius short of the antimeridian should find nothing");
+
+  boost::filesystem::remove_all("test/gphrdr_antimeridian_test");
+}
+
+void TestStatisticsOfTiles() {
+  //three tiles on disk in a row, the middle one cached
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", "test/gphrdr_stats_tiles_test");
+  boost::filesystem::remove_all("test/gphrdr_stats_tiles_test");
+  TileHierarchy th("test/gphrdr_stats_tiles_test");
+  const auto& tiles = th.levels().find(2)->second.tiles;
+  std::vector<GraphId> ids;
+  uint64_t bytes = 0;
+  for (float lng : { 0.1f, 0.35f, 0.6f }) {
+    ids.emplace_back(tiles.TileId(PointLL(lng, 0.1f)), 2, 0);
+    write_road_tile(ids.back(), th, { { lng, 0.1f }, { lng + 0.01f, 0.1f } });
+    bytes += boost::filesystem::file_size(th.tile_dir() + '/' +
+                                          GraphTile::FileSuffix(ids.back(), th));
+  }
+  GraphReader reader(pt);
+  if(reader.GetGraphTile(ids[1]) == nullptr)
+    throw std::runtime_error("Tile should be read");
+
+  //cached and uncached tiles sum the same with any number of threads
+  for (size_t threads : { 1, 4 }) {
+    auto stats = reader.GetStatistics(2, threads);
+    if(stats.tile_count != 3 || stats.node_count != 3 || stats.edge_count != 3 ||
+       stats.tile_bytes != bytes)
+      throw std::runtime_error("Level should sum the statistics of all of its tiles");
+    stats = reader.GetStatistics({ 0.3f, 0.05f, 0.7f, 0.15f }, 2, threads);
+    if(stats.tile_count != 2 || stats.edge_count != 2)
+      throw std::runtime_error("Bounding box should sum the statistics of its tiles only");
+  }
+  //other levels are not summed in
+  if(reader.GetStatistics(1, 4).tile_count != 0)
+    throw std::runtime_error("Level without tiles should have no statistics");
+
+  boost::filesystem::remove_all("test/gphrdr_stats_tiles_test");
+}
+
 }
 
 int main() {
@@ -132,5 +385,13 @@ int main() {
 
   suite.test(TEST_CASE(TestConnectivityMap));
 
+  suite.test(TEST_CASE(TestStatistics));
+
+  suite.test(TEST_CASE(TestOneStopIndexes));
+
+  suite.test(TEST_CASE(TestEdgesAcrossAntimeridian));
+
+  suite.test(TEST_CASE(TestStatisticsOfTiles));
+
   return suite.tear_down();
 }
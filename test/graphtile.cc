@@ -2,6 +2,8 @@
 
 #include "baldr/graphtile.h"
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 
 using namespace valhalla::baldr;
@@ -14,6 +16,45 @@ struct testable_graphtile : public valhalla::baldr::GraphTile {
     header_->set_edge_bin_offsets(offsets);
     edge_bins_ = bins.data();
   }
+
+  testable_graphtile(std::vector<Sign>& signs,
+                     std::vector<AccessRestriction>& restrictions,
+                     std::vector<TransitDeparture>& departures,
+                     std::vector<TransitSchedule>& schedules,
+                     std::string& text) {
+    header_ = new GraphTileHeader();
+    header_->set_signcount(signs.size());
+    header_->set_access_restriction_count(restrictions.size());
+    header_->set_departurecount(departures.size());
+    header_->set_schedulecount(schedules.size());
+    signs_ = signs.data();
+    access_restrictions_ = restrictions.data();
+    departures_ = departures.data();
+    transit_schedules_ = schedules.data();
+    textlist_ = &text[0];
+    textlist_size_ = text.size();
+  }
+
+  void set_edgeinfo(std::vector<char>& edgeinfo) {
+    edgeinfo_ = edgeinfo.data();
+    edgeinfo_size_ = edgeinfo.size();
+  }
+
+  void set_transit(const GraphId& id, std::vector<TransitStop>& stops,
+                   std::vector<TransitRoute>& routes) {
+    header_->set_graphid(id);
+    header_->set_stopcount(stops.size());
+    header_->set_routecount(routes.size());
+    transit_stops_ = stops.data();
+    transit_routes_ = routes.data();
+  }
+
+  void set_graph(std::vector<NodeInfo>& nodes, std::vector<DirectedEdge>& edges) {
+    header_->set_nodecount(nodes.size());
+    header_->set_directededgecount(edges.size());
+    nodes_ = nodes.data();
+    directededges_ = edges.data();
+  }
 };
 
 void file_suffix() {
@@ -67,6 +108,553 @@ void bin() {
   }
 }
 
+void lookups() {
+  //signs on edges 1 (two of them) and 4, text is a single null char
+  std::string text(1, '\0');
+  std::vector<Sign> signs = {
+    {1, Sign::Type::kExitNumber, 0}, {1, Sign::Type::kExitToward, 0},
+    {4, Sign::Type::kExitName, 0}
+  };
+  //restrictions on edges 2 and 4 for different modes
+  std::vector<AccessRestriction> restrictions = {
+    {2, AccessType::kMaxHeight, kAutoAccess, 0, 1},
+    {4, AccessType::kMaxWidth, kAutoAccess, 0, 2},
+    {4, AccessType::kMaxWeight, kPedestrianAccess, 0, 3}
+  };
+  //departures on lines 3 and 5, sorted by line then time
+  std::vector<TransitSchedule> schedules = { {1, 0x7f, 0} };
+  std::vector<TransitDeparture> departures = {
+    {3, 30, 0, 0, 0, 100, 10, 0, false, false},
+    {3, 31, 0, 0, 0, 200, 10, 0, false, false},
+    {5, 50, 0, 0, 0, 50, 10, 0, false, false},
+    {5, 51, 0, 0, 0, 150, 10, 0, true, false}
+  };
+  testable_graphtile t(signs, restrictions, departures, schedules, text);
+
+  if(t.GetSigns(1).size() != 2 || t.GetSigns(4).size() != 1 ||
+     !t.GetSigns(0).empty() || !t.GetSigns(2).empty() || !t.GetSigns(5).empty())
+    throw std::logic_error("Wrong signs found");
+
+  if(t.GetAccessRestrictions(2, kAutoAccess).size() != 1 ||
+     t.GetAccessRestrictions(4, kAutoAccess | kPedestrianAccess).size() != 2 ||
+     t.GetAccessRestrictions(4, kPedestrianAccess).size() != 1 ||
+     !t.GetAccessRestrictions(3, kAutoAccess).empty() ||
+     !t.GetAccessRestrictions(5, kAutoAccess).empty())
+    throw std::logic_error("Wrong access restrictions found");
+
+  auto dep = t.GetNextDeparture(3, 150, 0, 1, false, false, false);
+  if(dep == nullptr || dep->tripid() != 31)
+    throw std::logic_error("Wrong next departure");
+  dep = t.GetNextDeparture(5, 0, 0, 1, false, true, false);
+  if(dep == nullptr || dep->tripid() != 51)
+    throw std::logic_error("Wrong wheelchair accessible departure");
+  if(t.GetNextDeparture(3, 201, 0, 1, false, false, false) != nullptr ||
+     t.GetNextDeparture(4, 0, 0, 1, false, false, false) != nullptr)
+    throw std::logic_error("Should be no more departures");
+
+  //the next day's first departure when there are none left today
+  auto next = t.GetNextDeparture(3, 201, 0, kMonday, false, false, false, 1);
+  if(next.departure == nullptr || next.departure->tripid() != 30 || next.day_offset != 1)
+    throw std::logic_error("Wrong next day departure");
+
+  dep = t.GetTransitDeparture(5, 51);
+  if(dep == nullptr || dep->departure_time() != 150)
+    throw std::logic_error("Wrong departure for trip");
+  if(t.GetTransitDeparture(3, 50) != nullptr || t.GetTransitDeparture(6, 50) != nullptr)
+    throw std::logic_error("Should be no departure for trip");
+}
+
+void multi_day_departures() {
+  //line 7 runs on wednesdays and on day 2 only
+  std::vector<TransitSchedule> schedules = { {0, kWednesday, 0}, {1ULL << 2, 0, 63} };
+  std::vector<TransitDeparture> departures = {
+    {7, 70, 0, 0, 0, 100, 10, 0, false, false},
+    {7, 71, 0, 0, 0, 300, 10, 1, false, false}
+  };
+  std::vector<Sign> signs;
+  std::vector<AccessRestriction> restrictions;
+  std::string text(1, '\0');
+  testable_graphtile t(signs, restrictions, departures, schedules, text);
+
+  //monday day 0: nothing on monday or tuesday, wednesday's first departure
+  if(t.GetNextDeparture(7, 200, 0, kMonday, false, false, false, 1).departure != nullptr)
+    throw std::logic_error("Should be no departures within a day");
+  auto next = t.GetNextDeparture(7, 200, 0, kMonday, false, false, false, 2);
+  if(next.departure == nullptr || next.departure->tripid() != 70 || next.day_offset != 2)
+    throw std::logic_error("Wrong wednesday departure");
+
+  //sunday day 0: the day 2 departure comes before wednesday
+  next = t.GetNextDeparture(7, 200, 0, kSunday, false, false, false, 7);
+  if(next.departure == nullptr || next.departure->tripid() != 71 || next.day_offset != 2)
+    throw std::logic_error("Wrong day 2 departure");
+
+  //friday day 3: the days of week wrap around from saturday to sunday
+  next = t.GetNextDeparture(7, 0, 3, kFriday, false, false, false, 7);
+  if(next.departure == nullptr || next.departure->tripid() != 70 || next.day_offset != 5)
+    throw std::logic_error("Wrong departure after the weekend");
+  if(t.GetNextDeparture(7, 0, 3, kFriday, false, false, false, 4).departure != nullptr)
+    throw std::logic_error("Should be no departures within the horizon");
+
+  //every departure in a window, of one line or of the whole tile
+  std::vector<uint32_t> trips;
+  for (const auto& departure : t.GetDepartures(7, 0, 300, 2, kWednesday, false, false, false))
+    trips.push_back(departure.tripid());
+  if (trips != std::vector<uint32_t>{ 70, 71 })
+    throw std::logic_error("Wrong departures in window");
+  if (!t.GetDepartures(7, 101, 299, 2, kWednesday, false, false, false).empty() ||
+      !t.GetDepartures(8, 0, 300, 2, kWednesday, false, false, false).empty())
+    throw std::logic_error("Window should be empty");
+  trips.clear();
+  for (const auto& departure : t.GetDeparturesByTime(0, 300, 3, kThursday, false, false, false))
+    trips.push_back(departure.tripid());
+  if (!trips.empty() || t.GetDeparturesByTime(0, 300).empty())
+    throw std::logic_error("Wrong departures by time");
+
+  //wednesday day 2 runs both schedules, thursday day 3 neither
+  auto active = t.GetActiveSchedules(2, kWednesday, false);
+  if (!DepartureTable::test(*active, 0) || !DepartureTable::test(*active, 1) ||
+      (*t.GetActiveSchedules(3, kThursday, false))[0] != 0)
+    throw std::logic_error("Wrong active schedules");
+
+  //trip 70 continues on line 7 from the stop it arrives at, block 0 is none
+  std::vector<TransitDeparture> trip_departures = {
+    {7, 70, 0, 9, 0, 100, 10, 0, false, false},
+    {7, 71, 0, 9, 0, 300, 10, 0, false, false},
+    {8, 70, 0, 9, 0, 120, 10, 0, false, false},
+    {8, 72, 0, 0, 0, 150, 10, 0, false, false}
+  };
+  testable_graphtile trip_tile(signs, restrictions, trip_departures, schedules, text);
+  auto dep = trip_tile.GetNextTripDeparture(70, 110);
+  if(dep == nullptr || dep->lineid() != 8 || trip_tile.GetNextTripDeparture(70, 121) != nullptr)
+    throw std::logic_error("Wrong next trip departure");
+  dep = trip_tile.GetNextBlockDeparture(9, 121);
+  if(dep == nullptr || dep->tripid() != 71 || trip_tile.GetNextBlockDeparture(0, 0) != nullptr)
+    throw std::logic_error("Wrong next block departure");
+  dep = trip_tile.GetTransitDeparture(8, 70);
+  if(dep == nullptr || dep->departure_time() != 120 || trip_tile.GetTransitDeparture(8, 71) != nullptr)
+    throw std::logic_error("Wrong departure for trip");
+
+  //unknown lines have no departures on any day
+  if(t.GetNextDeparture(8, 0, 0, kMonday, false, false, false, 7).departure != nullptr)
+    throw std::logic_error("Unknown line should have no departures");
+}
+
+void long_horizon() {
+  //line 7 runs every day but only with wheelchair access on day 10
+  const uint32_t far_day = DepartureTable::kCachedDays + 6;
+  std::vector<TransitSchedule> schedules = { {0, kAllDaysOfWeek, 0}, {1ULL << far_day, 0, 63} };
+  std::vector<TransitDeparture> departures = {
+    {7, 70, 0, 0, 0, 100, 10, 0, false, false},
+    {7, 71, 0, 0, 0, 300, 10, 1, true, false}
+  };
+  std::vector<Sign> signs;
+  std::vector<AccessRestriction> restrictions;
+  std::string text(1, '\0');
+  testable_graphtile t(signs, restrictions, departures, schedules, text);
+
+  //found past the cached days
+  auto first = t.GetActiveSchedules(0, kSunday, false);
+  auto next = t.GetNextDeparture(7, 200, 0, kSunday, false, true, false, far_day + 2);
+  if(next.departure == nullptr || next.departure->tripid() != 71 || next.day_offset != far_day)
+    throw std::logic_error("Wrong departure past the cached days");
+  if(t.GetNextDeparture(7, 200, 0, kSunday, false, true, false, far_day - 1).departure != nullptr)
+    throw std::logic_error("Should be no departures within the horizon");
+  next = t.GetNextDeparture(7, 200, 0, kSunday, false, false, false, far_day);
+  if(next.departure == nullptr || next.departure->tripid() != 70 || next.day_offset != 1)
+    throw std::logic_error("Wrong departure on the next day");
+
+  //and the walk does not evict the first days from the cache
+  if(t.GetActiveSchedules(0, kSunday, false) != first)
+    throw std::logic_error("Long horizon should not evict the cached days");
+}
+
+void realtime() {
+  //line 7 every 100 seconds, trips 70 to 74, trip 80 continues trip 72
+  std::vector<TransitSchedule> schedules = { {0, kAllDaysOfWeek, 0} };
+  std::vector<TransitDeparture> departures;
+  for (uint32_t i = 0; i < 5; ++i)
+    departures.emplace_back(7, 70 + i, 0, 9, 0, 100 * (i + 1), 10, 0, false, false);
+  departures.emplace_back(8, 72, 0, 9, 0, 320, 10, 0, false, false);
+  departures.emplace_back(8, 80, 0, 9, 0, 400, 10, 0, false, false);
+  std::vector<Sign> signs;
+  std::vector<AccessRestriction> restrictions;
+  std::string text(1, '\0');
+  testable_graphtile t(signs, restrictions, departures, schedules, text);
+  auto overlay = std::make_shared<RealtimeOverlay>();
+  t.SetRealtimeOverlay(overlay);
+
+  //no updates published yet
+  auto next = t.GetNextDeparture(7, 150, 1, kMonday, false, false, false, 0);
+  if(next.departure == nullptr || next.departure->tripid() != 71 || next.delay != 0)
+    throw std::logic_error("Wrong static departure");
+
+  //trip 71 is cancelled and trip 70 is late enough to leave after 150 but
+  //trip 72 leaves early, before it
+  auto delays = std::make_shared<RealtimeDelays>();
+  const GraphId tile = t.header()->graphid().Tile_Base();
+  delays->Add(tile, 71, { true, 0, {} });
+  delays->Add(tile, 70, { false, 120, {} });
+  delays->Add(tile, 72, { false, 0, { { 7, -100 } } });
+  overlay->Publish(delays);
+  next = t.GetNextDeparture(7, 150, 1, kMonday, false, false, false, 0);
+  if(next.departure == nullptr || next.departure->tripid() != 72 || next.delay != -100)
+    throw std::logic_error("Wrong delayed departure");
+  next = t.GetNextDeparture(7, 201, 1, kMonday, false, false, false, 0);
+  if(next.departure == nullptr || next.departure->tripid() != 70 || next.delay != 120)
+    throw std::logic_error("Late departure should be found");
+  //the legacy overload cannot return the delay so it keeps to the schedule
+  auto legacy = t.GetNextDeparture(7, 201, 1, kMonday, false, false, false);
+  if(legacy == nullptr || legacy->tripid() != 72 || legacy->departure_time() != 300)
+    throw std::logic_error("Legacy departure should use scheduled times");
+  if(t.GetDepartureDelay(departures[0]) != 120 || t.GetDepartureDelay(departures[3]) != 0 ||
+     !t.IsTripCancelled(71) || t.IsTripCancelled(70))
+    throw std::logic_error("Wrong realtime update of departures");
+
+  //departures of a cancelled trip are not returned by trip id either
+  if(t.GetTransitDeparture(7, 71) != nullptr)
+    throw std::logic_error("Cancelled trip should have no departure");
+  auto scheduled = t.GetTransitDeparture(7, 70);
+  if(scheduled == nullptr || scheduled->departure_time() != 100)
+    throw std::logic_error("Delayed trip should keep its departure");
+
+  //trip and block continuation see the same updates
+  if(t.GetNextTripDeparture(71, 0) != nullptr)
+    throw std::logic_error("Cancelled trip should not continue");
+  auto dep = t.GetNextBlockDeparture(9, 150);
+  if(dep == nullptr || dep->tripid() != 72 || dep->lineid() != 7)
+    throw std::logic_error("Wrong delayed block departure");
+
+  //updates for other days and tiles are not applied
+  next = t.GetNextDeparture(7, 150, 1, kMonday, false, false, false, 1);
+  if(next.departure == nullptr || next.departure->tripid() != 72)
+    throw std::logic_error("Wrong departure with a horizon");
+  overlay->Publish(nullptr);
+  dep = t.GetNextDeparture(7, 150, 1, kMonday, false, false, false);
+  if(dep == nullptr || dep->tripid() != 71)
+    throw std::logic_error("Cleared updates should not apply");
+
+  //updates of other tiles are not applied to this one
+  auto busy = std::make_shared<RealtimeDelays>();
+  busy->Add(GraphId(tile.tileid() + 1, tile.level(), 0), 70, { false, 60, {} });
+  overlay->Publish(busy);
+  next = t.GetNextDeparture(7, 150, 1, kMonday, false, false, false, 0);
+  if(next.departure == nullptr || next.departure->tripid() != 71 || next.delay != 0)
+    throw std::logic_error("Updates of other tiles should not apply");
+}
+
+void views() {
+  //text list with three names, signs on edge 2 point at the last two
+  std::string text("\0Main St\0Exit 7\0Toward Town\0", 28);
+  std::vector<Sign> signs = {
+    {2, Sign::Type::kExitNumber, 9}, {2, Sign::Type::kExitToward, 16}
+  };
+  std::vector<AccessRestriction> restrictions;
+  std::vector<TransitDeparture> departures;
+  std::vector<TransitSchedule> schedules;
+  testable_graphtile t(signs, restrictions, departures, schedules, text);
+
+  if(t.GetNameView(1) != "Main St" || t.GetNameView(1).size() != 7 ||
+     !t.GetNameView(0).empty() || t.GetName(9) != "Exit 7")
+    throw std::logic_error("Wrong name view");
+  try {
+    t.GetNameView(text.size());
+    throw std::logic_error("Name view past the text list should throw");
+  } catch (const std::runtime_error&) { }
+
+  auto views = t.GetSignViews(2);
+  if(views.size() != 2 || !t.GetSignViews(1).empty() || !t.GetSignViews(3).empty())
+    throw std::logic_error("Wrong number of sign views");
+  auto sign = views.begin();
+  if((*sign).type != Sign::Type::kExitNumber || (*sign).text != "Exit 7" ||
+     (*++sign).text != std::string("Toward Town"))
+    throw std::logic_error("Wrong sign view");
+
+  //names of an edge as laid out in the edge info
+  uint32_t offsets[] = { 16, 1 };
+  NameViews names(offsets, 2, text.data(), text.size());
+  std::vector<std::string> expected = { "Toward Town", "Main St" };
+  if(!std::equal(names.begin(), names.end(), expected.begin()) || names[1] != "Main St")
+    throw std::logic_error("Wrong name views");
+  auto last = names.end() - 1;
+  if(last - names.begin() != 1 || names.begin()[1] != "Main St" || 1 + names.begin() != last ||
+     !(names.begin() < last) || !(last <= names.end()) || *(last--) != "Main St" ||
+     *last != "Toward Town" || std::distance(names.begin(), names.end()) != 2)
+    throw std::logic_error("Wrong random access to name views");
+}
+
+void edgeinfo_ref() {
+  //edge info at offset 4: way id, 2 names, 2 point shape
+  std::string text("\0Main St\0Exit 7\0", 16);
+  std::vector<char> edgeinfo(4, 0);
+  uint64_t wayid = 1234567890123;
+  edgeinfo.insert(edgeinfo.end(), reinterpret_cast<char*>(&wayid),
+                  reinterpret_cast<char*>(&wayid) + sizeof(wayid));
+  EdgeInfo::PackedItem item{2, 4, 0};
+  edgeinfo.insert(edgeinfo.end(), reinterpret_cast<char*>(&item),
+                  reinterpret_cast<char*>(&item) + sizeof(item));
+  uint32_t names[] = { 9, 1 };
+  edgeinfo.insert(edgeinfo.end(), reinterpret_cast<char*>(names),
+                  reinterpret_cast<char*>(names) + sizeof(names));
+  //(0,0) then a delta of 1 lng and 2 lat (1e-6 degrees), zigzag encoded
+  const char shape[] = { 0, 0, 4, 2 };
+  edgeinfo.insert(edgeinfo.end(), shape, shape + sizeof(shape));
+
+  std::vector<Sign> signs;
+  std::vector<AccessRestriction> restrictions;
+  std::vector<TransitDeparture> departures;
+  std::vector<TransitSchedule> schedules;
+  testable_graphtile t(signs, restrictions, departures, schedules, text);
+  t.set_edgeinfo(edgeinfo);
+
+  EdgeInfoRef ref = t.edgeinfo_ref(4);
+  if(ref.wayid() != wayid || ref.name_count() != 2 || ref.encoded_shape_size() != 4 ||
+     ref.GetStreetNameOffset(1) != 1 || ref.GetNameViews()[0] != "Exit 7")
+    throw std::logic_error("Wrong edge info through the handle");
+  std::vector<PointLL> points;
+  ref.decode_shape(points);
+  if(points.size() != 2 || points[1] != PointLL(1e-6, 2e-6))
+    throw std::logic_error("Wrong shape through the handle");
+
+  //the wrapper should agree
+  auto info = t.edgeinfo(4);
+  if(info.wayid() != wayid || info.GetNames() != std::vector<std::string>{"Exit 7", "Main St"} ||
+     info.shape() != points || t.GetNames(4).size() != 2)
+    throw std::logic_error("Wrong edge info through the wrapper");
+
+  //the handle points into the tile memory, not at the GraphTile object
+  EdgeInfoRef kept = [&t]() {
+    std::unique_ptr<testable_graphtile> copy(new testable_graphtile(t));
+    return copy->edgeinfo_ref(4);
+  }();
+  if(kept.GetNameViews()[1] != "Main St")
+    throw std::logic_error("Edge info handle should outlive the GraphTile object");
+
+  //name ids match the process wide ids of the same strings
+  std::vector<uint32_t> ids;
+  t.GetNameIds(4, ids);
+  std::vector<uint32_t> expected = {
+    NameTable::instance().Intern(TextView("Main St", 7)),
+    NameTable::instance().Intern(TextView("Exit 7", 6))
+  };
+  std::sort(expected.begin(), expected.end());
+  if(ids != expected || t.GetNameId(9) != 9 || t.GetGlobalNameId(1) != t.GetGlobalNameId(1))
+    throw std::logic_error("Wrong name ids");
+}
+
+}
+
+void node_edges() {
+  //three nodes with 2, 0 and 3 outbound edges
+  std::vector<NodeInfo> nodes(3);
+  uint32_t counts[] = { 2, 0, 3 };
+  for (uint32_t i = 0, first = 0; i < nodes.size(); first += counts[i++]) {
+    nodes[i].set_edge_index(first);
+    nodes[i].set_edge_count(counts[i]);
+  }
+  std::vector<DirectedEdge> edges(5);
+  std::string text;
+  std::vector<Sign> signs;
+  std::vector<AccessRestriction> restrictions;
+  std::vector<TransitDeparture> departures;
+  std::vector<TransitSchedule> schedules;
+  testable_graphtile t(signs, restrictions, departures, schedules, text);
+  t.set_graph(nodes, edges);
+
+  if(t.GetNodes().size() != 3 || t.GetNodes().begin() != t.node(size_t(0)) ||
+     t.GetDirectedEdges().size() != 5 || t.GetDirectedEdges().end() != edges.data() + 5)
+    throw std::logic_error("Wrong node or edge range");
+  if(t.GetDirectedEdges(2).size() != 3 || t.GetDirectedEdges(2).begin() != t.directededge(size_t(2)) ||
+     t.GetDirectedEdges(1).size() != 0)
+    throw std::logic_error("Wrong edges of a node");
+
+  uint32_t visited = 0, edge_total = 0;
+  for (const auto& n : t.GetNodeEdges()) {
+    if(n.id != visited || n.node != t.node(size_t(visited)) || n.edges.size() != counts[visited])
+      throw std::logic_error("Wrong node while iterating");
+    for (const auto& edge : n.edges)
+      if(&edge != t.directededge(size_t(edge_total++)))
+        throw std::logic_error("Wrong edge while iterating");
+    visited++;
+  }
+  if(visited != 3 || edge_total != 5)
+    throw std::logic_error("Wrong number of nodes or edges iterated");
+
+  //a node whose edges run past the end of the tile
+  nodes[2].set_edge_count(4);
+  try {
+    for (const auto& n : t.GetNodeEdges())
+      (void)n;
+    throw std::logic_error("Edges out of bounds should throw");
+  } catch (const std::runtime_error&) { }
+}
+
+//breadth first expansion from node 0 through every edge, returning the
+//number of edges relaxed
+template <bool unchecked>
+uint64_t expand(const GraphTile& t, std::vector<uint32_t>& queue,
+                std::vector<bool>& visited) {
+  queue.assign(1, 0);
+  visited.assign(visited.size(), false);
+  visited[0] = true;
+  uint64_t relaxed = 0;
+  for (size_t q = 0; q < queue.size(); ++q) {
+    const NodeInfo* node = unchecked ? t.node_unchecked(queue[q]) : t.node(size_t(queue[q]));
+    for (uint32_t i = 0; i < node->edge_count(); ++i) {
+      const size_t idx = node->edge_index() + i;
+      const DirectedEdge* edge = unchecked ? t.directededge_unchecked(idx) : t.directededge(idx);
+      const uint32_t end = edge->endnode().id();
+      ++relaxed;
+      if (!visited[end]) {
+        visited[end] = true;
+        queue.push_back(end);
+      }
+    }
+  }
+  return relaxed;
+}
+
+void unchecked_access() {
+  //a grid of nodes each with an edge to its 4 neighbors
+  const uint32_t n = 300;
+  std::vector<NodeInfo> nodes(n * n);
+  std::vector<DirectedEdge> edges;
+  for (uint32_t y = 0; y < n; ++y) {
+    for (uint32_t x = 0; x < n; ++x) {
+      nodes[y * n + x].set_edge_index(edges.size());
+      int dx[] = { 1, -1, 0, 0 }, dy[] = { 0, 0, 1, -1 };
+      for (int d = 0; d < 4; ++d) {
+        int nx = x + dx[d], ny = y + dy[d];
+        if (nx < 0 || ny < 0 || nx >= int(n) || ny >= int(n))
+          continue;
+        edges.emplace_back();
+        edges.back().set_endnode(GraphId(0, 0, ny * n + nx));
+      }
+      nodes[y * n + x].set_edge_count(edges.size() - nodes[y * n + x].edge_index());
+    }
+  }
+  std::string text;
+  std::vector<Sign> signs;
+  std::vector<AccessRestriction> restrictions;
+  std::vector<TransitDeparture> departures;
+  std::vector<TransitSchedule> schedules;
+  testable_graphtile t(signs, restrictions, departures, schedules, text);
+  t.set_graph(nodes, edges);
+
+  if(t.node_unchecked(5) != t.node(size_t(5)) ||
+     t.directededge_unchecked(7) != t.directededge(size_t(7)))
+    throw std::logic_error("Unchecked accessors should match the checked ones");
+  if(kCheckedAccess) {
+    try {
+      t.node_unchecked(nodes.size());
+      throw std::logic_error("Checked builds should still check bounds");
+    } catch (const std::runtime_error&) { }
+  }
+  try {
+    t.directededge(edges.size());
+    throw std::logic_error("Checked accessor should throw");
+  } catch (const std::runtime_error& e) {
+    if(std::string(e.what()).find("directededgecount= " + std::to_string(edges.size())) ==
+       std::string::npos)
+      throw std::logic_error("Wrong out of bounds message");
+  }
+
+  //the expansion loop relaxes the same edges with either accessor
+  std::vector<uint32_t> queue;
+  std::vector<bool> visited(nodes.size());
+  if (expand<false>(t, queue, visited) != edges.size() ||
+      expand<true>(t, queue, visited) != edges.size())
+    throw std::logic_error("Expansions should relax every edge");
+}
+
+void statistics() {
+  //two motorway edges and a footway in both directions
+  std::vector<NodeInfo> nodes(2);
+  nodes[0].set_edge_count(2);
+  nodes[1].set_edge_index(2);
+  nodes[1].set_edge_count(2);
+  std::vector<DirectedEdge> edges(4);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    bool foot = i % 2;
+    edges[i].set_classification(foot ? RoadClass::kServiceOther : RoadClass::kMotorway);
+    edges[i].set_use(foot ? Use::kFootway : Use::kRoad);
+    edges[i].set_length(foot ? 10 : 100);
+    edges[i].set_forwardaccess(foot ? kPedestrianAccess : kAutoAccess);
+    edges[i].set_reverseaccess(foot ? kPedestrianAccess : 0);
+  }
+  edges[2].set_shortcut(1);
+  std::string text("\0Main St\0", 9);
+  std::vector<Sign> signs = { {1, Sign::Type::kExitNumber, 1} };
+  std::vector<AccessRestriction> restrictions;
+  std::vector<TransitDeparture> departures;
+  std::vector<TransitSchedule> schedules;
+  testable_graphtile t(signs, restrictions, departures, schedules, text);
+  t.set_graph(nodes, edges);
+
+  const TileStatistics& stats = t.GetStatistics();
+  if(&stats != &t.GetStatistics())
+    throw std::logic_error("Statistics should be computed once");
+  if(stats.tile_count != 1 || stats.node_count != 2 || stats.edge_count != 4 ||
+     stats.shortcut_count != 1 || stats.length != 220 || stats.textlist_bytes != 9 ||
+     stats.sign_count != 1)
+    throw std::logic_error("Wrong tile statistics");
+  if(stats.edges(RoadClass::kMotorway) != 2 || stats.edges(Use::kFootway) != 2 ||
+     stats.length_by_class[static_cast<size_t>(RoadClass::kServiceOther)] != 20 ||
+     stats.forward_access[0] != 2 || stats.forward_access[1] != 2 ||
+     stats.reverse_access[0] != 0 || stats.reverse_access[1] != 2)
+    throw std::logic_error("Wrong tile histograms");
+
+  TileStatistics total;
+  total += stats;
+  total += stats;
+  if(total.tile_count != 2 || total.length != 440 || total.edges(Use::kRoad) != 4)
+    throw std::logic_error("Wrong summed statistics");
+}
+
+void one_stops() {
+  //one stop and two routes of one operator, lines 3 and 5
+  std::string text("\0s-stop\0r-one\0r-two\0o-op\0", 25);
+  std::vector<TransitStop> stops = { {1, 1} };
+  std::vector<TransitRoute> routes = {
+    {0, 8, 20, 0, 0, 0, 0, 0, 0, 0}, {0, 14, 20, 0, 0, 0, 0, 0, 0, 0}
+  };
+  std::vector<Sign> signs;
+  std::vector<AccessRestriction> restrictions;
+  std::vector<TransitSchedule> schedules = { {1, 0x7f, 0} };
+  std::vector<TransitDeparture> departures = {
+    {3, 30, 0, 0, 0, 100, 10, 0, false, false},
+    {3, 31, 0, 0, 0, 200, 10, 0, false, false},
+    {5, 50, 1, 0, 0, 50, 10, 0, false, false}
+  };
+  testable_graphtile t(signs, restrictions, departures, schedules, text);
+  t.set_transit(GraphId(7, 3, 0), stops, routes);
+
+  const auto& stop_map = t.GetStopOneStops();
+  if(stop_map.size() != 1 || stop_map.at("s-stop") != tile_index_pair(7, 0))
+    throw std::logic_error("Wrong stop onestops");
+  const auto& route_map = t.GetRouteOneStops();
+  if(route_map.size() != 2 ||
+     route_map.at("r-one") != std::list<tile_index_pair>{ {7, 3} } ||
+     route_map.at("r-two") != std::list<tile_index_pair>{ {7, 5} })
+    throw std::logic_error("Wrong route onestops");
+  auto operator_map = t.GetOperatorOneStops();
+  if(operator_map.size() != 1 ||
+     operator_map["o-op"] != std::list<tile_index_pair>{ {7, 3}, {7, 5} })
+    throw std::logic_error("Wrong operator onestops");
+
+  //the flat indexes hold the same pairs and are built once
+  const OneStopIndexes& indexes = t.GetOneStopIndexes();
+  auto op = indexes.operators.find(TextView("o-op", 4));
+  if(&indexes != &t.GetOneStopIndexes() || &route_map != &t.GetRouteOneStops() ||
+     indexes.stops.size() != 1 || indexes.routes.size() != 2 ||
+     std::vector<tile_index_pair>(op.begin(), op.end()) !=
+       std::vector<tile_index_pair>{ {7, 3}, {7, 5} })
+    throw std::logic_error("Wrong onestop indexes");
+
+  //only transit tiles have onestops
+  testable_graphtile road(signs, restrictions, departures, schedules, text);
+  road.set_transit(GraphId(7, 2, 0), stops, routes);
+  if(!road.GetStopOneStops().empty() || !road.GetRouteOneStops().empty())
+    throw std::logic_error("Road tiles should have no onestops");
 }
 
 int main() {
@@ -76,5 +664,25 @@ int main() {
 
   suite.test(TEST_CASE(bin));
 
+  suite.test(TEST_CASE(lookups));
+
+  suite.test(TEST_CASE(multi_day_departures));
+
+  suite.test(TEST_CASE(long_horizon));
+
+  suite.test(TEST_CASE(realtime));
+
+  suite.test(TEST_CASE(views));
+
+  suite.test(TEST_CASE(edgeinfo_ref));
+
+  suite.test(TEST_CASE(node_edges));
+
+  suite.test(TEST_CASE(unchecked_access));
+
+  suite.test(TEST_CASE(statistics));
+
+  suite.test(TEST_CASE(one_stops));
+
   return suite.tear_down();
 }
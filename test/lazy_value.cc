@@ -0,0 +1,64 @@
+#include "test.h"
+
+#include "baldr/lazy_value.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+void built_once() {
+  LazyValue<int> value;
+  int builds = 0;
+  auto build = [&builds]() { ++builds; return std::make_shared<const int>(7); };
+  const int& first = value.get(build);
+  if (first != 7 || &value.get(build) != &first || builds != 1)
+    throw std::logic_error("Value should be built on first use only");
+
+  //copies share the built value
+  LazyValue<int> copy(value), assigned;
+  assigned = value;
+  if (&copy.get(build) != &first || &assigned.get(build) != &first || builds != 1)
+    throw std::logic_error("Copies should share the value");
+}
+
+void concurrent_first_use() {
+  //threads racing on the first use all get the value published first
+  for (int round = 0; round < 200; ++round) {
+    LazyValue<std::vector<int>> value;
+    std::atomic<int> builds(0);
+    std::vector<const std::vector<int>*> got(4, nullptr);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < got.size(); ++t) {
+      threads.emplace_back([&value, &builds, &got, t]() {
+        got[t] = &value.get([&builds]() {
+          ++builds;
+          return std::make_shared<const std::vector<int>>(100, 1);
+        });
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+    for (const auto* v : got) {
+      if (v != got.front() || v->size() != 100)
+        throw std::logic_error("Threads should share one value");
+    }
+    if (builds < 1 || &value.get([]() { return nullptr; }) != got.front())
+      throw std::logic_error("Value should stay published");
+  }
+}
+
+}
+
+int main() {
+  test::suite suite("lazy_value");
+
+  suite.test(TEST_CASE(built_once));
+
+  suite.test(TEST_CASE(concurrent_first_use));
+
+  return suite.tear_down();
+}
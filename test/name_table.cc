@@ -0,0 +1,118 @@
+#include "test.h"
+
+#include "baldr/name_table.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace valhalla::baldr;
+
+// Counts heap allocations so lookups can be checked to make none
+std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size) {
+  ++allocations;
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+void intern() {
+  NameTable& table = NameTable::instance();
+  std::string main("Main St");
+  uint32_t id = table.Intern(TextView(main.data(), main.size()));
+  if (table.Intern(TextView("Main St", 7)) != id || table.Find(TextView("Main St", 7)) != id ||
+      table.Name(id) != "Main St")
+    throw std::logic_error("Same name should get the same id");
+  if (table.Find(TextView("Elm St", 6)) != kInvalidNameId)
+    throw std::logic_error("Name should not be interned yet");
+  if (table.Intern(TextView("Elm St", 6)) == id)
+    throw std::logic_error("Different names should get different ids");
+
+  //lookups of names longer than any small string buffer do not allocate
+  const char* avenue = "Boulevard of the Allied Forces Avenue";
+  uint32_t avenue_id = table.Intern(TextView(avenue, std::strlen(avenue)));
+  size_t before = allocations;
+  if (table.Find(TextView(avenue, std::strlen(avenue))) != avenue_id ||
+      table.Intern(TextView(avenue, std::strlen(avenue))) != avenue_id ||
+      table.Find(TextView(avenue, 20)) != kInvalidNameId || allocations != before)
+    throw std::logic_error("Looking up a name should not allocate");
+}
+
+void concurrent_intern() {
+  // Threads interning the same names must agree on the ids
+  std::vector<std::vector<uint32_t>> ids(4);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < ids.size(); t++) {
+    threads.emplace_back([&ids, t]() {
+      for (int i = 0; i < 1000; i++) {
+        std::string name = "Street " + std::to_string(i);
+        ids[t].push_back(NameTable::instance().Intern(TextView(name.data(), name.size())));
+      }
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  for (const auto& i : ids)
+    if (i != ids.front())
+      throw std::logic_error("Threads should get the same ids");
+}
+
+void tile_ids() {
+  // Two text lists (tiles) with repeated names at different offsets
+  std::string a("\0Main St\0Elm St\0Main St\0Oak St\0Elm St\0", 38);
+  std::string b("\0Oak St\0Main St\0", 16);
+  TileNameIds tile_a(a.data(), a.size()), tile_b(b.data(), b.size());
+
+  if (tile_a.local(16) != 1 || tile_a.local(31) != 9 || tile_a.local(1) != 1 ||
+      tile_a.local(24) != 24 || tile_a.local(0) != 0)
+    throw std::logic_error("Repeated names should get the first offset");
+  if (tile_a.global(16) != tile_a.global(1) || tile_a.global(1) != tile_b.global(8) ||
+      tile_a.global(24) != tile_b.global(1) || tile_a.global(9) == tile_a.global(1))
+    throw std::logic_error("Equal names should get the same global id");
+  if (NameTable::instance().Name(tile_b.global(8)) != "Main St")
+    throw std::logic_error("Wrong name for the global id");
+  //every name is interned up front, lookups neither intern nor allocate
+  const size_t names = NameTable::instance().size();
+  size_t before = allocations;
+  if (tile_a.global(31) != tile_a.global(9) || allocations != before ||
+      NameTable::instance().size() != names)
+    throw std::logic_error("Global ids should be precomputed");
+  //an offset within a name gets the id of its tail
+  if (NameTable::instance().Name(tile_a.global(6)) != "St")
+    throw std::logic_error("Wrong global id within a name");
+  try {
+    tile_b.global(16);
+    throw std::logic_error("Offset past the text list should throw");
+  } catch (const std::runtime_error&) { }
+
+  std::vector<uint32_t> common;
+  common_name_ids({ 1, 4, 7, 9 }, { 2, 4, 9, 11 }, common);
+  if (common != std::vector<uint32_t>{ 4, 9 })
+    throw std::logic_error("Wrong common name ids");
+}
+
+}
+
+int main() {
+  test::suite suite("name_table");
+
+  suite.test(TEST_CASE(intern));
+
+  suite.test(TEST_CASE(concurrent_intern));
+
+  suite.test(TEST_CASE(tile_ids));
+
+  return suite.tear_down();
+}
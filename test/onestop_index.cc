@@ -0,0 +1,67 @@
+#include "test.h"
+
+#include "baldr/onestop_index.h"
+
+#include <string>
+#include <vector>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+std::vector<tile_index_pair> pairs(const OneStopIndex& index, const std::string& onestop) {
+  auto found = index.find(TextView(onestop.data(), onestop.size()));
+  return std::vector<tile_index_pair>(found.begin(), found.end());
+}
+
+void lookup() {
+  std::string text("r-b\0r-a\0r-ab\0", 13);
+  OneStopIndex index({
+    { TextView(text.data(), 3), {1, 5} },
+    { TextView(text.data() + 4, 3), {1, 2} },
+    { TextView(text.data(), 3), {1, 3} },
+    { TextView(text.data() + 8, 4), {2, 7} },
+    { TextView(text.data(), 3), {1, 5} }
+  });
+  //the text is copied
+  text.assign(text.size(), 'x');
+
+  if(index.size() != 3)
+    throw std::logic_error("Wrong number of onestop ids");
+  if(pairs(index, "r-b") != std::vector<tile_index_pair>{ {1, 3}, {1, 5} })
+    throw std::logic_error("Pairs should be sorted and unique");
+  if(pairs(index, "r-a") != std::vector<tile_index_pair>{ {1, 2} } ||
+     pairs(index, "r-ab") != std::vector<tile_index_pair>{ {2, 7} })
+    throw std::logic_error("Wrong pairs");
+  if(!pairs(index, "r-").empty() || !pairs(index, "r-c").empty() || !pairs(index, "").empty())
+    throw std::logic_error("Missing onestop ids should have no pairs");
+  if(index.entry(0).onestop != "r-a" || index.entry(2).onestop != "r-b")
+    throw std::logic_error("Entries should be sorted by onestop id");
+
+  OneStopIndex empty;
+  if(empty.size() != 0 || !pairs(empty, "r-a").empty())
+    throw std::logic_error("Empty index should have nothing");
+}
+
+void merge() {
+  std::string text("o-a\0o-b\0", 8);
+  OneStopIndex a({ { TextView(text.data(), 3), {1, 1} }, { TextView(text.data() + 4, 3), {1, 2} } });
+  OneStopIndex b({ { TextView(text.data(), 3), {2, 9} } });
+  OneStopIndex merged = OneStopIndex::merge({ &a, &b });
+  if(merged.size() != 2 ||
+     pairs(merged, "o-a") != std::vector<tile_index_pair>{ {1, 1}, {2, 9} } ||
+     pairs(merged, "o-b") != std::vector<tile_index_pair>{ {1, 2} })
+    throw std::logic_error("Wrong merged pairs");
+}
+
+}
+
+int main() {
+  test::suite suite("onestop_index");
+
+  suite.test(TEST_CASE(lookup));
+
+  suite.test(TEST_CASE(merge));
+
+  return suite.tear_down();
+}
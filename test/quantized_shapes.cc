@@ -0,0 +1,201 @@
+#include "test.h"
+
+#include "baldr/quantized_shapes.h"
+#include "baldr/edgeshape.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <valhalla/midgard/constants.h>
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace {
+
+using shapes_t = std::vector<std::pair<uint32_t, std::vector<PointLL>>>;
+
+shapes_t make_shapes(const size_t count, const int max_length) {
+  std::mt19937 gen(23);
+  std::uniform_real_distribution<float> start(0.f, .25f);
+  std::uniform_real_distribution<float> step(-.002f, .002f);
+  std::uniform_int_distribution<int> length(1, max_length);
+  shapes_t shapes;
+  for (size_t i = 0; i < count; i++) {
+    std::vector<PointLL> shape{ PointLL(start(gen) + 4.f, start(gen) + 52.f) };
+    for (int j = length(gen); j > 1; j--)
+      shape.emplace_back(shape.back().lng() + step(gen), shape.back().lat() + step(gen));
+    // Edge info offsets are not in order
+    shapes.emplace_back((count - i) * 40, shape);
+  }
+  return shapes;
+}
+
+// Brute force closest segment, same approximation as the kernels
+std::pair<float, uint32_t> closest(const PointLL& pt, const std::vector<PointLL>& shape) {
+  float mx = kMetersPerDegreeLat * std::cos(pt.lat() * kRadPerDeg);
+  if (shape.size() == 1) {
+    float dx = (shape[0].lng() - pt.lng()) * mx, dy = (shape[0].lat() - pt.lat()) * kMetersPerDegreeLat;
+    return { std::sqrt(dx * dx + dy * dy), 0 };
+  }
+  std::pair<float, uint32_t> best{ std::numeric_limits<float>::max(), 0 };
+  for (size_t i = 0; i + 1 < shape.size(); i++) {
+    float ax = (shape[i].lng() - pt.lng()) * mx, ay = (shape[i].lat() - pt.lat()) * kMetersPerDegreeLat;
+    float bx = (shape[i + 1].lng() - pt.lng()) * mx, by = (shape[i + 1].lat() - pt.lat()) * kMetersPerDegreeLat;
+    float dx = bx - ax, dy = by - ay, len = dx * dx + dy * dy;
+    float t = len > 0 ? std::min(std::max(-(ax * dx + ay * dy) / len, 0.f), 1.f) : 0.f;
+    float d = std::sqrt((ax + t * dx) * (ax + t * dx) + (ay + t * dy) * (ay + t * dy));
+    if (d < best.first)
+      best = { d, static_cast<uint32_t>(i) };
+  }
+  return best;
+}
+
+void kernel() {
+  // Every length around the SIMD widths, including zero length segments
+  std::mt19937 gen(4);
+  std::uniform_int_distribution<int32_t> coord(-100000, 100000);
+  for (uint32_t count = 2; count < 40; count++) {
+    std::vector<int32_t> x(count), y(count);
+    for (uint32_t i = 0; i < count; i++) {
+      x[i] = i % 7 == 3 ? x[i - 1] : coord(gen);
+      y[i] = i % 7 == 3 ? y[i - 1] : coord(gen);
+    }
+    std::vector<float> distances(count - 1);
+    squared_segment_distances(x.data(), y.data(), count, 50, -50, .007f, .011f, distances.data());
+    for (uint32_t i = 0; i + 1 < count; i++) {
+      float ax = (x[i] - 50) * .007f, ay = (y[i] + 50) * .011f;
+      float dx = (x[i + 1] - x[i]) * .007f, dy = (y[i + 1] - y[i]) * .011f;
+      float len = dx * dx + dy * dy;
+      float t = len > 0 ? std::min(std::max(-(ax * dx + ay * dy) / len, 0.f), 1.f) : 0.f;
+      float expected = (ax + t * dx) * (ax + t * dx) + (ay + t * dy) * (ay + t * dy);
+      if (std::fabs(distances[i] - expected) > expected * 1e-4f + 1e-3f)
+        throw std::logic_error("Wrong squared distance from the kernel");
+    }
+  }
+}
+
+void closest_segment() {
+  auto shapes = make_shapes(500, 150);
+  QuantizedShapes quantized(shapes);
+  // Used in place from its own buffer, as it would be from a tile section
+  QuantizedShapes section(quantized.data(), quantized.size());
+  if (quantized.edge_count() != shapes.size() || section.edge_count() != shapes.size())
+    throw std::logic_error("Wrong number of edges");
+
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<float> coord(0.f, .25f);
+  for (int q = 0; q < 20; q++) {
+    PointLL pt(coord(gen) + 4.f, coord(gen) + 52.f);
+    for (const auto& shape : shapes) {
+      auto expected = closest(pt, shape.second);
+      auto found = section.closest(shape.first, pt);
+      if (std::fabs(found.distance - expected.first) > .05f)
+        throw std::logic_error("Wrong closest distance");
+      if (found.segment != expected.second &&
+          std::fabs(closest(pt, { shape.second[found.segment], shape.second[found.segment + 1] }).first -
+                    expected.first) > .05f)
+        throw std::logic_error("Wrong closest segment");
+    }
+  }
+
+  auto run = quantized.shape(shapes[7].first);
+  if (run.count != shapes[7].second.size() ||
+      std::fabs(quantized.point(run, 0).lng() - shapes[7].second[0].lng()) > 1e-6f ||
+      std::fabs(quantized.point(run, 0).lat() - shapes[7].second[0].lat()) > 1e-6f)
+    throw std::logic_error("Wrong shape run");
+  if (quantized.shape(41).count != 0 ||
+      quantized.closest(41, PointLL(4.f, 52.f)).distance != std::numeric_limits<float>::max())
+    throw std::logic_error("Unknown edge should not be found");
+}
+
+void far_queries() {
+  // Shapes just west of the antimeridian
+  shapes_t shapes;
+  for (const auto& shape : make_shapes(50, 20)) {
+    std::vector<PointLL> moved;
+    for (const auto& p : shape.second)
+      moved.emplace_back(p.lng() + 175.7f, p.lat() - 52.f);
+    shapes.emplace_back(shape.first, moved);
+  }
+  QuantizedShapes quantized(shapes);
+
+  // Across the antimeridian and more than half a turn away, each measured
+  // the short way around
+  for (const auto& query : { std::make_pair(PointLL(-179.95f, .1f), PointLL(180.05f, .1f)),
+                             std::make_pair(PointLL(-60.f, 10.f), PointLL(300.f, 10.f)),
+                             std::make_pair(PointLL(0.f, -89.f), PointLL(0.f, -89.f)) }) {
+    for (const auto& shape : shapes) {
+      auto expected = closest(query.second, shape.second);
+      auto found = quantized.closest(shape.first, query.first);
+      if (std::fabs(found.distance - expected.first) > expected.first * 1e-4f + .05f)
+        throw std::logic_error("Wrong closest distance for a far query");
+    }
+  }
+}
+
+// encode7: zigzag varint deltas, lat then lng, 1e-6 precision
+void serialize(const int32_t number, std::string& output) {
+  uint32_t value = number < 0 ? ~(static_cast<uint32_t>(number) << 1) : number << 1;
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>(0x80 | (value & 0x7f)));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+std::string encode(const std::vector<PointLL>& points) {
+  std::string output;
+  int32_t lat = 0, lng = 0;
+  for (const auto& p : points) {
+    int32_t plat = std::round(p.lat() * 1e6), plng = std::round(p.lng() * 1e6);
+    serialize(plat - lat, output);
+    serialize(plng - lng, output);
+    lat = plat;
+    lng = plng;
+  }
+  return output;
+}
+
+void matches_encoded() {
+  // Closest segment distances from the fixed point runs match those measured
+  // on the decoded encode7 shapes
+  auto shapes = make_shapes(500, 30);
+  std::vector<std::string> encoded;
+  for (const auto& shape : shapes)
+    encoded.push_back(encode(shape.second));
+  QuantizedShapes quantized(shapes);
+  std::vector<PointLL> queries;
+  for (int i = 0; i < 20; i++)
+    queries.emplace_back(4.f + i * .01f, 52.f + i * .01f);
+
+  float total = 0.f;
+  std::vector<PointLL> shape;
+  for (const auto& pt : queries) {
+    for (size_t i = 0; i < shapes.size(); i++) {
+      decode_shape7(encoded[i].data(), encoded[i].size(), shape);
+      total += closest(pt, shape).first - quantized.closest(shapes[i].first, pt).distance;
+    }
+  }
+  if (std::fabs(total) > shapes.size() * queries.size() * .2f)
+    throw std::logic_error("Distances should match");
+}
+
+}
+
+int main() {
+  test::suite suite("quantized_shapes");
+
+  suite.test(TEST_CASE(kernel));
+
+  suite.test(TEST_CASE(closest_segment));
+
+  suite.test(TEST_CASE(far_queries));
+
+  suite.test(TEST_CASE(matches_encoded));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,164 @@
+#include "test.h"
+
+#include "baldr/realtime_overlay.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+void trip_delays() {
+  RealtimeDelays delays;
+  GraphId tile(10, 3, 0);
+  delays.Add(tile, 1, { false, 60, { { 7, 120 }, { 3, -30 } } });
+  delays.Add(tile, 2, { true, 0, {} });
+  if (delays.tile(GraphId(11, 3, 0)) != nullptr || delays.tile(tile) == nullptr)
+    throw std::logic_error("Wrong tile updates");
+
+  const auto* updates = delays.tile(tile);
+  if (updates->trip(3) != nullptr || !updates->trip(2)->cancelled)
+    throw std::logic_error("Wrong trip updates");
+  //a stop delay or else the trip's delay
+  const TripUpdate* update = updates->trip(1);
+  if (update->delay_at(7) != 120 || update->delay_at(3) != -30 || update->delay_at(5) != 60)
+    throw std::logic_error("Wrong stop delay");
+  if (updates->min_delay != -30 || updates->max_delay != 120)
+    throw std::logic_error("Wrong range of delays");
+
+  //updates are kept by tile whatever Id within the tile they are given by
+  delays.Add(GraphId(10, 3, 42), 4, { false, 300, {} });
+  if (delays.tile(tile)->trip(4) == nullptr || delays.tile(GraphId(10, 3, 7)) != updates ||
+      delays.tile(tile)->max_delay != 300)
+    throw std::logic_error("Updates should be kept by tile");
+}
+
+void publish() {
+  RealtimeOverlay overlay;
+  if (overlay.delays() != nullptr)
+    throw std::logic_error("Should be no updates before publishing");
+  auto first = std::make_shared<RealtimeDelays>();
+  first->Add(GraphId(1, 3, 0), 1, { false, 60, {} });
+  overlay.Publish(first);
+  if (overlay.delays() != first || overlay.delays() != first)
+    throw std::logic_error("Should read the published updates");
+
+  //each overlay keeps its own updates
+  RealtimeOverlay other;
+  auto second = std::make_shared<RealtimeDelays>();
+  other.Publish(second);
+  if (other.delays() != second || overlay.delays() != first || other.delays() != second)
+    throw std::logic_error("Overlays should not share updates");
+  overlay.Publish(nullptr);
+  if (overlay.delays() != nullptr)
+    throw std::logic_error("Updates should be cleared");
+}
+
+void alternating_overlays() {
+  //one thread reading two overlays in turn sees each one's latest updates
+  RealtimeOverlay a, b;
+  std::weak_ptr<const RealtimeDelays> last;
+  for (int32_t batch = 0; batch < 4; ++batch) {
+    auto first = std::make_shared<RealtimeDelays>();
+    auto second = std::make_shared<RealtimeDelays>();
+    first->Add(GraphId(1, 3, 0), 1, { false, batch, {} });
+    second->Add(GraphId(1, 3, 0), 1, { false, -batch, {} });
+    last = first;
+    a.Publish(first);
+    b.Publish(second);
+    for (int i = 0; i < 3; ++i) {
+      if (b.delays() != second || a.delays() != first)
+        throw std::logic_error("Overlays read in turn should keep their own updates");
+    }
+  }
+
+  //superseded batches are not kept alive by the readers
+  a.Publish(nullptr);
+  if (!last.expired())
+    throw std::logic_error("Superseded updates should be freed");
+}
+
+void reader() {
+  //a reader keeps the updates it saw, publishing waits for it
+  RealtimeOverlay overlay;
+  if (RealtimeOverlay::Reader(&overlay).delays() != nullptr ||
+      RealtimeOverlay::Reader(nullptr).delays() != nullptr)
+    throw std::logic_error("Should be no updates to read");
+  auto first = std::make_shared<RealtimeDelays>();
+  std::weak_ptr<const RealtimeDelays> seen = first;
+  overlay.Publish(std::move(first));
+  std::atomic<bool> published(false);
+  std::thread publisher;
+  {
+    RealtimeOverlay::Reader read(&overlay);
+    publisher = std::thread([&overlay, &published]() {
+      overlay.Publish(std::make_shared<RealtimeDelays>());
+      published = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    if (published || read.delays() != seen.lock().get())
+      throw std::logic_error("Publishing should wait for the reader");
+  }
+  publisher.join();
+  if (!published || !seen.expired() || overlay.delays() == nullptr)
+    throw std::logic_error("Superseded updates should be freed after the reader");
+}
+
+void concurrent_publish() {
+  //readers always see a whole batch while batches are swapped in
+  RealtimeOverlay overlay;
+  std::atomic<bool> done(false);
+  std::atomic<uint32_t> torn(0);
+  auto check = [&torn](const RealtimeDelays* delays) {
+    if (!delays)
+      return;
+    const auto* a = delays->tile(GraphId(1, 3, 0));
+    const auto* b = delays->tile(GraphId(2, 3, 0));
+    if (!a || !b || a->trip(1)->delay != b->trip(1)->delay)
+      ++torn;
+  };
+  //shared copies and readers, whose batches are freed as soon as they are
+  //superseded and the readers are done
+  auto read = [&]() {
+    while (!done) {
+      check(overlay.delays().get());
+      RealtimeOverlay::Reader reader(&overlay);
+      check(reader.delays());
+    }
+  };
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i)
+    readers.emplace_back(read);
+  for (int32_t batch = 0; batch < 2000; ++batch) {
+    auto delays = std::make_shared<RealtimeDelays>();
+    delays->Add(GraphId(1, 3, 0), 1, { false, batch, {} });
+    delays->Add(GraphId(2, 3, 0), 1, { false, batch, {} });
+    overlay.Publish(delays);
+  }
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+  if (torn != 0)
+    throw std::logic_error("Readers should see whole batches");
+}
+
+}
+
+int main() {
+  test::suite suite("realtime_overlay");
+
+  suite.test(TEST_CASE(trip_delays));
+
+  suite.test(TEST_CASE(publish));
+
+  suite.test(TEST_CASE(alternating_overlays));
+
+  suite.test(TEST_CASE(reader));
+
+  suite.test(TEST_CASE(concurrent_publish));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,58 @@
+#include "test.h"
+
+#include "baldr/record_index.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+void ranges() {
+  std::mt19937 gen(7);
+  for (uint32_t count = 0; count < 300; ++count) {
+    //keys spread over a few words with gaps and repeats
+    std::uniform_int_distribution<uint32_t> dist(0, count * 2);
+    std::vector<uint32_t> keys(count);
+    for (auto& k : keys)
+      k = dist(gen);
+    std::sort(keys.begin(), keys.end());
+    RecordIndex index(keys.data(), count, [](const uint32_t k) { return k; });
+    for (uint32_t k = 0; k <= count * 2 + 130; ++k) {
+      auto lower = std::lower_bound(keys.begin(), keys.end(), k) - keys.begin();
+      auto upper = std::upper_bound(keys.begin(), keys.end(), k) - keys.begin();
+      auto range = index.range(k);
+      if (index.has(k) != (lower != upper))
+        throw std::logic_error("Wrong has for key");
+      if (lower == upper && (range.first != count || range.second != count))
+        throw std::logic_error("Missing key should give an empty range at the end");
+      if (lower != upper && (range.first != lower || range.second != upper))
+        throw std::logic_error("Wrong range for key");
+    }
+    auto distinct = std::unique(keys.begin(), keys.end()) - keys.begin();
+    if (index.key_count() != distinct)
+      throw std::logic_error("Wrong key count");
+  }
+}
+
+void unsorted() {
+  std::vector<uint32_t> keys = { 3, 70, 5 };
+  try {
+    RecordIndex index(keys.data(), keys.size(), [](const uint32_t k) { return k; });
+    throw std::logic_error("Unsorted records should throw");
+  } catch (const std::runtime_error&) { }
+}
+
+}
+
+int main() {
+  test::suite suite("record_index");
+
+  suite.test(TEST_CASE(ranges));
+
+  suite.test(TEST_CASE(unsorted));
+
+  return suite.tear_down();
+}
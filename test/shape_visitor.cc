@@ -0,0 +1,133 @@
+#include "test.h"
+
+#include "baldr/edgeshape.h"
+#include "baldr/shape_visitor.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace {
+
+// encode7: zigzag varint deltas, lat then lng, 1e-6 precision
+void serialize(const int32_t number, std::string& output) {
+  uint32_t value = number < 0 ? ~(static_cast<uint32_t>(number) << 1) : number << 1;
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>(0x80 | (value & 0x7f)));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+std::string encode(const std::vector<PointLL>& points) {
+  std::string output;
+  int32_t lat = 0, lng = 0;
+  for (const auto& p : points) {
+    int32_t plat = std::round(p.lat() * 1e6), plng = std::round(p.lng() * 1e6);
+    serialize(plat - lat, output);
+    serialize(plng - lng, output);
+    lat = plat;
+    lng = plng;
+  }
+  return output;
+}
+
+// Counts the points decoded
+struct counting_decoder {
+  ShapeStream stream;
+  size_t* count;
+  PointLL pop() { ++*count; return stream.pop(); }
+  bool empty() const { return stream.empty(); }
+};
+
+// North then east, each leg about 1113m
+const std::vector<PointLL> kShape = { {0.f, 0.f}, {0.f, .01f}, {.01f, .01f} };
+
+bool near(const PointLL& a, const PointLL& b) {
+  return std::fabs(a.lng() - b.lng()) < 1e-6f && std::fabs(a.lat() - b.lat()) < 1e-6f;
+}
+
+void length_and_bounds() {
+  auto encoded = encode(kShape);
+  ShapeStream stream(encoded.data(), encoded.size());
+  float expected = kShape[0].Distance(kShape[1]) + kShape[1].Distance(kShape[2]);
+  if (std::fabs(shape_length(stream) - expected) > .01f)
+    throw std::logic_error("Wrong shape length");
+  auto box = shape_bounds(stream);
+  if (box.minx() != 0.f || box.miny() != 0.f || box.maxx() != .01f || box.maxy() != .01f)
+    throw std::logic_error("Wrong shape bounds");
+}
+
+void projection() {
+  auto encoded = encode(kShape);
+  ShapeStream stream(encoded.data(), encoded.size());
+  auto p = project(stream, PointLL(.005f, .012f));
+  float leg = kShape[0].Distance(kShape[1]);
+  if (p.segment != 1 || !near(p.point, PointLL(.005f, .01f)) ||
+      std::fabs(p.along - leg * 1.5f) > 1.f ||
+      std::fabs(p.distance - PointLL(.005f, .012f).Distance(PointLL(.005f, .01f))) > .01f)
+    throw std::logic_error("Wrong projection");
+
+  // Before the start of the shape
+  p = project(stream, PointLL(0.f, -.01f));
+  if (p.segment != 0 || !near(p.point, kShape.front()) || p.along != 0.f)
+    throw std::logic_error("Wrong projection before the start");
+}
+
+void trim() {
+  auto encoded = encode(kShape);
+  ShapeStream stream(encoded.data(), encoded.size());
+  std::vector<PointLL> partial;
+  trim_shape(stream, .25f, .75f, 0.f, partial);
+  if (partial.size() != 3 || !near(partial[0], PointLL(0.f, .005f)) ||
+      !near(partial[1], kShape[1]) || !near(partial[2], PointLL(.005f, .01f)))
+    throw std::logic_error("Wrong trimmed shape");
+
+  // Within the first segment, the last point should never be decoded
+  size_t count = 0;
+  float length = shape_length(stream);
+  trim_shape(counting_decoder{stream, &count}, .1f, .4f, length, partial);
+  if (partial.size() != 2 || count != 2)
+    throw std::logic_error("Trimming should stop at the end fraction");
+
+  trim_shape(stream, 0.f, 1.f, length, partial);
+  if (partial.size() != 3 || !near(partial.front(), kShape.front()) ||
+      !near(partial.back(), kShape.back()))
+    throw std::logic_error("Untrimmed shape should be the whole shape");
+}
+
+void heading_and_point() {
+  auto encoded = encode(kShape);
+  ShapeStream stream(encoded.data(), encoded.size());
+  size_t count = 0;
+  if (std::fabs(heading_at(counting_decoder{stream, &count}, 0.f)) > .1f || count != 2)
+    throw std::logic_error("Wrong heading at the start");
+  if (std::fabs(heading_at(stream, 1500.f) - 90.f) > .1f ||
+      std::fabs(heading_at(stream, 1e6f) - 90.f) > .1f)
+    throw std::logic_error("Wrong heading along the shape");
+
+  float leg = kShape[0].Distance(kShape[1]);
+  if (!near(point_at(stream, leg / 2), PointLL(0.f, .005f)) ||
+      !near(point_at(stream, 1e6f), kShape.back()) ||
+      !near(point_at(stream, 0.f), kShape.front()))
+    throw std::logic_error("Wrong point along the shape");
+}
+
+}
+
+int main() {
+  test::suite suite("shape_visitor");
+
+  suite.test(TEST_CASE(length_and_bounds));
+
+  suite.test(TEST_CASE(projection));
+
+  suite.test(TEST_CASE(trim));
+
+  suite.test(TEST_CASE(heading_and_point));
+
+  return suite.tear_down();
+}
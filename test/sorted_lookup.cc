@@ -0,0 +1,62 @@
+#include "test.h"
+
+#include "baldr/sorted_lookup.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+void lower_bound() {
+  std::mt19937 gen(5);
+  for (uint32_t count = 0; count < 300; ++count) {
+    std::uniform_int_distribution<uint32_t> dist(0, count);
+    std::vector<uint32_t> values(count);
+    for (auto& v : values)
+      v = dist(gen);
+    std::sort(values.begin(), values.end());
+    //look for every value in range plus one past the end
+    for (uint32_t v = 0; v <= count + 1; ++v) {
+      auto expected = std::lower_bound(values.begin(), values.end(), v) - values.begin();
+      auto found = branchless_lower_bound(values.data(), count,
+                     [v](const uint32_t value) { return value < v; });
+      if (found != expected)
+        throw std::logic_error("Wrong lower bound");
+    }
+  }
+}
+
+void composite_key() {
+  //sorted by first then second like departures by line and time
+  std::vector<std::pair<uint32_t, uint32_t>> items;
+  for (uint32_t line = 0; line < 10; ++line)
+    for (uint32_t time = 0; time < 100; time += 7)
+      items.emplace_back(line, time);
+  for (uint32_t line = 0; line < 11; ++line) {
+    for (uint32_t time = 0; time < 110; ++time) {
+      auto key = std::make_pair(line, time);
+      auto expected = std::lower_bound(items.begin(), items.end(), key) - items.begin();
+      auto found = branchless_lower_bound(items.data(), items.size(),
+          [line, time](const std::pair<uint32_t, uint32_t>& item) {
+            return item.first < line || (item.first == line && item.second < time);
+          });
+      if (found != expected)
+        throw std::logic_error("Wrong lower bound for composite key");
+    }
+  }
+}
+
+}
+
+int main() {
+  test::suite suite("sorted_lookup");
+
+  suite.test(TEST_CASE(lower_bound));
+
+  suite.test(TEST_CASE(composite_key));
+
+  return suite.tear_down();
+}
@@ -43,6 +43,41 @@ namespace {
     if(h.levels().rbegin()->second.importance != RoadClass::kServiceOther)
       throw runtime_error("Importance should be set to service/other");
   }
+
+  void test_graph_ids() {
+    TileHierarchy h("/data/valhalla");
+    if(!h.GetGraphIds(AABB2<PointLL>(-76.6f, 40.4f, -76.4f, 40.6f), 34).empty())
+      throw runtime_error("No tiles should be found for a level that doesn't exist");
+    //the box spans cols 413-414 and rows 521-522 at the local level
+    auto ids = h.GetGraphIds(AABB2<PointLL>(-76.6f, 40.4f, -76.4f, 40.6f), 2);
+    std::vector<GraphId> expected = {
+      {521 * 1440 + 413, 2, 0}, {521 * 1440 + 414, 2, 0},
+      {522 * 1440 + 413, 2, 0}, {522 * 1440 + 414, 2, 0}
+    };
+    if(ids != expected)
+      throw runtime_error("Unexpected tiles for bounding box");
+    //boxes past the poles are clamped to the last row
+    ids = h.GetGraphIds(AABB2<PointLL>(179.9f, 89.9f, 179.95f, 100.f), 0);
+    if(ids.size() != 1 || ids.front().tileid() != 45 * 90 - 1)
+      throw runtime_error("Expected only the last tile");
+    //boxes crossing the antimeridian, given either way, are split into the
+    //westernmost and easternmost columns
+    expected = { {44 * 90 + 0, 0, 0}, {44 * 90 + 1, 0, 0}, {44 * 90 + 2, 0, 0},
+                 {44 * 90 + 89, 0, 0} };
+    if(h.GetGraphIds(AABB2<PointLL>(179.9f, 89.9f, 190.f, 100.f), 0) != expected ||
+       h.GetGraphIds(AABB2<PointLL>(179.9f, 89.9f, -170.f, 100.f), 0) != expected ||
+       h.GetGraphIds(AABB2<PointLL>(-180.1f, 89.9f, -170.f, 100.f), 0) != expected)
+      throw runtime_error("Unexpected tiles across the antimeridian");
+    ids = h.GetGraphIds(AABB2<PointLL>(179.5f, -.5f, -179.5f, .5f), 1);
+    expected = { {89 * 360 + 0, 1, 0}, {89 * 360 + 359, 1, 0},
+                 {90 * 360 + 0, 1, 0}, {90 * 360 + 359, 1, 0} };
+    if(ids != expected)
+      throw runtime_error("Unexpected tiles across the antimeridian at the equator");
+    //boxes as wide as the world cover every column once
+    ids = h.GetGraphIds(AABB2<PointLL>(-177.f, 0.5f, 182.f, 0.5f), 0);
+    if(ids.size() != 90 || ids.front().tileid() != 22 * 90 || ids.back().tileid() != 23 * 90 - 1)
+      throw runtime_error("Expected every column once");
+  }
 }
 
 int main(void)
@@ -51,5 +86,7 @@ int main(void)
 
   suite.test(TEST_CASE(test_parse));
 
+  suite.test(TEST_CASE(test_graph_ids));
+
   return suite.tear_down();
 }
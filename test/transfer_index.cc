@@ -0,0 +1,63 @@
+#include "test.h"
+
+#include "baldr/transfer_index.h"
+
+#include <vector>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+void from_stop() {
+  std::vector<TransitTransfer> transfers = {
+    {5, 2, TransferType::kMinTime, 120},
+    {1, 3, TransferType::kTimed, 0},
+    {5, 1, TransferType::kNotPossible, 0},
+    {1, 2, TransferType::kRecommended, 30}
+  };
+  TransferIndex index(transfers.data(), transfers.size());
+  if (index.size() != 4)
+    throw std::logic_error("Wrong number of transfers");
+
+  //transfers from a stop are sorted by to stop
+  auto from = index.from(5);
+  if (from.size() != 2 || from.begin()[0].to_stopid() != 1 || from.begin()[1].to_stopid() != 2)
+    throw std::logic_error("Wrong transfers from stop 5");
+  if (index.from(1).size() != 2 || index.from(0).size() != 0 || index.from(6).size() != 0 ||
+      index.from(1000).size() != 0)
+    throw std::logic_error("Wrong number of transfers from stops");
+
+  if (index.find(1, 3) == nullptr || index.find(1, 3)->type() != TransferType::kTimed ||
+      index.find(3, 1) != nullptr || index.find(5, 3) != nullptr)
+    throw std::logic_error("Wrong transfer found");
+}
+
+void min_transfer_time() {
+  std::vector<TransitTransfer> transfers = {
+    {5, 2, TransferType::kMinTime, 120},
+    {5, 1, TransferType::kNotPossible, 0},
+    {1, 2, TransferType::kRecommended, 30}
+  };
+  TransferIndex index(transfers.data(), transfers.size());
+  if (index.min_transfer_time(5, 2, 60) != 120 ||
+      index.min_transfer_time(5, 1, 60) != TransferIndex::kNotPossible ||
+      index.min_transfer_time(1, 2, 60) != 0 ||
+      index.min_transfer_time(2, 1, 60) != 60)
+    throw std::logic_error("Wrong minimum transfer time");
+
+  TransferIndex empty(nullptr, 0);
+  if (empty.from(0).size() != 0 || empty.min_transfer_time(0, 1, 45) != 45)
+    throw std::logic_error("Empty index should have no transfers");
+}
+
+}
+
+int main() {
+  test::suite suite("transfer_index");
+
+  suite.test(TEST_CASE(from_stop));
+
+  suite.test(TEST_CASE(min_transfer_time));
+
+  return suite.tear_down();
+}
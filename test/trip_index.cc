@@ -0,0 +1,65 @@
+#include "test.h"
+
+#include "baldr/trip_index.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// Departures of a trip or block the slow way, in time order
+std::vector<uint32_t> naive(const std::vector<TransitDeparture>& departures,
+                            const uint32_t id, const bool block) {
+  std::vector<uint32_t> found;
+  for (uint32_t i = 0; i < departures.size(); ++i)
+    if ((block ? departures[i].blockid() : departures[i].tripid()) == id)
+      found.push_back(i);
+  std::stable_sort(found.begin(), found.end(), [&departures](uint32_t a, uint32_t b) {
+    return departures[a].departure_time() < departures[b].departure_time();
+  });
+  return found;
+}
+
+// Departures sorted by line then time, with trips spread over the lines
+std::vector<TransitDeparture> make_departures(std::mt19937& gen, const uint32_t count) {
+  std::uniform_int_distribution<uint32_t> line(1, 50), trip(1, count / 4 + 1),
+      block(0, 20), time(0, 86400);
+  std::vector<TransitDeparture> departures;
+  for (uint32_t i = 0; i < count; ++i)
+    departures.emplace_back(line(gen), trip(gen), 0, block(gen), 0, time(gen), 60, 0, false, false);
+  std::sort(departures.begin(), departures.end(), [](const TransitDeparture& a, const TransitDeparture& b) {
+    return a.lineid() < b.lineid() ||
+           (a.lineid() == b.lineid() && a.departure_time() < b.departure_time());
+  });
+  return departures;
+}
+
+void lookups() {
+  std::mt19937 gen(13);
+  for (uint32_t count : { 0u, 1u, 10u, 1000u }) {
+    auto departures = make_departures(gen, count);
+    TripIndex index(departures.data(), count);
+    for (uint32_t id = 0; id < count / 4 + 3; ++id) {
+      auto trip = index.trip(id);
+      if (std::vector<uint32_t>(trip.begin(), trip.end()) != naive(departures, id, false))
+        throw std::logic_error("Wrong trip departures");
+      auto block = index.block(id);
+      if (std::vector<uint32_t>(block.begin(), block.end()) !=
+          (id == 0 ? std::vector<uint32_t>() : naive(departures, id, true)))
+        throw std::logic_error("Wrong block departures");
+    }
+  }
+}
+
+}
+
+int main() {
+  test::suite suite("trip_index");
+
+  suite.test(TEST_CASE(lookups));
+
+  return suite.tear_down();
+}
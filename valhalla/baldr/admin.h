@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include <valhalla/midgard/util.h>
+#include <valhalla/baldr/text_view.h>
 
 namespace valhalla {
 namespace baldr {
@@ -41,6 +42,18 @@ class Admin {
    */
   const std::string state_iso() const;
 
+  /**
+   * Get a view of the country ISO code without copying it.
+   * @return  Returns the ISO country code.
+   */
+  TextView country_iso_view() const;
+
+  /**
+   * Get a view of the state ISO code without copying it.
+   * @return  Returns the state ISO code.
+   */
+  TextView state_iso_view() const;
+
   /**
    * Get the offset into the GraphTile text list for the state text associated
    * with the admin.
@@ -2,6 +2,7 @@
 #define VALHALLA_BALDR_ADMININFO_H_
 
 #include <valhalla/baldr/admin.h>
+#include <valhalla/baldr/text_view.h>
 #include <iostream>
 #include <boost/functional/hash.hpp>
 
@@ -75,6 +76,18 @@ class AdminInfo {
   std::string state_iso_;
 };
 
+/**
+ * Non-owning admin text. Country and state names point into the tile's
+ * text list and the ISO codes point into the admin record, so nothing is
+ * allocated. Only valid while the tile is alive.
+ */
+struct AdminView {
+  TextView country_text;
+  TextView state_text;
+  TextView country_iso;
+  TextView state_iso;
+};
+
 }
 }
 
@@ -0,0 +1,54 @@
+#ifndef VALHALLA_BALDR_CHECKED_ACCESS_H_
+#define VALHALLA_BALDR_CHECKED_ACCESS_H_
+
+#include <cstddef>
+
+/**
+ * Build policy for the unchecked tile accessors (GraphTile::node_unchecked
+ * and friends). By default their bounds checks are compiled in for debug
+ * builds and left out when NDEBUG is defined. Define
+ * VALHALLA_CHECKED_ACCESS to 1 or 0 to force the checks on or off.
+ */
+#ifndef VALHALLA_CHECKED_ACCESS
+#ifdef NDEBUG
+#define VALHALLA_CHECKED_ACCESS 0
+#else
+#define VALHALLA_CHECKED_ACCESS 1
+#endif
+#endif
+
+// Marks functions that only run on error paths so the compiler keeps them
+// (and the message building inside them) out of line and away from the
+// hot code that calls them.
+#if defined(__GNUC__)
+#define VALHALLA_COLD __attribute__((cold, noinline))
+#define VALHALLA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define VALHALLA_COLD
+#define VALHALLA_UNLIKELY(x) (x)
+#endif
+
+namespace valhalla {
+namespace baldr {
+
+// Whether the unchecked accessors check bounds in this build
+constexpr bool kCheckedAccess = VALHALLA_CHECKED_ACCESS != 0;
+
+/**
+ * Throws std::runtime_error for an index outside of a tile array. The
+ * message has the tile, the index and the array size.
+ * @param  what        Name of the array (e.g. "NodeInfo").
+ * @param  count_name  Name of the array size (e.g. "nodecount").
+ * @param  tileid      Tile Id.
+ * @param  level       Hierarchy level of the tile.
+ * @param  idx         Index that was requested.
+ * @param  count       Number of items in the array.
+ */
+[[noreturn]] VALHALLA_COLD void throw_out_of_bounds(const char* what,
+    const char* count_name, const size_t tileid, const size_t level,
+    const size_t idx, const size_t count);
+
+}
+}
+
+#endif  // VALHALLA_BALDR_CHECKED_ACCESS_H_
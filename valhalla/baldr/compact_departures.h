@@ -0,0 +1,197 @@
+#ifndef VALHALLA_BALDR_COMPACT_DEPARTURES_H_
+#define VALHALLA_BALDR_COMPACT_DEPARTURES_H_
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <valhalla/baldr/transitdeparture.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Compact, lossless encoding of a tile's transit departures. Departures
+ * are grouped by line and, within a line, each departure is stored as the
+ * differences from the one before it: the departure time and trip Id as
+ * variable length deltas and the other fields (route, headsign, block,
+ * schedule, elapsed time, flags) only when they change. Runs of departures
+ * at a constant headway whose trip Ids also step by a constant and whose
+ * other fields repeat are stored once as a frequency entry (count, headway,
+ * trip step). A busy line then takes a few bytes per departure instead of
+ * sizeof(TransitDeparture).
+ *
+ * The encoded bytes (see data()) start with a table of the lines and are
+ * self contained, so they can be written out and loaded back. Departures
+ * are decoded one line at a time by iterating a Line.
+ */
+class CompactDepartures {
+ public:
+  // Shortest run of departures stored as a frequency entry
+  static constexpr uint32_t kMinRun = 3;
+
+  /**
+   * Decoded fields of a departure.
+   */
+  struct Fields {
+    uint32_t lineid;
+    uint32_t tripid;
+    uint32_t routeid;
+    uint32_t blockid;
+    uint32_t headsign_offset;
+    uint32_t departure_time;
+    uint32_t elapsed_time;
+    uint32_t schedule_index;
+    bool wheelchair_accessible;
+    bool bicycle_accessible;
+
+    /**
+     * Get the departure.
+     * @return  Returns the departure with these fields.
+     */
+    TransitDeparture departure() const;
+  };
+
+  /**
+   * The departures of one line in time order, decoded as they are iterated.
+   */
+  class Line {
+   public:
+    class iterator : public std::iterator<std::input_iterator_tag, const Fields> {
+     public:
+      iterator(const uint8_t* data, const uint32_t lineid, const uint32_t count);
+      iterator& operator++() {
+        if (--left_ > 0)
+          decode();
+        return *this;
+      }
+      bool operator==(const iterator& other) const {
+        return left_ == other.left_;
+      }
+      bool operator!=(const iterator& other) const {
+        return left_ != other.left_;
+      }
+      const Fields& operator*() const {
+        return fields_;
+      }
+      const Fields* operator->() const {
+        return &fields_;
+      }
+
+      /**
+       * Advances to the first departure at or after a time (or the end).
+       * Frequency entries are stepped over without decoding each departure.
+       * @param  time  Time (seconds from midnight).
+       */
+      void seek(const uint32_t time);
+     protected:
+      const uint8_t* data_;
+      uint32_t left_;      // Departures left including the current one
+      uint32_t run_left_;  // Departures left in the current frequency entry
+      uint32_t headway_;
+      int32_t trip_step_;
+      Fields fields_;
+
+      // Decodes the next departure
+      void decode();
+    };
+
+    Line(const uint8_t* data, const uint32_t lineid, const uint32_t count)
+        : data_(data), lineid_(lineid), count_(count) {
+    }
+
+    iterator begin() const {
+      return iterator(data_, lineid_, count_);
+    }
+    iterator end() const {
+      return iterator(nullptr, lineid_, 0);
+    }
+
+    /**
+     * Get the number of departures on the line.
+     * @return  Returns the number of departures.
+     */
+    uint32_t size() const {
+      return count_;
+    }
+
+   protected:
+    const uint8_t* data_;
+    uint32_t lineid_;
+    uint32_t count_;
+  };
+
+  /**
+   * Constructor. Encodes departures. Throws if they are not sorted.
+   * @param  departures  Departures sorted by line Id then time.
+   * @param  count       Number of departures.
+   */
+  CompactDepartures(const TransitDeparture* departures, const uint32_t count);
+
+  /**
+   * Constructor. Loads previously encoded departures. Throws if the table
+   * of lines does not fit the data.
+   * @param  data  Encoded departures (see data()).
+   */
+  explicit CompactDepartures(std::string data);
+
+  /**
+   * Get the encoded departures.
+   * @return  Returns the encoded bytes.
+   */
+  const std::string& data() const;
+
+  /**
+   * Get the number of departures.
+   * @return  Returns the number of departures.
+   */
+  uint32_t size() const;
+
+  /**
+   * Get the departures of a line.
+   * @param  lineid  Line Id.
+   * @return  Returns the line's departures (empty if there are none).
+   */
+  Line line(const uint32_t lineid) const;
+
+  /**
+   * Finds the next departure on a line at or after a time, as
+   * GraphTile::GetNextDeparture does.
+   * @param  lineid      Line Id.
+   * @param  time        Current time (seconds from midnight).
+   * @param  active      Bitset of the schedules valid on the day (see
+   *                     DepartureTable::active_schedules).
+   * @param  wheelchair  Only find departures with wheelchair access if true.
+   * @param  bicycle     Only find departures with bicycle access if true.
+   * @param  found       Set to the departure if one is found.
+   * @return  Returns true if a departure is found.
+   */
+  bool next_departure(const uint32_t lineid, const uint32_t time,
+                      const std::vector<uint64_t>& active, const bool wheelchair,
+                      const bool bicycle, Fields& found) const;
+
+ protected:
+  /**
+   * Where the departures of a line are in the encoded bytes.
+   */
+  struct LineEntry {
+    uint32_t lineid;
+    uint32_t offset;
+    uint32_t count;
+  };
+
+  std::string data_;
+  std::vector<LineEntry> lines_;
+  uint32_t count_;
+
+  /**
+   * Reads the table of lines at the start of the data.
+   */
+  void load();
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_COMPACT_DEPARTURES_H_
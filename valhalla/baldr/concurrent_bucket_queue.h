@@ -0,0 +1,143 @@
+#ifndef VALHALLA_BALDR_CONCURRENT_BUCKET_QUEUE_H_
+#define VALHALLA_BALDR_CONCURRENT_BUCKET_QUEUE_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <valhalla/baldr/double_bucket_queue.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Label costs that can be lowered concurrently by several threads. Costs
+ * are stored as atomic floats indexed by label so that a compare and swap
+ * decides which thread wins an edge relaxation.
+ */
+class AtomicLabelCosts {
+ public:
+  /**
+   * Constructor given the number of labels. All costs start at infinity.
+   * @param  count  Number of labels.
+   */
+  explicit AtomicLabelCosts(const uint32_t count);
+
+  /**
+   * Get the number of labels.
+   * @return  Returns the label count.
+   */
+  uint32_t size() const;
+
+  /**
+   * Get the current cost of a label.
+   * @param  label  Label index.
+   * @return  Returns the cost of the label.
+   */
+  float cost(const uint32_t label) const;
+
+  /**
+   * Lowers the cost of a label if the new cost is less than the current
+   * cost. Safe to call from several threads at once.
+   * @param  label    Label index.
+   * @param  newcost  Candidate cost.
+   * @return  Returns true if this call lowered the cost.
+   */
+  bool relax(const uint32_t label, const float newcost);
+
+  /**
+   * Get a cost functor suitable for constructing bucket queues.
+   * @return  Returns a functor returning the current cost of a label.
+   */
+  LabelCost labelcost() const;
+
+ private:
+  uint32_t count_;
+  std::unique_ptr<std::atomic<float>[]> costs_;
+};
+
+/**
+ * Concurrent bucket queue with a relaxed priority order. Labels are spread
+ * over a set of DoubleBucketQueues (MultiQueue style), each guarded by its
+ * own lock. Adds go to a random queue and pops take the lower cost of two
+ * randomly chosen queues, so a pop returns a label close to, but not
+ * necessarily at, the global minimum cost.
+ *
+ * There is no decrease(): when a label improves add it again and skip stale
+ * entries on pop (compare the popped label's settled cost, e.g. through
+ * AtomicLabelCosts). A pop returning kInvalidLabel only means every queue
+ * was empty at the time of the call; termination of a parallel expansion
+ * must also check that no other thread is still relaxing edges.
+ */
+class ConcurrentBucketQueue {
+ public:
+  /**
+   * Constructor. Each of the queues is a DoubleBucketQueue constructed with
+   * the given cost range and bucket size.
+   * @param  queuecount  Number of queues. Use a small multiple (e.g. 2x)
+   *                     of the number of threads.
+   * @param  mincost     Minimum cost.
+   * @param  range       Cost range for low-level buckets.
+   * @param  bucketsize  Bucket size (range of costs within same bucket).
+   * @param  labelcost   Functor to get a cost given a label index. Called
+   *                     concurrently so it must be thread-safe.
+   */
+  ConcurrentBucketQueue(const uint32_t queuecount, const float mincost,
+                        const float range, const uint32_t bucketsize,
+                        const LabelCost& labelcost);
+
+  /**
+   * Clear all labels from all queues. Must not be called while other
+   * threads are using the queue.
+   */
+  void clear();
+
+  /**
+   * Adds a label index to a randomly chosen queue.
+   * @param   label  Label index to add.
+   * @param   cost   Cost for this label.
+   */
+  void add(const uint32_t label, const float cost);
+
+  /**
+   * Removes a low cost label index. Picks the lower cost of two random
+   * queues, falling back to scanning all queues if those are empty.
+   * @return  Returns a label index or kInvalidLabel if all queues are empty.
+   */
+  uint32_t pop();
+
+  /**
+   * Get the number of queues.
+   * @return  Returns the queue count.
+   */
+  uint32_t queuecount() const;
+
+ private:
+  // A queue, its lock and the lowest cost it may hold (infinity if empty).
+  // The cost hint is read without the lock to choose between queues.
+  struct Queue {
+    Queue(const float mincost, const float range, const uint32_t bucketsize,
+          const LabelCost& labelcost);
+    std::mutex lock;
+    std::atomic<float> mincost;
+    DoubleBucketQueue queue;
+  };
+  std::vector<std::unique_ptr<Queue>> queues_;
+
+  // Cost function to get cost given the label index.
+  LabelCost labelcost_;
+
+  /**
+   * Pops from the specified queue if its lock can be acquired.
+   * @param  q       Queue to pop from.
+   * @param  block   Wait for the lock rather than giving up.
+   * @return  Returns the label or kInvalidLabel if the queue was empty or
+   *          busy.
+   */
+  uint32_t pop(Queue& q, const bool block);
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_CONCURRENT_BUCKET_QUEUE_H_
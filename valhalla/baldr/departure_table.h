@@ -0,0 +1,446 @@
+#ifndef VALHALLA_BALDR_DEPARTURE_TABLE_H_
+#define VALHALLA_BALDR_DEPARTURE_TABLE_H_
+
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/transitdeparture.h>
+#include <valhalla/baldr/transitschedule.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * A departure found by a multi-day search and the day it runs on.
+ */
+struct DayDeparture {
+  const TransitDeparture* departure;  // Departure (nullptr if none found)
+  uint32_t day_offset;                // Days after the day searched from
+  int32_t delay;                      // Realtime delay (seconds), 0 if none
+};
+
+/**
+ * Days on which any departure of a line may run: the union of the day
+ * masks and days of week of the line's schedules. Used to skip days on
+ * which none of the line's departures can be valid without looking at any
+ * departures.
+ */
+struct ActiveDays {
+  uint64_t days;  // Union of the schedules' day masks
+  uint32_t dow;   // Union of the schedules' days of week
+
+  /**
+   * Might a departure be valid on a day? Never false for a day on which
+   * one of the schedules is valid.
+   * @param  day               Days since the tile creation date.
+   * @param  dow               Day of week mask (see graphconstants.h).
+   * @param  date_before_tile  Is the date before the tile creation date?
+   * @return  Returns false if no departure can be valid on the day.
+   */
+  bool may_run(const uint32_t day, const uint32_t dow,
+               const bool date_before_tile) const {
+    return (dow & this->dow) != 0 ||
+           (!date_before_tile && day < 64 && ((days >> day) & 1));
+  }
+};
+
+/**
+ * Columnar copy of a tile's transit departures for finding the next valid
+ * departure on a line. Departure times are kept in one contiguous array
+ * (in the tile's line then time order) and the wheelchair and bicycle
+ * flags as bitmaps. For a given service day the schedule of every
+ * departure is evaluated once into a validity bitmap, so finding the first
+ * usable departure at or after a time is a binary search on the times and
+ * then a scan over 64 departures per step (AND of the validity and flag
+ * bitmaps and a count trailing zeros) instead of a schedule lookup per
+ * departure. The bitsets of active schedules and the validity bitmaps of
+ * the most recently used days are cached, so requests for the same day
+ * share them. Safe to use from multiple threads.
+ */
+class DepartureTable {
+ public:
+  using bitmap_t = std::vector<uint64_t>;
+
+  // Number of service days whose schedule and validity bitmaps are kept.
+  // Searches over more days than this check the later days with
+  // next_valid_on so they do not evict the bitmaps of the first days.
+  static constexpr size_t kCachedDays = 4;
+
+  /**
+   * Constructor.
+   * @param  departures      Departures sorted by line Id then time.
+   * @param  count           Number of departures.
+   * @param  schedules       Schedules of the tile.
+   * @param  schedule_count  Number of schedules.
+   */
+  DepartureTable(const TransitDeparture* departures, const uint32_t count,
+                 const TransitSchedule* schedules, const uint32_t schedule_count);
+
+  /**
+   * Get the number of departures.
+   * @return  Returns the number of departures.
+   */
+  uint32_t size() const;
+
+  /**
+   * Get the departure time of a departure.
+   * @param  i  Index of the departure.
+   * @return  Returns the departure time (seconds from midnight).
+   */
+  uint32_t time(const uint32_t i) const {
+    return times_[i];
+  }
+
+  /**
+   * Get a departure.
+   * @param  i  Index of the departure.
+   * @return  Returns the departure.
+   */
+  const TransitDeparture& departure(const uint32_t i) const {
+    return departures_[i];
+  }
+
+  /**
+   * Finds the first departure of a range that is at or after a time.
+   * @param  begin  First departure of the range (e.g. of one line).
+   * @param  end    One past the last departure of the range.
+   * @param  time   Time (seconds from midnight).
+   * @return  Returns the index of the departure or end if there is none.
+   */
+  uint32_t lower_bound(const uint32_t begin, const uint32_t end,
+                       const uint32_t time) const;
+
+  /**
+   * Finds the first departure of a range that is after a time.
+   * @param  begin  First departure of the range (e.g. of one line).
+   * @param  end    One past the last departure of the range.
+   * @param  time   Time (seconds from midnight).
+   * @return  Returns the index of the departure or end if there is none.
+   */
+  uint32_t upper_bound(const uint32_t begin, const uint32_t end,
+                       const uint32_t time) const;
+
+  /**
+   * Is a bit of a bitmap set?
+   * @param  bitmap  Bitmap (see active_schedules and valid_on).
+   * @param  i       Index of the bit.
+   * @return  Returns true if the bit is set.
+   */
+  static bool test(const bitmap_t& bitmap, const uint32_t i) {
+    return (bitmap[i / 64] >> (i % 64)) & 1;
+  }
+
+  /**
+   * Get the bitset of the schedules that are valid on a day, so checking
+   * the schedule of a departure is a single bit lookup. Computed on first
+   * use for that day and cached.
+   * @param  day               Days since the tile creation date.
+   * @param  dow               Day of week (see graphconstants.h).
+   * @param  date_before_tile  Is the date before the tile creation date?
+   * @return  Returns the bitset (bit i set if schedule i is valid).
+   */
+  std::shared_ptr<const bitmap_t> active_schedules(const uint32_t day,
+                                                   const uint32_t dow,
+                                                   const bool date_before_tile) const;
+
+  /**
+   * Get the bitmap of the departures whose schedule is valid on a day.
+   * Computed on first use for that day from the active schedules and
+   * cached.
+   * @param  day               Days since the tile creation date.
+   * @param  dow               Day of week (see graphconstants.h).
+   * @param  date_before_tile  Is the date before the tile creation date?
+   * @return  Returns the bitmap (bit i set if departure i is valid).
+   */
+  std::shared_ptr<const bitmap_t> valid_on(const uint32_t day, const uint32_t dow,
+                                           const bool date_before_tile) const;
+
+  /**
+   * Finds the first departure of a range that is valid and has the
+   * requested accessibility.
+   * @param  begin       First departure to consider.
+   * @param  end         One past the last departure to consider.
+   * @param  valid       Validity bitmap (see valid_on).
+   * @param  wheelchair  Only find departures with wheelchair access if true.
+   * @param  bicycle     Only find departures with bicycle access if true.
+   * @return  Returns the index of the departure or end if there is none.
+   */
+  uint32_t next_valid(const uint32_t begin, const uint32_t end,
+                      const bitmap_t& valid, const bool wheelchair,
+                      const bool bicycle) const;
+
+  /**
+   * Finds the first departure of a range that is valid on a day and has
+   * the requested accessibility, checking the schedule of each departure
+   * of the range. Unlike valid_on nothing is computed for the whole tile or
+   * cached, so this suits days that are looked at once, e.g. the far days
+   * of a multi-day search.
+   * @param  begin             First departure to consider.
+   * @param  end               One past the last departure to consider.
+   * @param  day               Days since the tile creation date.
+   * @param  dow               Day of week (see graphconstants.h).
+   * @param  date_before_tile  Is the date before the tile creation date?
+   * @param  wheelchair        Only find departures with wheelchair access if true.
+   * @param  bicycle           Only find departures with bicycle access if true.
+   * @return  Returns the index of the departure or end if there is none.
+   */
+  uint32_t next_valid_on(const uint32_t begin, const uint32_t end,
+                         const uint32_t day, const uint32_t dow,
+                         const bool date_before_tile, const bool wheelchair,
+                         const bool bicycle) const;
+
+  /**
+   * Get the days on which departures of a line may run.
+   * @param  lineid  Line Id.
+   * @return  Returns the active days (none if the line has no departures).
+   */
+  ActiveDays active_days(const uint32_t lineid) const;
+
+  /**
+   * Get the indexes of all departures sorted by departure time (then by
+   * line Id and time order within the line). Computed on first use.
+   * @return  Returns the departure indexes in time order.
+   */
+  const std::vector<uint32_t>& by_time() const;
+
+  /**
+   * Finds the departures in a time window within the time sorted order.
+   * @param  start  Start of the window (seconds from midnight).
+   * @param  end    End of the window, inclusive (seconds from midnight).
+   * @return  Returns the first and one past the last position in by_time().
+   */
+  std::pair<uint32_t, uint32_t> by_time_range(const uint32_t start,
+                                              const uint32_t end) const;
+
+ protected:
+  const TransitDeparture* departures_;
+  const TransitSchedule* schedules_;
+  uint32_t schedule_count_;
+
+  // Departure time of each departure
+  std::vector<uint32_t> times_;
+
+  // Departures that are wheelchair and bicycle accessible
+  bitmap_t wheelchair_;
+  bitmap_t bicycle_;
+
+  // Days each line may run on
+  std::unordered_map<uint32_t, ActiveDays> active_days_;
+
+  // Active schedule and departure validity bitmaps of recently used days,
+  // most recent first
+  using day_t = std::tuple<uint32_t, uint32_t, bool>;
+  using day_cache_t = std::list<std::pair<day_t, std::shared_ptr<const bitmap_t>>>;
+  mutable std::mutex mutex_;
+  mutable day_cache_t schedule_days_;
+  mutable day_cache_t days_;
+
+  /**
+   * Get the bitmap of a day from a cache, computing and adding it if it is
+   * not there.
+   * @param  cache    Cache of the bitmaps.
+   * @param  day      Day of the bitmap.
+   * @param  compute  Computes the bitmap of the day.
+   * @return  Returns the bitmap.
+   */
+  template <class compute_t>
+  std::shared_ptr<const bitmap_t> cached(day_cache_t& cache, const day_t& day,
+                                         const compute_t& compute) const;
+
+  // Departure indexes in time order, built on first use
+  mutable std::once_flag by_time_once_;
+  mutable std::vector<uint32_t> by_time_;
+};
+
+/**
+ * The departures of a range (e.g. one line within a time window) that are
+ * valid on a day and have the requested accessibility, in time order. Each
+ * step uses DepartureTable::next_valid so departures that do not run are
+ * skipped 64 at a time rather than checked one by one. Iterators refer to
+ * the window they came from.
+ */
+class DepartureWindow {
+ public:
+  class iterator : public std::iterator<std::forward_iterator_tag, const TransitDeparture> {
+   public:
+    iterator(const DepartureWindow* window, const uint32_t i)
+        : window_(window), i_(i) {
+    }
+    iterator& operator++() {
+      i_ = window_->next(i_ + 1);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator it = *this;
+      ++(*this);
+      return it;
+    }
+    bool operator==(const iterator& other) const {
+      return i_ == other.i_;
+    }
+    bool operator!=(const iterator& other) const {
+      return i_ != other.i_;
+    }
+    const TransitDeparture& operator*() const {
+      return window_->table_->departure(i_);
+    }
+    const TransitDeparture* operator->() const {
+      return &window_->table_->departure(i_);
+    }
+
+    /**
+     * Get the index of the departure in the tile.
+     * @return  Returns the departure index.
+     */
+    uint32_t index() const {
+      return i_;
+    }
+   protected:
+    const DepartureWindow* window_;
+    uint32_t i_;
+  };
+
+  /**
+   * Constructor.
+   * @param  table       Departure table.
+   * @param  begin       First departure of the range.
+   * @param  end         One past the last departure of the range.
+   * @param  valid       Validity bitmap of the day (see valid_on).
+   * @param  wheelchair  Only include departures with wheelchair access if true.
+   * @param  bicycle     Only include departures with bicycle access if true.
+   */
+  DepartureWindow(const DepartureTable& table, const uint32_t begin,
+                  const uint32_t end,
+                  std::shared_ptr<const DepartureTable::bitmap_t> valid,
+                  const bool wheelchair, const bool bicycle)
+      : table_(&table), end_(end), valid_(std::move(valid)),
+        wheelchair_(wheelchair), bicycle_(bicycle), begin_(next(begin)) {
+  }
+
+  iterator begin() const {
+    return iterator(this, begin_);
+  }
+  iterator end() const {
+    return iterator(this, end_);
+  }
+
+  /**
+   * Are there no departures in the window?
+   * @return  Returns true if the window is empty.
+   */
+  bool empty() const {
+    return begin_ == end_;
+  }
+
+ protected:
+  const DepartureTable* table_;
+  uint32_t end_;
+  std::shared_ptr<const DepartureTable::bitmap_t> valid_;
+  bool wheelchair_;
+  bool bicycle_;
+  uint32_t begin_;
+
+  uint32_t next(const uint32_t i) const {
+    return table_->next_valid(i, end_, *valid_, wheelchair_, bicycle_);
+  }
+};
+
+/**
+ * All departures of a tile within a time window in departure time order,
+ * across lines, e.g. as the connections of a connection scan. Optionally
+ * only those valid on a day with the requested accessibility. Iterators
+ * refer to the view they came from.
+ */
+class DeparturesByTime {
+ public:
+  class iterator : public std::iterator<std::forward_iterator_tag, const TransitDeparture> {
+   public:
+    iterator(const DeparturesByTime* view, const uint32_t* pos)
+        : view_(view), pos_(pos) {
+    }
+    iterator& operator++() {
+      pos_ = view_->next(pos_ + 1);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator it = *this;
+      ++(*this);
+      return it;
+    }
+    bool operator==(const iterator& other) const {
+      return pos_ == other.pos_;
+    }
+    bool operator!=(const iterator& other) const {
+      return pos_ != other.pos_;
+    }
+    const TransitDeparture& operator*() const {
+      return view_->table_->departure(*pos_);
+    }
+    const TransitDeparture* operator->() const {
+      return &view_->table_->departure(*pos_);
+    }
+
+    /**
+     * Get the index of the departure in the tile.
+     * @return  Returns the departure index.
+     */
+    uint32_t index() const {
+      return *pos_;
+    }
+   protected:
+    const DeparturesByTime* view_;
+    const uint32_t* pos_;
+  };
+
+  /**
+   * Constructor.
+   * @param  table       Departure table.
+   * @param  start       Start of the window (seconds from midnight).
+   * @param  end         End of the window, inclusive (seconds from midnight).
+   * @param  valid       Validity bitmap of a day (see valid_on) or nullptr
+   *                     to include the departures of every day.
+   * @param  wheelchair  Only include departures with wheelchair access if true.
+   * @param  bicycle     Only include departures with bicycle access if true.
+   */
+  DeparturesByTime(const DepartureTable& table, const uint32_t start,
+                   const uint32_t end,
+                   std::shared_ptr<const DepartureTable::bitmap_t> valid,
+                   const bool wheelchair, const bool bicycle);
+
+  iterator begin() const {
+    return iterator(this, begin_);
+  }
+  iterator end() const {
+    return iterator(this, end_);
+  }
+
+  /**
+   * Are there no departures in the view?
+   * @return  Returns true if the view is empty.
+   */
+  bool empty() const {
+    return begin_ == end_;
+  }
+
+ protected:
+  const DepartureTable* table_;
+  const uint32_t* end_;
+  std::shared_ptr<const DepartureTable::bitmap_t> valid_;
+  bool wheelchair_;
+  bool bicycle_;
+  const uint32_t* begin_;
+
+  // Skips to the first included departure at or after a position
+  const uint32_t* next(const uint32_t* pos) const;
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_DEPARTURE_TABLE_H_
@@ -75,6 +75,36 @@ class DoubleBucketQueue {
    */
   uint32_t pop();
 
+  /**
+   * Removes all label indexes from the lowest cost non-empty bucket. No
+   * label returned is more than one bucket above the current cost: each was
+   * added with a cost below current_cost() + bucketsize. There is no lower
+   * bound, as costs added below the current bucket are placed in it, so
+   * the batch may be relaxed together (e.g. delta-stepping across threads)
+   * but its labels are not within bucketsize of each other.
+   * Invariants the caller must respect while relaxing a batch:
+   *   - Labels returned by pop_bucket are no longer in the queue, so they
+   *     must not be passed to decrease(). If a label in the batch improves,
+   *     add() it again.
+   *   - Costs added while relaxing the batch that fall within (or below) the
+   *     current bucket are placed in the current bucket, so pop_bucket must
+   *     be called again until it returns 0 before the batch is settled.
+   *   - The queue itself is not thread-safe. add() and decrease() must be
+   *     serialized (or results gathered per thread and added afterwards).
+   * @param  labels  (OUT) Cleared, then filled with the label indexes of
+   *                 the lowest cost bucket in insertion order.
+   * @return  Returns the number of labels removed. Returns 0 if the buckets
+   *          are empty.
+   */
+  uint32_t pop_bucket(std::vector<uint32_t>& labels);
+
+  /**
+   * Gets the lowest cost of the current bucket. After pop() or pop_bucket()
+   * this is the lower bound of the cost range of the returned label(s).
+   * @return  Returns the cost at the start of the current bucket.
+   */
+  float current_cost() const;
+
  private:
   float bucketrange_;  // Total range of costs in lower level buckets
   float bucketcount_;  // Number of buckets
@@ -108,6 +138,14 @@ class DoubleBucketQueue {
    * low level buckets.
    */
   void empty_overflow();
+
+  /**
+   * Advances the current bucket to the lowest cost non-empty bucket, moving
+   * labels out of the overflow bucket if the low level buckets are empty.
+   * @return  Returns true if a non-empty bucket was found, false if the
+   *          queue is empty.
+   */
+  bool find_nonempty_bucket();
 };
 
 }
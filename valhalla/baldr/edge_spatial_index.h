@@ -0,0 +1,139 @@
+#ifndef VALHALLA_BALDR_EDGE_SPATIAL_INDEX_H_
+#define VALHALLA_BALDR_EDGE_SPATIAL_INDEX_H_
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace baldr {
+
+class GraphTile;
+
+/**
+ * Spatial index over the edge shape segments of a single tile. This is a
+ * finer grained alternative to the 5x5 edge bins: every segment of every
+ * edge shape is placed into a packed Hilbert R-tree (segments sorted along
+ * a Hilbert curve and grouped bottom up into fixed size nodes), so a
+ * location search only measures distance to segments near the query point
+ * and gets candidates back in increasing distance order.
+ *
+ * Each edge shape is indexed once. Directed edge pairs share their shape, so
+ * only one directed edge per shape (the one with forward() set, if it is in
+ * this tile) is returned; use the opposing edge for the other direction.
+ * Shortcut and transit line edges are not indexed.
+ */
+class EdgeSpatialIndex {
+ public:
+  /**
+   * A segment found by a search.
+   */
+  struct Candidate {
+    GraphId edgeid;              // Directed edge the shape belongs to
+    uint32_t segment;            // Index of the first shape point of the segment
+    float distance;              // Distance (meters) from the query point
+    midgard::PointLL projected;  // Closest point on the segment
+  };
+
+  /**
+   * Visitor called for each candidate in increasing distance order.
+   * Return false to stop the search.
+   */
+  using visitor_t = std::function<bool (const Candidate&)>;
+
+  /**
+   * Constructor. Decodes the shape of each edge within the tile and builds
+   * the index.
+   * @param  tile  Graph tile to index.
+   */
+  explicit EdgeSpatialIndex(const GraphTile& tile);
+
+  /**
+   * Constructor given a list of edge shapes.
+   * @param  shapes  Edge Ids and their shapes.
+   */
+  explicit EdgeSpatialIndex(
+      const std::vector<std::pair<GraphId, std::vector<midgard::PointLL>>>& shapes);
+
+  /**
+   * Get the number of indexed segments.
+   * @return  Returns the segment count.
+   */
+  size_t size() const;
+
+  /**
+   * Visits segments in increasing distance from a point. Only decodes and
+   * measures segments whose bounding box could be closer than the ones
+   * already visited.
+   * @param  pt            Query point.
+   * @param  max_distance  Maximum distance (meters) of a candidate.
+   * @param  visitor       Called for each candidate, return false to stop.
+   */
+  void Visit(const midgard::PointLL& pt, const float max_distance,
+             const visitor_t& visitor) const;
+
+  /**
+   * Get the closest edges to a point. Returns the closest segment of each
+   * edge in increasing distance order.
+   * @param  pt            Query point.
+   * @param  count         Maximum number of edges to return.
+   * @param  max_distance  Maximum distance (meters) of a candidate.
+   * @return  Returns the candidates, one per edge.
+   */
+  std::vector<Candidate> Nearest(const midgard::PointLL& pt, const size_t count,
+      const float max_distance = std::numeric_limits<float>::max()) const;
+
+ protected:
+  // Bounding box of a segment or R-tree node
+  struct Box {
+    float minx;
+    float miny;
+    float maxx;
+    float maxy;
+  };
+
+  // Number of children per R-tree node
+  static constexpr uint32_t kNodeSize = 16;
+
+  // Indexed edges and the first point of each edge's shape within points_.
+  // The last entry of edge_points_ is the total point count.
+  std::vector<GraphId> edges_;
+  std::vector<uint32_t> edge_points_;
+
+  // Shape points of all edges
+  std::vector<midgard::PointLL> points_;
+
+  // R-tree boxes. Leaves (one per segment) come first, followed by each
+  // level of nodes up to the root. indices_ holds the first point of the
+  // segment for leaves and the position of the first child for nodes.
+  std::vector<Box> boxes_;
+  std::vector<uint32_t> indices_;
+
+  // Edge index of each segment (parallel to the leaf boxes)
+  std::vector<uint32_t> segment_edges_;
+
+  // End position (in boxes_) of each level
+  std::vector<uint32_t> level_bounds_;
+
+  /**
+   * Adds an edge shape to the list of edges to index.
+   * @param  edgeid  Edge Id.
+   * @param  shape   Shape of the edge.
+   */
+  void add(const GraphId& edgeid, const std::vector<midgard::PointLL>& shape);
+
+  /**
+   * Builds the R-tree once all edges have been added.
+   */
+  void build();
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_EDGE_SPATIAL_INDEX_H_
@@ -1,6 +1,7 @@
 #ifndef VALHALLA_BALDR_EDGEINFO_H_
 #define VALHALLA_BALDR_EDGEINFO_H_
 
+#include <cstring>
 #include <vector>
 #include <string>
 #include <ostream>
@@ -11,6 +12,8 @@
 #include <valhalla/midgard/util.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/json.h>
+#include <valhalla/baldr/text_view.h>
+#include <valhalla/baldr/edgeshape.h>
 
 using namespace valhalla::midgard;
 
@@ -20,9 +23,142 @@ namespace baldr {
 constexpr size_t kMaxNamesPerEdge = 15;
 constexpr size_t kMaxEncodedShapeSize = 65535;
 
+/**
+ * Lightweight handle to the edge information within a tile. It is two
+ * pointers and a size (24 bytes), trivially copyable and does no work when
+ * created: the way Id, name offsets and encoded shape are read from tile
+ * memory when asked for. Use this in tight loops; EdgeInfo wraps it and
+ * adds caching of the decoded shape. It points into the tile memory, not
+ * at the GraphTile, so it stays valid when the GraphTile object is moved
+ * or copied but not once the tile memory is freed.
+ */
+class EdgeInfoRef {
+ public:
+  struct PackedItem {
+    uint32_t name_count          :4;
+    uint32_t encoded_shape_size  :16;
+    uint32_t spare               :12;
+  };
+
+  /**
+   * Constructor
+   * @param  ptr                Pointer to the edge info within the tile.
+   * @param  names_list         Pointer to the start of the text/names list.
+   *                            May be null with a length of 0, in which
+   *                            case reading a name throws.
+   * @param  names_list_length  Length (bytes) of the text/names list.
+   */
+  EdgeInfoRef(const char* ptr, const char* names_list,
+              const size_t names_list_length)
+      : ptr_(ptr), names_list_(names_list),
+        names_list_length_(names_list_length) {
+  }
+
+  /**
+   * Gets the OSM way Id.
+   * @return  Returns the OSM way Id.
+   */
+  uint64_t wayid() const {
+    uint64_t wayid;
+    std::memcpy(&wayid, ptr_, sizeof(wayid));
+    return wayid;
+  }
+
+  /**
+   * Get the number of names.
+   * @return Returns the name count.
+   */
+  uint32_t name_count() const {
+    return item()->name_count;
+  }
+
+  /**
+   * Get the size of the encoded shape (number of bytes).
+   * @return  Returns the shape size.
+   */
+  uint32_t encoded_shape_size() const {
+    return item()->encoded_shape_size;
+  }
+
+  /**
+   * Get the name offset for the specified name index.
+   * @param  index  Index into the name list.
+   * @return  Returns the offset into the text/name list.
+   */
+  uint32_t GetStreetNameOffset(uint8_t index) const;
+
+  /**
+   * Get the offsets of the names within the text/name list.
+   * @return  Returns a pointer to name_count() offsets.
+   */
+  const uint32_t* name_offsets() const {
+    return reinterpret_cast<const uint32_t*>(ptr_ + sizeof(uint64_t) + sizeof(PackedItem));
+  }
+
+  /**
+   * Get the names without copying them out of the tile.
+   * @return   Returns views of the names.
+   */
+  NameViews GetNameViews() const;
+
+  /**
+   * Get a pointer to the encoded shape within the tile.
+   * @return  Returns the encoded shape, encoded_shape_size() bytes long.
+   */
+  const char* encoded_shape_data() const {
+    return reinterpret_cast<const char*>(name_offsets() + name_count());
+  }
+
+  /**
+   * Decode the shape of the edge into a caller provided buffer.
+   * @param  shape  Decoded shape points (previous contents are cleared).
+   */
+  void decode_shape(std::vector<PointLL>& shape) const {
+    decode_shape7(encoded_shape_data(), encoded_shape_size(), shape);
+  }
+
+  /**
+   * Get a decoder that decodes the shape one point at a time.
+   * @return  Returns the shape decoder.
+   */
+  ShapeStream shape_stream() const {
+    return ShapeStream(encoded_shape_data(), encoded_shape_size());
+  }
+
+  /**
+   * Get a midgard decoder over the encoded shape, which decodes a point at
+   * a time as it is advanced.
+   * @return  Returns the shape decoder.
+   */
+  midgard::Shape7Decoder<PointLL> lazy_shape() const {
+    return midgard::Shape7Decoder<PointLL>(encoded_shape_data(), encoded_shape_size());
+  }
+
+  /**
+   * Get the pointer to the edge info within the tile.
+   * @return  Returns the pointer.
+   */
+  const char* data() const {
+    return ptr_;
+  }
+
+ protected:
+  const PackedItem* item() const {
+    return reinterpret_cast<const PackedItem*>(ptr_ + sizeof(uint64_t));
+  }
+
+  // Edge info within the tile
+  const char* ptr_;
+
+  // The list of names within the tile and its size
+  const char* names_list_;
+  size_t names_list_length_;
+};
+
 /**
  * Edge information not required in shortest path algorithm and is
- * common among the 2 directions.
+ * common among the 2 directions. Wraps an EdgeInfoRef and caches the
+ * decoded shape.
  */
 class EdgeInfo {
  public:
@@ -32,6 +168,8 @@ class EdgeInfo {
   EdgeInfo(EdgeInfo&&) = default;
   EdgeInfo& operator=(EdgeInfo&&) = default;
 
+  using PackedItem = EdgeInfoRef::PackedItem;
+
   /**
    * Constructor
    * @param  ptr  Pointer to a bit of memory that has the info for this edge
@@ -41,27 +179,34 @@ class EdgeInfo {
   EdgeInfo(char* ptr, const char* names_list, const size_t names_list_length);
 
   /**
-   * Destructor
+   * Constructor
+   * @param  ref  Handle to the edge info within a tile.
    */
-  virtual ~EdgeInfo();
+  explicit EdgeInfo(const EdgeInfoRef& ref);
 
   /**
    * Gets the OSM way Id.
    * @return  Returns the OSM way Id.
    */
-  uint64_t wayid() const;
+  uint64_t wayid() const {
+    return ref_.wayid();
+  }
 
   /**
    * Get the number of names.
    * @return Returns the name count.
    */
-  uint32_t name_count() const;
+  uint32_t name_count() const {
+    return ref_.name_count();
+  }
 
   /**
    * Get the size of the encoded shape (number of bytes).
    * @return  Returns the shape size.
    */
-  uint32_t encoded_shape_size() const;
+  uint32_t encoded_shape_size() const {
+    return ref_.encoded_shape_size();
+  }
 
   /**
    * Get the name offset for the specified name index.
@@ -76,6 +221,12 @@ class EdgeInfo {
    */
   std::vector<std::string> GetNames() const;
 
+  /**
+   * Get the names for an edge without copying them out of the tile.
+   * @return   Returns views of the names, valid while the tile is alive.
+   */
+  NameViews GetNameViews() const;
+
   /**
    * Get the shape of the edge.
    * @return  Returns the the list of lat,lng points describing the
@@ -83,8 +234,46 @@ class EdgeInfo {
    */
   const std::vector<PointLL>& shape() const;
 
+  /**
+   * Decode the shape of the edge into a caller provided buffer. Unlike
+   * shape() nothing is cached within the EdgeInfo so a buffer can be reused
+   * across edges without allocating.
+   * @param  shape  Decoded shape points (previous contents are cleared).
+   */
+  void decode_shape(std::vector<PointLL>& shape) const;
+
+  /**
+   * Get a pointer to the encoded shape within the tile.
+   * @return  Returns the encoded shape, encoded_shape_size() bytes long.
+   */
+  const char* encoded_shape_data() const {
+    return ref_.encoded_shape_data();
+  }
+
+  /**
+   * Get a midgard decoder over the encoded shape, which decodes a point at
+   * a time as it is advanced.
+   * @return  Returns the shape decoder.
+   */
   midgard::Shape7Decoder<PointLL> lazy_shape() const {
-    return midgard::Shape7Decoder<PointLL>(encoded_shape_, item_->encoded_shape_size);
+    return ref_.lazy_shape();
+  }
+
+  /**
+   * Get a decoder that decodes the shape one point at a time. Use with the
+   * operations in shape_visitor.h to avoid decoding the whole shape.
+   * @return  Returns the shape decoder.
+   */
+  ShapeStream shape_stream() const {
+    return ref_.shape_stream();
+  }
+
+  /**
+   * Get the handle this wraps.
+   * @return  Returns the edge info handle.
+   */
+  const EdgeInfoRef& ref() const {
+    return ref_;
   }
 
   /**
@@ -102,34 +291,13 @@ class EdgeInfo {
   // Operator EqualTo based on nodea and nodeb.
   bool operator ==(const EdgeInfo& rhs) const;
 
-  struct PackedItem {
-    uint32_t name_count          :4;
-    uint32_t encoded_shape_size  :16;
-    uint32_t spare               :12;
-  };
-
  protected:
-  // OSM way Id
-  uint64_t wayid_;
-
-  // Where we keep the statistics about how large the vectors below are
-  const PackedItem* item_;
-
-  // List of roadname indexes
-  const uint32_t* street_name_offset_list_;
-
-  // The encoded shape of the edge
-  const char* encoded_shape_;
+  // Edge info within the tile
+  EdgeInfoRef ref_;
 
   // Lng, lat shape of the edge
   mutable std::vector<PointLL> shape_;
 
-  // The list of names within the tile
-  const char* names_list_;
-
-  // The size of the names list
-  size_t names_list_length_;
-
 };
 
 }
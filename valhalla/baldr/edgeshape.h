@@ -0,0 +1,135 @@
+#ifndef VALHALLA_BALDR_EDGESHAPE_H_
+#define VALHALLA_BALDR_EDGESHAPE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Decodes an encode7 edge shape (zigzag varint deltas, latitude then
+ * longitude, 1e-6 degree precision) into a caller provided buffer. Produces
+ * the same points as midgard::decode7 but decodes each varint from a single
+ * 8 byte load: the terminating byte is found with a mask and count trailing
+ * zeros and the 7 bit groups are compacted with BMI2 pext where available
+ * or a few shifts and masks otherwise, so there is no per-byte branch.
+ * @param  encoded  Encoded shape.
+ * @param  length   Length (bytes) of the encoded shape.
+ * @param  shape    Decoded points are written here. Any previous contents
+ *                  are cleared but the capacity is reused.
+ */
+void decode_shape7(const char* encoded, const size_t length,
+                   std::vector<midgard::PointLL>& shape);
+
+/**
+ * Decodes an encode7 edge shape into a fixed size buffer.
+ * @param  encoded     Encoded shape.
+ * @param  length      Length (bytes) of the encoded shape.
+ * @param  shape       Buffer for the decoded points.
+ * @param  max_points  Number of points the buffer can hold.
+ * @return  Returns the number of points in the shape. If this is greater
+ *          than max_points only the first max_points were written.
+ */
+size_t decode_shape7(const char* encoded, const size_t length,
+                     midgard::PointLL* shape, const size_t max_points);
+
+/**
+ * Decodes an encode7 edge shape one point at a time, using the same word at
+ * a time varint decoding as decode_shape7. Has the same interface as
+ * midgard::Shape7Decoder so it can be used with the shape visitors.
+ */
+class ShapeStream {
+ public:
+  /**
+   * Constructor.
+   * @param  encoded  Encoded shape.
+   * @param  length   Length (bytes) of the encoded shape.
+   */
+  ShapeStream(const char* encoded, const size_t length);
+
+  /**
+   * Decodes the next point. Throws if the shape is truncated.
+   * @return  Returns the next point.
+   */
+  midgard::PointLL pop();
+
+  /**
+   * Are all points decoded?
+   * @return  Returns true if there are no more points.
+   */
+  bool empty() const {
+    return begin_ == end_;
+  }
+
+ protected:
+  const char* begin_;
+  const char* end_;
+  int32_t lat_;
+  int32_t lng_;
+};
+
+/**
+ * Bounded cache of decoded edge shapes keyed by edge info offset within a
+ * tile. The least recently used shape is dropped when the cache is full.
+ * Shapes are handed out as shared pointers so a dropped shape stays valid
+ * for anyone still using it. Safe to use from multiple threads.
+ */
+class ShapeCache {
+ public:
+  using shape_t = std::shared_ptr<const std::vector<midgard::PointLL>>;
+
+  /**
+   * Constructor.
+   * @param  max_shapes  Maximum number of shapes to keep.
+   */
+  explicit ShapeCache(const size_t max_shapes);
+
+  /**
+   * Get a shape, decoding and caching it if it is not already cached.
+   * @param  edgeinfo_offset  Offset of the edge info within the tile.
+   * @param  encoded          Encoded shape.
+   * @param  length           Length (bytes) of the encoded shape.
+   * @return  Returns the decoded shape.
+   */
+  shape_t get(const uint32_t edgeinfo_offset, const char* encoded,
+              const size_t length);
+
+  /**
+   * Get the number of cached shapes.
+   * @return  Returns the number of cached shapes.
+   */
+  size_t size() const;
+
+  /**
+   * Get the maximum number of cached shapes.
+   * @return  Returns the maximum number of cached shapes.
+   */
+  size_t max_size() const;
+
+  /**
+   * Removes all cached shapes.
+   */
+  void clear();
+
+ protected:
+  using lru_t = std::list<std::pair<uint32_t, shape_t>>;
+
+  size_t max_shapes_;
+  mutable std::mutex mutex_;
+
+  // Most recently used shape at the front
+  lru_t lru_;
+  std::unordered_map<uint32_t, lru_t::iterator> shapes_;
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_EDGESHAPE_H_
@@ -1,11 +1,14 @@
 #ifndef VALHALLA_BALDR_GRAPHREADER_H_
 #define VALHALLA_BALDR_GRAPHREADER_H_
 
+#include <functional>
 #include <unordered_map>
 
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtile.h>
 #include <valhalla/baldr/tilehierarchy.h>
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/pointll.h>
 #include <boost/property_tree/ptree.hpp>
 
 namespace valhalla {
@@ -63,6 +66,14 @@ class GraphReader {
    */
   void Clear();
 
+  /**
+   * Lays realtime transit delays and cancellations over the tiles read by
+   * this reader, including those already cached. Updates published to the
+   * overlay apply without reloading tiles.
+   * @param  overlay  Realtime overlay (nullptr to remove it).
+   */
+  void SetRealtimeOverlay(std::shared_ptr<const RealtimeOverlay> overlay);
+
   /**
    * Lets you know if the cache is too large
    * @return true if the cache is over committed with respect to the limit
@@ -113,6 +124,94 @@ class GraphReader {
    */
   std::unordered_set<GraphId> GetTileSet() const;
 
+  /**
+   * Gets back the set of available tiles of one level, which may be the
+   * transit level (one past the last level of the hierarchy)
+   * @param   level  Hierarchy level.
+   * @return  returns the list of available tiles of the level
+   */
+  std::unordered_set<GraphId> GetTileSet(const uint8_t level) const;
+
+  /**
+   * An edge found by a spatial query.
+   */
+  struct SpatialEdge {
+    GraphId id;                  // Directed edge Id
+    const GraphTile* tile;       // Tile containing the directed edge
+    const DirectedEdge* edge;    // The directed edge
+    float distance;              // Distance (meters) from the query point
+                                 // (0 for bounding box queries)
+    midgard::PointLL projected;  // Closest point on the edge shape (the
+                                 // query point for bounding box queries)
+  };
+
+  /**
+   * Called for each edge found by a spatial query. Return false to stop.
+   */
+  using SpatialEdgeVisitor = std::function<bool (const SpatialEdge&)>;
+
+  /**
+   * Finds the edges whose shape is within a radius of a point. Works across
+   * tile and bin boundaries and the antimeridian: every tile and edge bin
+   * intersecting the circle is checked and edges found in several bins are
+   * visited once.
+   * @param  center      Center of the circle.
+   * @param  radius      Radius (meters) of the circle.
+   * @param  level       Hierarchy level to search.
+   * @param  visitor     Called once for each edge within the radius.
+   * @param  max_shapes  Maximum number of edge shapes to decode (0 for no
+   *                     limit). The search stops once this is reached.
+   * @return  Returns the number of edge shapes decoded.
+   */
+  size_t EdgesInRadius(const midgard::PointLL& center, const float radius,
+                       const uint8_t level, const SpatialEdgeVisitor& visitor,
+                       const size_t max_shapes = 0);
+
+  /**
+   * Finds the edges whose shape intersects a bounding box. Works across
+   * tile and bin boundaries and edges found in several bins are visited
+   * once.
+   * @param  bbox        Bounding box (lng,lat). A box crossing the
+   *                     antimeridian has minx > maxx or maxx > 180.
+   * @param  level       Hierarchy level to search.
+   * @param  visitor     Called once for each edge intersecting the box.
+   * @param  max_shapes  Maximum number of edge shapes to decode (0 for no
+   *                     limit). The search stops once this is reached.
+   * @return  Returns the number of edge shapes decoded.
+   */
+  size_t EdgesInBoundingBox(const midgard::AABB2<midgard::PointLL>& bbox,
+                            const uint8_t level, const SpatialEdgeVisitor& visitor,
+                            const size_t max_shapes = 0);
+
+  /**
+   * Sums the statistics of the tiles of a level that intersect a bounding
+   * box. Tiles that are not in the cache are read and summed by several
+   * threads in parallel and are not added to the cache.
+   * @param  bbox     Bounding box (lng,lat).
+   * @param  level    Hierarchy level.
+   * @param  threads  Number of threads (0 to use one per hardware thread).
+   * @return  Returns the summed statistics.
+   */
+  TileStatistics GetStatistics(const midgard::AABB2<midgard::PointLL>& bbox,
+                               const uint8_t level, const size_t threads = 0);
+
+  /**
+   * Sums the statistics of all the available tiles of a level (see
+   * GetTileSet), reading them in parallel as above.
+   * @param  level    Hierarchy level.
+   * @param  threads  Number of threads (0 to use one per hardware thread).
+   * @return  Returns the summed statistics.
+   */
+  TileStatistics GetStatistics(const uint8_t level, const size_t threads = 0);
+
+  /**
+   * Get the onestop Id indexes of all the transit tiles merged into one.
+   * Built once by this reader on first use. Transit tiles that are not in
+   * the cache are read to build it but not added to the cache.
+   * @return  Returns the merged onestop indexes.
+   */
+  std::shared_ptr<const OneStopIndexes> GetOneStopIndexes();
+
  protected:
   // (Tar) extract of tiles - the contents are empty if not being used
   struct tile_extract_t;
@@ -130,6 +229,49 @@ class GraphReader {
 
   // The max cache size in bytes
   size_t max_cache_size_;
+
+  // Max number of decoded edge shapes cached per tile (0 to disable)
+  size_t shape_cache_size_;
+
+  // Realtime transit updates laid over the tiles
+  std::shared_ptr<const RealtimeOverlay> realtime_;
+
+  // Onestop indexes of all the transit tiles, built on first use
+  std::shared_ptr<const OneStopIndexes> onestop_indexes_;
+
+  /**
+   * Reads a tile from the extract or from disk without caching it.
+   * @param  base  Base graph Id of the tile.
+   * @return  Returns the tile (with a size of 0 if it does not exist).
+   */
+  GraphTile ReadTile(const GraphId& base) const;
+
+  /**
+   * Sums the statistics of a list of tiles using several threads.
+   * @param  tiles    Graph Ids of the tiles.
+   * @param  threads  Number of threads (0 to use one per hardware thread).
+   * @return  Returns the summed statistics.
+   */
+  TileStatistics SumStatistics(const std::vector<GraphId>& tiles, size_t threads);
+
+  /**
+   * Decodes the shape of each edge in the bins that pass the bin filter,
+   * visiting each edge once, and passes it to the shape filter.
+   * @param  bbox        Bounding box of the query.
+   * @param  level       Hierarchy level to search.
+   * @param  bin_filter  Returns true if a bin (given its bounds) may hold
+   *                     edges of interest.
+   * @param  filter      Returns true and fills in the distance and
+   *                     projected point if the shape matches the query.
+   * @param  visitor     Called for each matching edge.
+   * @param  max_shapes  Maximum number of shapes to decode (0 for no limit).
+   * @return  Returns the number of edge shapes decoded.
+   */
+  size_t VisitBinnedEdges(const midgard::AABB2<midgard::PointLL>& bbox,
+      const uint8_t level,
+      const std::function<bool (const midgard::AABB2<midgard::PointLL>&)>& bin_filter,
+      const std::function<bool (const std::vector<midgard::PointLL>&, SpatialEdge&)>& filter,
+      const SpatialEdgeVisitor& visitor, const size_t max_shapes);
 };
 
 }
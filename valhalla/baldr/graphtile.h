@@ -2,16 +2,29 @@
 #define VALHALLA_BALDR_GRAPHTILE_H_
 
 #include <valhalla/baldr/accessrestriction.h>
+#include <valhalla/baldr/checked_access.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtileheader.h>
 #include <valhalla/baldr/directededge.h>
 #include <valhalla/baldr/nodeinfo.h>
 #include <valhalla/baldr/transitdeparture.h>
+#include <valhalla/baldr/departure_table.h>
 #include <valhalla/baldr/transitroute.h>
 #include <valhalla/baldr/transitstop.h>
 #include <valhalla/baldr/transitschedule.h>
 #include <valhalla/baldr/sign.h>
 #include <valhalla/baldr/edgeinfo.h>
+#include <valhalla/baldr/edge_spatial_index.h>
+#include <valhalla/baldr/edgeshape.h>
+#include <valhalla/baldr/lazy_value.h>
+#include <valhalla/baldr/quantized_shapes.h>
+#include <valhalla/baldr/name_table.h>
+#include <valhalla/baldr/onestop_index.h>
+#include <valhalla/baldr/realtime_overlay.h>
+#include <valhalla/baldr/record_index.h>
+#include <valhalla/baldr/tile_ranges.h>
+#include <valhalla/baldr/tile_statistics.h>
+#include <valhalla/baldr/trip_index.h>
 #include <valhalla/baldr/admininfo.h>
 #include <valhalla/baldr/tilehierarchy.h>
 
@@ -24,10 +37,10 @@
 namespace valhalla {
 namespace baldr {
 
-using tile_index_pair = std::pair<uint32_t, uint32_t>;
-
 /**
- * Graph information for a tile within the Tiled Hierarchical Graph.
+ * Graph information for a tile within the Tiled Hierarchical Graph. A tile
+ * may be shared by several threads: the indexes it builds on first use are
+ * published atomically (see LazyValue).
  */
 class GraphTile {
  public:
@@ -125,6 +138,59 @@ class GraphTile {
    */
   const DirectedEdge* directededge(const size_t idx) const;
 
+  /**
+   * Get a pointer to a node without a bounds check, for hot loops whose
+   * indexes are already known to be valid (e.g. taken from the tile's own
+   * edges). The check is only compiled in when VALHALLA_CHECKED_ACCESS is
+   * set, which it is by default in builds without NDEBUG.
+   * @param  idx  Index of the node within the current tile.
+   * @return  Returns a pointer to the node.
+   */
+  const NodeInfo* node_unchecked(const size_t idx) const {
+    if (kCheckedAccess && VALHALLA_UNLIKELY(idx >= header_->nodecount()))
+      node_out_of_bounds(idx);
+    return nodes_ + idx;
+  }
+
+  /**
+   * Get a pointer to a directed edge without a bounds check (except in
+   * checked builds, see node_unchecked).
+   * @param  idx  Index of the directed edge within the current tile.
+   * @return  Returns a pointer to the edge.
+   */
+  const DirectedEdge* directededge_unchecked(const size_t idx) const {
+    if (kCheckedAccess && VALHALLA_UNLIKELY(idx >= header_->directededgecount()))
+      directededge_out_of_bounds(idx);
+    return directededges_ + idx;
+  }
+
+  /**
+   * Get all the nodes in this tile, for tile wide passes that would
+   * otherwise call node(idx) for each.
+   * @return  Returns an iterable range of the nodes.
+   */
+  midgard::iterable_t<const NodeInfo> GetNodes() const;
+
+  /**
+   * Get all the directed edges in this tile.
+   * @return  Returns an iterable range of the directed edges.
+   */
+  midgard::iterable_t<const DirectedEdge> GetDirectedEdges() const;
+
+  /**
+   * Get the outbound directed edges of a node.
+   * @param  idx  Index of the node within the current tile.
+   * @return  Returns an iterable range of the node's directed edges.
+   */
+  midgard::iterable_t<const DirectedEdge> GetDirectedEdges(const size_t idx) const;
+
+  /**
+   * Get every node in this tile together with its outbound directed edges.
+   * Edges of upcoming nodes are prefetched while iterating.
+   * @return  Returns the range of nodes and their edges.
+   */
+  NodeEdgesRange GetNodeEdges() const;
+
   /**
    * Convenience method to get opposing edge Id given a directed edge.
    * The end node of the directed edge must be in this tile.
@@ -139,6 +205,14 @@ class GraphTile {
    */
   EdgeInfo edgeinfo(const size_t offset) const;
 
+  /**
+   * Get a lightweight handle to the edge info. Unlike edgeinfo() creating
+   * it does no work; fields are read from the tile as they are accessed.
+   * @param  offset  Offset to the edge info.
+   * @return  Returns the edge info handle.
+   */
+  EdgeInfoRef edgeinfo_ref(const size_t offset) const;
+
   /**
    * Convenience method to get the directed edges originating at a node.
    * @param  node_index  Node Id within this tile.
@@ -157,6 +231,31 @@ class GraphTile {
    */
   std::vector<std::string> GetNames(const uint32_t edgeinfo_offset) const;
 
+  /**
+   * Get the decoded shape of an edge given the offset to the edge info. If
+   * the shape cache is enabled the shape is only decoded the first time it
+   * is requested (until it falls out of the cache).
+   * @param  edgeinfo_offset  Offset to the edge info.
+   * @return  Returns the shape.
+   */
+  ShapeCache::shape_t GetShape(const uint32_t edgeinfo_offset) const;
+
+  /**
+   * Enables a bounded cache of decoded edge shapes for this tile. Copies of
+   * the tile share the cache.
+   * @param  max_shapes  Maximum number of shapes to cache, 0 disables it.
+   */
+  void EnableShapeCache(const size_t max_shapes);
+
+  /**
+   * Get the names for an edge without copying them. The views point into
+   * this tile's memory and are valid as long as the tile (or a copy sharing
+   * its memory) is alive.
+   * @param  edgeinfo_offset  Offset to the edge info.
+   * @return  Returns views of the names.
+   */
+  NameViews GetNameViews(const uint32_t edgeinfo_offset) const;
+
   /**
    * Get the admininfo at the specified index. Populates the state name and
    * country name from the text/name list.
@@ -165,6 +264,13 @@ class GraphTile {
    */
   AdminInfo admininfo(const size_t idx) const;
 
+  /**
+   * Get the admin text at the specified index without copying it.
+   * @param  idx  Index into the admin list.
+   * @return  Returns views of the admin text.
+   */
+  AdminView admin_view(const size_t idx) const;
+
   /**
    * Get the admin at the specified index.
    * @param  idx  Index into the admin list.
@@ -179,6 +285,39 @@ class GraphTile {
    */
   std::string GetName(const uint32_t textlist_offset) const;
 
+  /**
+   * Get the text/name for a given offset to the textlist without copying it.
+   * @param   textlist_offset  offset into the text list.
+   * @return  Returns a view of the text.
+   */
+  TextView GetNameView(const uint32_t textlist_offset) const;
+
+  /**
+   * Get the tile name id of a name. Offsets of equal strings always get the
+   * same id (the offset of the first copy in the text list) so names within
+   * this tile can be compared as integers.
+   * @param   textlist_offset  offset into the text list.
+   * @return  Returns the tile name id.
+   */
+  uint32_t GetNameId(const uint32_t textlist_offset) const;
+
+  /**
+   * Get the process wide name id of a name (see NameTable). Equal strings
+   * get the same id across all tiles.
+   * @param   textlist_offset  offset into the text list.
+   * @return  Returns the name id.
+   */
+  uint32_t GetGlobalNameId(const uint32_t textlist_offset) const;
+
+  /**
+   * Get the process wide name ids of the names of an edge, sorted so the
+   * common names of two edges can be found with common_name_ids.
+   * @param  edgeinfo_offset  Offset to the edge info.
+   * @param  ids              Sorted, unique name ids (previous contents
+   *                          cleared).
+   */
+  void GetNameIds(const uint32_t edgeinfo_offset, std::vector<uint32_t>& ids) const;
+
   /**
    * Convenience method to get the signs for an edge given the directed
    * edge index.
@@ -187,9 +326,17 @@ class GraphTile {
    */
   std::vector<SignInfo> GetSigns(const uint32_t idx) const;
 
+  /**
+   * Get the signs for an edge without copying their text.
+   * @param  idx  Directed edge index. Used to lookup list of signs.
+   * @return  Returns views of the signs (empty if the edge has none).
+   */
+  SignViews GetSignViews(const uint32_t idx) const;
+
   /**
    * Get the next departure given the directed edge Id and the current
-   * time (seconds from midnight). TODO - what if crosses midnight?
+   * time (seconds from midnight), on the same day only. See the overload
+   * with a horizon to continue the search on the following days.
    * @param   lineid            Transit Line Id
    * @param   current_time      Current time (seconds from midnight).
    * @param   day               Days since the tile creation date.
@@ -199,7 +346,9 @@ class GraphTile {
    * @param   wheelchair        Only find departures with wheelchair access if true
    * @param   bicyle            Only find departures with bicycle access if true
    * @return  Returns a pointer to the transit departure information.
-   *          Returns nullptr if no departures are found.
+   *          Returns nullptr if no departures are found. Realtime updates
+   *          are not applied since the delay cannot be returned; use the
+   *          overload with a horizon to get delayed departures.
    */
   const TransitDeparture* GetNextDeparture(const uint32_t lineid,
                                            const uint32_t current_time,
@@ -209,16 +358,162 @@ class GraphTile {
                                            bool wheelchair,
                                            bool bicycle) const;
 
+  /**
+   * Get the next departure given the directed edge Id and the current
+   * time, continuing from midnight of the following days when there are no
+   * more departures on the current day. Days on which none of the line's
+   * schedules run are skipped without looking at the departures.
+   * @param   lineid            Transit Line Id
+   * @param   current_time      Current time (seconds from midnight).
+   * @param   day               Days since the tile creation date.
+   * @param   dow               Day of week (see graphconstants.h)
+   * @param   date_before_tile  Is the date that was inputed before
+   *                            the tile creation date?
+   * @param   wheelchair        Only find departures with wheelchair access if true
+   * @param   bicyle            Only find departures with bicycle access if true
+   * @param   horizon_days      Number of following days to search (0 to
+   *                            search the current day only).
+   * @return  Returns the departure (nullptr if none is found within the
+   *          horizon), the number of days after the current day it runs
+   *          on and its realtime delay. Realtime updates (see
+   *          SetRealtimeOverlay) apply to the current day only: cancelled
+   *          trips are skipped and departures are compared by their
+   *          delayed times.
+   */
+  DayDeparture GetNextDeparture(const uint32_t lineid,
+                                const uint32_t current_time,
+                                const uint32_t day,
+                                const uint32_t dow,
+                                bool date_before_tile,
+                                bool wheelchair,
+                                bool bicycle,
+                                const uint32_t horizon_days) const;
+
+  /**
+   * Get the bitset of the transit schedules of this tile that are valid on
+   * a day. Computed once per day and shared by all requests for that day,
+   * so checking a schedule index is a single bit lookup
+   * (see DepartureTable::test).
+   * @param   day               Days since the tile creation date.
+   * @param   dow               Day of week (see graphconstants.h)
+   * @param   date_before_tile  Is the date that was inputed before
+   *                            the tile creation date?
+   * @return  Returns the bitset (bit i set if schedule i is valid).
+   */
+  std::shared_ptr<const DepartureTable::bitmap_t> GetActiveSchedules(
+      const uint32_t day, const uint32_t dow, bool date_before_tile) const;
+
+  /**
+   * Get the departures on a line within a time window that run on a day,
+   * in departure time order. For profile (range) queries that need every
+   * departure in the window rather than only the next one.
+   * @param   lineid            Transit Line Id
+   * @param   start             Start of the window (seconds from midnight).
+   * @param   end               End of the window, inclusive (seconds from
+   *                            midnight).
+   * @param   day               Days since the tile creation date.
+   * @param   dow               Day of week (see graphconstants.h)
+   * @param   date_before_tile  Is the date that was inputed before
+   *                            the tile creation date?
+   * @param   wheelchair        Only include departures with wheelchair access if true
+   * @param   bicyle            Only include departures with bicycle access if true
+   * @return  Returns the departures (empty if there are none).
+   */
+  DepartureWindow GetDepartures(const uint32_t lineid, const uint32_t start,
+                                const uint32_t end, const uint32_t day,
+                                const uint32_t dow, bool date_before_tile,
+                                bool wheelchair, bool bicycle) const;
+
+  /**
+   * Get the departures of all lines in this tile within a time window in
+   * departure time order, e.g. as the connections of a connection scan.
+   * @param   start  Start of the window (seconds from midnight).
+   * @param   end    End of the window, inclusive (seconds from midnight).
+   * @return  Returns the departures of every day.
+   */
+  DeparturesByTime GetDeparturesByTime(const uint32_t start,
+                                       const uint32_t end) const;
+
+  /**
+   * Get the departures of all lines in this tile within a time window that
+   * run on a day, in departure time order.
+   * @param   start             Start of the window (seconds from midnight).
+   * @param   end               End of the window, inclusive (seconds from
+   *                            midnight).
+   * @param   day               Days since the tile creation date.
+   * @param   dow               Day of week (see graphconstants.h)
+   * @param   date_before_tile  Is the date that was inputed before
+   *                            the tile creation date?
+   * @param   wheelchair        Only include departures with wheelchair access if true
+   * @param   bicyle            Only include departures with bicycle access if true
+   * @return  Returns the departures.
+   */
+  DeparturesByTime GetDeparturesByTime(const uint32_t start, const uint32_t end,
+                                       const uint32_t day, const uint32_t dow,
+                                       bool date_before_tile, bool wheelchair,
+                                       bool bicycle) const;
+
   /**
    * Get the departure given the directed edge Id and tripid
    * @param   lineid  Transit Line Id
    * @param   tripid  Trip Id.
    * @return  Returns a pointer to the transit departure information.
-   *          Returns nullptr if no departure is found.
+   *          Returns nullptr if no departure is found or the trip is
+   *          cancelled by a realtime update (see SetRealtimeOverlay).
    */
   const TransitDeparture* GetTransitDeparture(const uint32_t lineid,
                                               const uint32_t tripid) const;
 
+  /**
+   * Lays realtime delays and cancellations over the departures of this
+   * tile. Copies of the tile share the overlay and updates published to it
+   * apply without reloading the tile.
+   * @param  overlay  Realtime overlay (nullptr to remove it).
+   */
+  void SetRealtimeOverlay(std::shared_ptr<const RealtimeOverlay> overlay);
+
+  /**
+   * Get the realtime delay of a departure.
+   * @param   departure  Departure of this tile.
+   * @return  Returns the delay (seconds, negative if early), 0 if the
+   *          departure's trip has no update.
+   */
+  int32_t GetDepartureDelay(const TransitDeparture& departure) const;
+
+  /**
+   * Is a trip cancelled by a realtime update?
+   * @param   tripid  Trip Id.
+   * @return  Returns true if the trip is cancelled.
+   */
+  bool IsTripCancelled(const uint32_t tripid) const;
+
+  /**
+   * Get the next departure of a trip at or after a time, e.g. to continue
+   * on the same vehicle from the stop it arrives at.
+   * @param   tripid  Trip Id.
+   * @param   time    Time (seconds from midnight), e.g. the arrival time.
+   * @return  Returns a pointer to the transit departure information.
+   *          Returns nullptr if the trip has no more departures in this
+   *          tile or is cancelled. Realtime delays are applied before
+   *          comparing to the time.
+   */
+  const TransitDeparture* GetNextTripDeparture(const uint32_t tripid,
+                                               const uint32_t time) const;
+
+  /**
+   * Get the next departure of a block at or after a time, e.g. to stay on
+   * the vehicle when it continues as the next trip of its block (an in-seat
+   * transfer).
+   * @param   blockid  Block Id.
+   * @param   time     Time (seconds from midnight), e.g. the arrival time.
+   * @return  Returns a pointer to the transit departure information.
+   *          Returns nullptr if the block has no more departures in this
+   *          tile or is 0 (no block). Cancelled trips are skipped and
+   *          realtime delays applied before comparing to the time.
+   */
+  const TransitDeparture* GetNextBlockDeparture(const uint32_t blockid,
+                                                const uint32_t time) const;
+
   /**
    * Get the departures based on the line Id
    * @return  Returns a map of lineids to departures.
@@ -226,26 +521,34 @@ class GraphTile {
   std::unordered_map<uint32_t,TransitDeparture*> GetTransitDepartures() const;
 
   /**
-   * Get the stop onestops in this tile
+   * Get the stop onestops in this tile. Prefer GetOneStopIndexes, which
+   * does not build string keyed maps.
    * @return  Returns a map of onestops
    */
-  std::unordered_map<std::string, tile_index_pair>
+  const std::unordered_map<std::string, tile_index_pair>&
     GetStopOneStops() const;
 
   /**
    * Get the route onestops in this tile
    * @return  Returns a map of onestops
    */
-  std::unordered_map<std::string, std::list<tile_index_pair>>
+  const std::unordered_map<std::string, std::list<tile_index_pair>>&
     GetRouteOneStops() const;
 
   /**
    * Get the operator onestops in this tile
    * @return  Returns a map of onestops
    */
-  std::unordered_map<std::string, std::list<tile_index_pair>>
+  const std::unordered_map<std::string, std::list<tile_index_pair>>&
     GetOperatorOneStops() const;
 
+  /**
+   * Get flat indexes of the stop, route and operator onestop Ids in this
+   * tile. Built on first use; empty unless this is a transit tile.
+   * @return  Returns the onestop indexes.
+   */
+  const OneStopIndexes& GetOneStopIndexes() const;
+
   /**
    * Get the transit stop given its index
    * @param   idx  stop index.
@@ -295,7 +598,42 @@ class GraphTile {
    */
   midgard::iterable_t<GraphId> GetBin(size_t index) const;
 
+  /**
+   * Get the spatial index over the edge shapes in this tile. The index is
+   * built (decoding every shape in the tile) on first access and kept for
+   * the life of the tile, so prefer GetBin for one-off lookups.
+   * @return  Returns the spatial index for this tile.
+   */
+  const EdgeSpatialIndex& GetSpatialIndex() const;
+
+  /**
+   * Get the edge shapes of this tile as fixed point coordinates for fast
+   * distance computations. Built on first use.
+   * @return  Returns the quantized shapes.
+   */
+  const QuantizedShapes& GetQuantizedShapes() const;
+
+  /**
+   * Get summary statistics of the graph in this tile (edges by road class,
+   * use and access, total length, section sizes). Computed on first use
+   * and kept for the life of the tile.
+   * @return  Returns the tile statistics.
+   */
+  const TileStatistics& GetStatistics() const;
+
  protected:
+  // Statistics include the sizes of the edge info and text list
+  friend struct TileStatistics;
+
+  /**
+   * Throw for an index outside of one of the tile's arrays. Kept out of line
+   * so building the message stays off the accessors' hot paths.
+   * @param  idx  Index that was requested.
+   */
+  [[noreturn]] VALHALLA_COLD void node_out_of_bounds(const size_t idx) const;
+  [[noreturn]] VALHALLA_COLD void directededge_out_of_bounds(const size_t idx) const;
+  [[noreturn]] VALHALLA_COLD void textlist_out_of_bounds() const;
+
 
   // Size of the tile in bytes
   size_t size_;
@@ -356,25 +694,158 @@ class GraphTile {
   // indices in the tile header.
   GraphId* edge_bins_;
 
-  // Map of stop one stops in this tile.
-  std::unordered_map<std::string, tile_index_pair> stop_one_stops;
+  // Spatial index over the edge shapes, built on first use.
+  LazyValue<EdgeSpatialIndex> spatial_index_;
 
-  // Map of route one stops in this tile.
-  std::unordered_map<std::string, std::list<tile_index_pair>> route_one_stops;
+  // Fixed point edge shapes, built on first use.
+  LazyValue<QuantizedShapes> quantized_shapes_;
 
-  // Map of operator one stops in this tile.
-  std::unordered_map<std::string, std::list<tile_index_pair>> oper_one_stops;
+  // Name ids of the text list, built on first use.
+  LazyValue<TileNameIds> name_ids_;
+
+  // Summary statistics, computed on first use.
+  LazyValue<TileStatistics> statistics_;
+
+  /**
+   * Get the name ids of the text list, building them on first use.
+   * @return  Returns the name ids.
+   */
+  const TileNameIds& name_ids() const;
+
+  // Indexes of the signs, access restrictions and departures by edge index
+  // or line Id, built on first use.
+  LazyValue<RecordIndex> sign_index_;
+  LazyValue<RecordIndex> restriction_index_;
+  LazyValue<RecordIndex> departure_index_;
+
+  /**
+   * Get the index of the signs by edge index, building it on first use.
+   * @return  Returns the sign index.
+   */
+  const RecordIndex& sign_index() const;
+
+  /**
+   * Get the index of the access restrictions by edge index, building it on
+   * first use.
+   * @return  Returns the access restriction index.
+   */
+  const RecordIndex& restriction_index() const;
+
+  /**
+   * Get the index of the transit departures by line Id, building it on
+   * first use.
+   * @return  Returns the departure index.
+   */
+  const RecordIndex& departure_index() const;
+
+  // Columnar departure times, flags and per day validity, built on first
+  // use.
+  LazyValue<DepartureTable> departure_table_;
+
+  /**
+   * Get the departure table, building it on first use.
+   * @return  Returns the departure table.
+   */
+  const DepartureTable& departure_table() const;
+
+  // Index of the transit departures by trip and block Id, built on first
+  // use.
+  LazyValue<TripIndex> trip_index_;
+
+  /**
+   * Get the index of the departures by trip and block Id, building it on
+   * first use.
+   * @return  Returns the trip index.
+   */
+  const TripIndex& trip_index() const;
+
+  /**
+   * Finds the first of a trip's or block's departures at or after a time.
+   * @param   positions  Departure indexes in time order.
+   * @param   time       Time (seconds from midnight).
+   * @return  Returns the departure or nullptr if there is none.
+   */
+  const TransitDeparture* first_departure_after(
+      const TripIndex::positions_t& positions, const uint32_t time) const;
+
+  // Realtime delays and cancellations, shared by copies of the tile.
+  std::shared_ptr<const RealtimeOverlay> realtime_;
+
+  /**
+   * Get the realtime updates of this tile.
+   * @param   reader  Reader of the tile's overlay, which must be kept while
+   *                  the tile's updates are used.
+   * @return  Returns the tile's updates or nullptr if there are none.
+   */
+  const RealtimeDelays::TileDelays* realtime_delays(
+      const RealtimeOverlay::Reader& reader) const;
+
+  /**
+   * Get the next departure of a line (see GetNextDeparture).
+   * @param   use_realtime  Apply the realtime updates on the current day if
+   *                        true, use the scheduled times only if false.
+   * @return  Returns the departure, its day offset and its delay.
+   */
+  DayDeparture next_departure(const uint32_t lineid,
+                              const uint32_t current_time,
+                              const uint32_t day, const uint32_t dow,
+                              bool date_before_tile, bool wheelchair,
+                              bool bicycle, const uint32_t horizon_days,
+                              const bool use_realtime) const;
+
+  /**
+   * Finds the valid departure of a range that leaves first at or after a
+   * time once realtime delays are applied, skipping cancelled trips.
+   * @param   delays      Realtime updates of this tile.
+   * @param   begin       First departure of the range.
+   * @param   end         One past the last departure of the range.
+   * @param   time        Time (seconds from midnight).
+   * @param   valid       Validity bitmap of the day.
+   * @param   wheelchair  Only find departures with wheelchair access if true.
+   * @param   bicycle     Only find departures with bicycle access if true.
+   * @param   delay       Set to the delay of the departure found.
+   * @return  Returns the index of the departure or end if there is none.
+   */
+  uint32_t next_delayed(const RealtimeDelays::TileDelays& delays,
+                        const uint32_t begin, const uint32_t end,
+                        const uint32_t time, const DepartureTable::bitmap_t& valid,
+                        const bool wheelchair, const bool bicycle,
+                        int32_t& delay) const;
+
+  // Decoded shapes keyed by edge info offset, if enabled.
+  std::shared_ptr<ShapeCache> shape_cache_;
+
+  // Onestop Id maps of a transit tile.
+  struct OneStopMaps {
+    // Map of stop one stops in this tile.
+    std::unordered_map<std::string, tile_index_pair> stops;
+
+    // Map of route one stops in this tile.
+    std::unordered_map<std::string, std::list<tile_index_pair>> routes;
+
+    // Map of operator one stops in this tile.
+    std::unordered_map<std::string, std::list<tile_index_pair>> operators;
+  };
+
+  // Onestop Id maps, built from the indexes on first use.
+  LazyValue<OneStopMaps> one_stops_;
+
+  // Onestop Id indexes, built on first use.
+  LazyValue<OneStopIndexes> one_stop_indexes_;
 
   /**
    * Set pointers to internal tile data structures.
-   * @param  graphid    Graph Id for the tile.
    * @param  tile_ptr   Pointer to the start of the tile.
    * @param  tile_size  Tile size in bytes.
    */
-  void Initialize(const GraphId& graphid, char* tile_ptr,
-                  const size_t tile_size);
+  void Initialize(char* tile_ptr, const size_t tile_size);
 
-  void AssociateOneStopIds(const GraphId& graphid);
+  /**
+   * Get the onestop Id maps, building them on first use. Only transit
+   * tiles have onestop Ids; the maps of other tiles are empty.
+   * @return  Returns the onestop Id maps.
+   */
+  const OneStopMaps& one_stops() const;
 };
 
 }
@@ -0,0 +1,58 @@
+#ifndef VALHALLA_BALDR_LAZY_VALUE_H_
+#define VALHALLA_BALDR_LAZY_VALUE_H_
+
+#include <memory>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * A value built on first use, e.g. an index over a section of a tile that
+ * most requests never need. The value is published with the atomic
+ * shared_ptr operations so a tile shared by several threads can be used
+ * from all of them: threads racing on the first use may each build the
+ * value but all of them get the one published first. Once built the value
+ * is not replaced, so references to it stay valid as long as its owner.
+ */
+template <class T>
+class LazyValue {
+ public:
+  LazyValue() {
+  }
+
+  // Copies share the value if it is already built
+  LazyValue(const LazyValue& other)
+      : value_(std::atomic_load(&other.value_)) {
+  }
+
+  LazyValue& operator=(const LazyValue& other) {
+    std::atomic_store(&value_, std::atomic_load(&other.value_));
+    return *this;
+  }
+
+  /**
+   * Get the value, building it on first use.
+   * @param  build  Builds the value, returning a std::shared_ptr<const T>.
+   * @return  Returns the value.
+   */
+  template <class build_t>
+  const T& get(const build_t& build) const {
+    std::shared_ptr<const T> value = std::atomic_load(&value_);
+    if (!value) {
+      // On failure value is set to the one another thread published
+      std::shared_ptr<const T> built = build();
+      if (std::atomic_compare_exchange_strong(&value_, &value, built)) {
+        value = built;
+      }
+    }
+    return *value;
+  }
+
+ protected:
+  mutable std::shared_ptr<const T> value_;
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_LAZY_VALUE_H_
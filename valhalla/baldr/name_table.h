@@ -0,0 +1,128 @@
+#ifndef VALHALLA_BALDR_NAME_TABLE_H_
+#define VALHALLA_BALDR_NAME_TABLE_H_
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/text_view.h>
+
+namespace valhalla {
+namespace baldr {
+
+constexpr uint32_t kInvalidNameId = 0xffffffff;
+
+/**
+ * Process wide table of interned names. Each distinct string gets a small
+ * integer id that is the same across all tiles, so names from different
+ * tiles (or edges) can be compared as integers. Safe to use from multiple
+ * threads. Names are never removed: the table grows by every distinct name
+ * of every tile whose global name ids are used, for the life of the
+ * process, even after those tiles are dropped from the cache.
+ */
+class NameTable {
+ public:
+  /**
+   * Get the process wide table.
+   * @return  Returns the name table.
+   */
+  static NameTable& instance();
+
+  /**
+   * Get the id of a name, adding it to the table if it is new.
+   * @param  name  Name to intern.
+   * @return  Returns the id of the name.
+   */
+  uint32_t Intern(const TextView& name);
+
+  /**
+   * Get the id of a name without adding it.
+   * @param  name  Name to look for.
+   * @return  Returns the id or kInvalidNameId if the name is not interned.
+   */
+  uint32_t Find(const TextView& name) const;
+
+  /**
+   * Get the name given its id. The reference stays valid for the life of
+   * the table.
+   * @param  id  Name id.
+   * @return  Returns the name.
+   */
+  const std::string& Name(const uint32_t id) const;
+
+  /**
+   * Get the number of interned names.
+   * @return  Returns the number of names.
+   */
+  size_t size() const;
+
+ protected:
+  mutable std::mutex mutex_;
+
+  // Ids keyed by views of the names, which are owned by names_ (a deque so
+  // they never move) and so can be looked up without a copy
+  std::unordered_map<TextView, uint32_t, TextViewHash> ids_;
+  std::deque<std::string> names_;
+};
+
+/**
+ * Name ids of one tile's text list. Two offsets holding the same string map
+ * to the same tile name id (the offset of its first occurrence), whether or
+ * not the tile builder removed duplicates. Tile name ids are also mapped to
+ * NameTable ids for comparing names across tiles: every distinct name of
+ * the tile is interned once when this is built, so looking up either id is
+ * a search of a sorted array without any locking.
+ */
+class TileNameIds {
+ public:
+  /**
+   * Constructor. Scans the text list for duplicate strings and interns
+   * each distinct string in the NameTable.
+   * @param  text       Pointer to the start of the text list.
+   * @param  text_size  Size (bytes) of the text list.
+   */
+  TileNameIds(const char* text, const size_t text_size);
+
+  /**
+   * Get the tile name id of a name.
+   * @param  offset  Offset of the name within the text list.
+   * @return  Returns the offset of the first copy of the same string.
+   */
+  uint32_t local(const uint32_t offset) const;
+
+  /**
+   * Get the process wide name id of a name.
+   * @param  offset  Offset of the name within the text list.
+   * @return  Returns the NameTable id of the name.
+   */
+  uint32_t global(const uint32_t offset) const;
+
+ protected:
+  const char* text_;
+  size_t text_size_;
+
+  // Offsets of strings that repeat an earlier string and the offset of the
+  // earlier copy, sorted by offset. Unique strings are not listed.
+  std::vector<std::pair<uint32_t, uint32_t>> duplicates_;
+
+  // Offset of each string and its NameTable id, sorted by offset
+  std::vector<std::pair<uint32_t, uint32_t>> global_;
+};
+
+/**
+ * Intersection of two sorted lists of name ids.
+ * @param  a       Sorted name ids.
+ * @param  b       Sorted name ids.
+ * @param  common  Name ids in both lists (previous contents cleared).
+ */
+void common_name_ids(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                     std::vector<uint32_t>& common);
+
+}
+}
+
+#endif  // VALHALLA_BALDR_NAME_TABLE_H_
@@ -0,0 +1,113 @@
+#ifndef VALHALLA_BALDR_ONESTOP_INDEX_H_
+#define VALHALLA_BALDR_ONESTOP_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/text_view.h>
+#include <valhalla/midgard/util.h>
+
+namespace valhalla {
+namespace baldr {
+
+using tile_index_pair = std::pair<uint32_t, uint32_t>;
+
+/**
+ * Flat index from TransitLand onestop Ids to (tile Id, index) pairs: the
+ * stop index for stops, the line Id for routes and operators. The onestop
+ * Ids are kept sorted in one text buffer and the pairs of each Id in one
+ * contiguous run, so a lookup is a binary search returning a range of the
+ * pairs with no copies and no per-entry allocations. The index owns its
+ * text so it stays valid after the tiles it was built from are dropped.
+ */
+class OneStopIndex {
+ public:
+  using item_t = std::pair<TextView, tile_index_pair>;
+
+  /**
+   * A onestop Id and its pairs.
+   */
+  struct Entry {
+    TextView onestop;
+    midgard::iterable_t<const tile_index_pair> pairs;
+  };
+
+  /**
+   * Constructor. Empty index.
+   */
+  OneStopIndex();
+
+  /**
+   * Constructor given onestop Ids and their pairs in any order. Repeated
+   * (onestop Id, pair) items are kept once. The text of the Ids is copied.
+   * @param  items  Onestop Ids and pairs.
+   */
+  explicit OneStopIndex(std::vector<item_t> items);
+
+  /**
+   * Merges several indexes (e.g. one per tile) into one.
+   * @param  indexes  Indexes to merge.
+   * @return  Returns the merged index.
+   */
+  static OneStopIndex merge(const std::vector<const OneStopIndex*>& indexes);
+
+  OneStopIndex(const OneStopIndex&) = delete;
+  OneStopIndex& operator=(const OneStopIndex&) = delete;
+  OneStopIndex(OneStopIndex&&) = default;
+  OneStopIndex& operator=(OneStopIndex&&) = default;
+
+  /**
+   * Get the pairs of a onestop Id.
+   * @param  onestop  Onestop Id.
+   * @return  Returns the pairs, sorted (empty if the Id is not found).
+   */
+  midgard::iterable_t<const tile_index_pair> find(const TextView& onestop) const;
+
+  /**
+   * Get the number of distinct onestop Ids.
+   * @return  Returns the number of Ids.
+   */
+  size_t size() const;
+
+  /**
+   * Get an entry given its position, in onestop Id order.
+   * @param  i  Position of the entry.
+   * @return  Returns the onestop Id and its pairs.
+   */
+  Entry entry(const size_t i) const;
+
+ protected:
+  // Null terminated onestop Ids in sorted order
+  std::string text_;
+
+  // Offset of each onestop Id in the text and of its first pair, followed by
+  // a final entry with the ends of both
+  std::vector<std::pair<uint32_t, uint32_t>> offsets_;
+
+  // Pairs of all the onestop Ids
+  std::vector<tile_index_pair> pairs_;
+
+  /**
+   * Get the onestop Id of an entry.
+   * @param  i  Position of the entry.
+   * @return  Returns the onestop Id.
+   */
+  TextView onestop(const size_t i) const;
+};
+
+/**
+ * The onestop Id indexes of a transit tile (or of all transit tiles).
+ */
+struct OneStopIndexes {
+  OneStopIndex stops;      // Stop Id to (tile Id, stop index)
+  OneStopIndex routes;     // Route Id to (tile Id, line Id)
+  OneStopIndex operators;  // Operator Id to (tile Id, line Id) of all of
+                           // its routes' lines
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_ONESTOP_INDEX_H_
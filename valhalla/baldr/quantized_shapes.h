@@ -0,0 +1,168 @@
+#ifndef VALHALLA_BALDR_QUANTIZED_SHAPES_H_
+#define VALHALLA_BALDR_QUANTIZED_SHAPES_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace baldr {
+
+class GraphTile;
+
+/**
+ * Computes the squared distance (square meters) from a query point to each
+ * segment of a run of fixed point shape points. Uses AVX2 (8 segments at a
+ * time) or SSE2 (4 at a time, so any SSE4 build) when built with them and a
+ * portable loop otherwise. The differences of the query and the points
+ * are taken in 32 bits, so they must be within about 214 degrees.
+ * @param  x         Fixed point x (longitude) of each point.
+ * @param  y         Fixed point y (latitude) of each point.
+ * @param  count     Number of points (count - 1 segments).
+ * @param  qx        Fixed point x of the query point.
+ * @param  qy        Fixed point y of the query point.
+ * @param  scale_x   Meters per fixed point unit of x at the query latitude.
+ * @param  scale_y   Meters per fixed point unit of y.
+ * @param  distances Output, count - 1 squared distances.
+ */
+void squared_segment_distances(const int32_t* x, const int32_t* y,
+                               const uint32_t count, const int32_t qx,
+                               const int32_t qy, const float scale_x,
+                               const float scale_y, float* distances);
+
+/**
+ * Edge shapes of a tile stored as 32 bit fixed point coordinates (1e-7
+ * degrees) relative to an origin, in one contiguous run of points per edge
+ * info. Distances from a point to the segments of an edge are then computed
+ * many segments at a time without decoding any varints.
+ *
+ * The shapes are kept in a single flat buffer that can be written out as an
+ * optional tile section and used in place when read back:
+ *   uint32 edge count, uint32 point count, int32 origin x, int32 origin y
+ *   uint32 edge info offset of each edge (sorted)
+ *   uint32 first point of each edge (edge count + 1 entries)
+ *   int32 x of each point, int32 y of each point
+ */
+class QuantizedShapes {
+ public:
+  // Degrees per fixed point unit
+  static constexpr double kPrecision = 1e-7;
+
+  /**
+   * A run of points of one edge shape.
+   */
+  struct Run {
+    const int32_t* x;
+    const int32_t* y;
+    uint32_t count;
+  };
+
+  /**
+   * Closest segment of an edge shape to a point.
+   */
+  struct Closest {
+    float distance;    // Distance (meters)
+    uint32_t segment;  // Index of the first point of the segment
+  };
+
+  /**
+   * Constructor. Decodes and quantizes the shape of each edge in the tile.
+   * @param  tile  Graph tile.
+   */
+  explicit QuantizedShapes(const GraphTile& tile);
+
+  /**
+   * Constructor given edge info offsets and their shapes.
+   * @param  shapes  Edge info offsets and shapes.
+   */
+  explicit QuantizedShapes(
+      const std::vector<std::pair<uint32_t, std::vector<midgard::PointLL>>>& shapes);
+
+  /**
+   * Constructor given a previously built buffer (e.g. a tile section). The
+   * buffer is used in place and must outlive this object.
+   * @param  data  Pointer to the buffer.
+   * @param  size  Size (bytes) of the buffer.
+   */
+  QuantizedShapes(const char* data, const size_t size);
+
+  QuantizedShapes(const QuantizedShapes&) = delete;
+  QuantizedShapes& operator=(const QuantizedShapes&) = delete;
+  QuantizedShapes(QuantizedShapes&&) = default;
+  QuantizedShapes& operator=(QuantizedShapes&&) = default;
+
+  /**
+   * Get the buffer holding the shapes, for writing it out.
+   * @return  Returns a pointer to the buffer.
+   */
+  const char* data() const;
+
+  /**
+   * Get the size of the buffer.
+   * @return  Returns the size (bytes).
+   */
+  size_t size() const;
+
+  /**
+   * Get the number of edge shapes.
+   * @return  Returns the number of edge shapes.
+   */
+  uint32_t edge_count() const;
+
+  /**
+   * Get the run of points of an edge shape.
+   * @param  edgeinfo_offset  Offset of the edge info within the tile.
+   * @return  Returns the run (with a count of 0 if the edge is not found).
+   */
+  Run shape(const uint32_t edgeinfo_offset) const;
+
+  /**
+   * Get a point of a run as a PointLL.
+   * @param  run  Run of points.
+   * @param  i    Index of the point.
+   * @return  Returns the point.
+   */
+  midgard::PointLL point(const Run& run, const uint32_t i) const;
+
+  /**
+   * Find the closest segment of an edge shape to a point. Longitudes are
+   * compared the short way around, across the antimeridian if need be.
+   * @param  edgeinfo_offset  Offset of the edge info within the tile.
+   * @param  pt               Query point.
+   * @return  Returns the closest segment and its distance. The distance is
+   *          the max float if the edge is not found.
+   */
+  Closest closest(const uint32_t edgeinfo_offset, const midgard::PointLL& pt) const;
+
+ protected:
+  // Owned buffer, empty when the shapes are used in place
+  std::vector<uint32_t> buffer_;
+
+  // Sections of the buffer
+  const uint32_t* header_;
+  const uint32_t* keys_;
+  const uint32_t* starts_;
+  const int32_t* x_;
+  const int32_t* y_;
+  size_t size_;
+
+  /**
+   * Builds the buffer from edge info offsets and shapes.
+   * @param  shapes  Edge info offsets and shapes.
+   */
+  void build(std::vector<std::pair<uint32_t, std::vector<midgard::PointLL>>> shapes);
+
+  /**
+   * Sets the section pointers.
+   * @param  data  Start of the buffer.
+   * @param  size  Size (bytes) of the buffer.
+   */
+  void set_pointers(const char* data, const size_t size);
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_QUANTIZED_SHAPES_H_
@@ -0,0 +1,163 @@
+#ifndef VALHALLA_BALDR_REALTIME_OVERLAY_H_
+#define VALHALLA_BALDR_REALTIME_OVERLAY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Realtime update of one trip: the delays of its departures or the
+ * cancellation of the whole trip.
+ */
+struct TripUpdate {
+  bool cancelled;   // Trip does not run
+  int32_t delay;    // Delay (seconds, negative if early) of departures
+                    // without a stop delay
+  std::vector<std::pair<uint32_t, int32_t>> stop_delays;  // Delay by the line
+                    // Id of the departure (i.e. the stop it departs from)
+
+  /**
+   * Get the delay of the trip's departure on a line.
+   * @param  lineid  Line Id of the departure.
+   * @return  Returns the delay (seconds).
+   */
+  int32_t delay_at(const uint32_t lineid) const;
+};
+
+/**
+ * A set of realtime trip updates, by tile and trip Id. Built in full and
+ * then published to a RealtimeOverlay, after which it is not modified.
+ */
+class RealtimeDelays {
+ public:
+  /**
+   * The trip updates of one tile and the range of their delays, which
+   * bounds how far a delayed departure can move.
+   */
+  struct TileDelays {
+    std::unordered_map<uint32_t, TripUpdate> trips;
+    int32_t min_delay;
+    int32_t max_delay;
+
+    /**
+     * Get the update of a trip.
+     * @param  tripid  Trip Id.
+     * @return  Returns the update or nullptr if the trip has none.
+     */
+    const TripUpdate* trip(const uint32_t tripid) const;
+  };
+
+  /**
+   * Adds (or replaces) the update of a trip.
+   * @param  tile    Tile Id of the trip's departures (any Id within the
+   *                 tile, only its tile and level are used).
+   * @param  tripid  Trip Id.
+   * @param  update  Delays or cancellation of the trip.
+   */
+  void Add(const GraphId& tile, const uint32_t tripid, TripUpdate update);
+
+  /**
+   * Get the trip updates of a tile.
+   * @param  tile  Tile Id (any Id within the tile).
+   * @return  Returns the updates or nullptr if the tile has none.
+   */
+  const TileDelays* tile(const GraphId& tile) const;
+
+ protected:
+  std::unordered_map<GraphId, TileDelays> tiles_;
+};
+
+/**
+ * Realtime delays and cancellations laid over the static transit
+ * departures of the tiles. A batch of updates is published by swapping in
+ * a new RealtimeDelays as a whole, so readers see either all or none of a
+ * batch and tiles never need to be reloaded.
+ *
+ * Reading is lock free: a Reader counts itself in one of two counters,
+ * picked by the parity of the current epoch, and then loads the current
+ * batch with a plain atomic load. Publish swaps in the new batch, moves to the next epoch and
+ * waits for the readers counted in the previous one before it drops the
+ * superseded batch, which is then freed once no one else holds it.
+ */
+class RealtimeOverlay {
+ public:
+  /**
+   * Read access to the current updates, which stay valid for the life of
+   * the reader. Readers are meant to be short lived: Publish waits for the
+   * readers that may still see the previous updates, so a thread must not
+   * publish to an overlay while it holds a reader of it.
+   */
+  class Reader {
+   public:
+    /**
+     * Constructor
+     * @param  overlay  Overlay to read (nullptr for no updates).
+     */
+    explicit Reader(const RealtimeOverlay* overlay);
+
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    /**
+     * Get the updates.
+     * @return  Returns the updates or nullptr if none are published.
+     */
+    const RealtimeDelays* delays() const {
+      return current_ ? current_->get() : nullptr;
+    }
+
+   protected:
+    friend class RealtimeOverlay;
+
+    // Counter this reader is counted in and the updates it read
+    std::atomic<uint32_t>* readers_;
+    const std::shared_ptr<const RealtimeDelays>* current_;
+  };
+
+  RealtimeOverlay();
+  ~RealtimeOverlay();
+
+  RealtimeOverlay(const RealtimeOverlay&) = delete;
+  RealtimeOverlay& operator=(const RealtimeOverlay&) = delete;
+
+  /**
+   * Replaces the current updates with a new batch. Waits for the readers
+   * that may still see the previous updates.
+   * @param  delays  New updates (nullptr to clear them).
+   */
+  void Publish(std::shared_ptr<const RealtimeDelays> delays);
+
+  /**
+   * Get the current updates, sharing them with the overlay.
+   * @return  Returns the updates or nullptr if none are published.
+   */
+  std::shared_ptr<const RealtimeDelays> delays() const;
+
+ protected:
+  // Current updates. Replaced by Publish and freed once no reader can see
+  // them, never null.
+  std::atomic<const std::shared_ptr<const RealtimeDelays>*> current_;
+
+  // Readers counted by the parity of the epoch they started in
+  std::atomic<uint64_t> epoch_;
+  mutable std::atomic<uint32_t> readers_[2];
+
+  // Serializes publishers
+  std::mutex publish_mutex_;
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_REALTIME_OVERLAY_H_
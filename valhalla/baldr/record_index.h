@@ -0,0 +1,102 @@
+#ifndef VALHALLA_BALDR_RECORD_INDEX_H_
+#define VALHALLA_BALDR_RECORD_INDEX_H_
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Index over a tile section whose records are sorted by a small integer key
+ * (signs and access restrictions by edge index, transit departures by line
+ * Id). A bitmap marks which keys have records and a start offset table holds
+ * the first record of each key that has any, so finding the records of a
+ * key is a bit test plus a popcount and a direct jump instead of a binary
+ * search. Keys without records are rejected by the bit test alone.
+ *
+ * The start offset table only has entries for keys that have records, with
+ * a running count of set bits per 64 bit word of the bitmap to find a key's
+ * entry, so the index is about 4 bytes per key with records plus 1.125 bits
+ * per possible key.
+ */
+class RecordIndex {
+ public:
+  /**
+   * Constructor. Throws if the records are not sorted by key.
+   * @param  records  Pointer to the first record.
+   * @param  count    Number of records.
+   * @param  key      Function returning the key of a record.
+   */
+  template <class record_t, class key_t>
+  RecordIndex(const record_t* records, const uint32_t count, const key_t& key)
+      : count_(count) {
+    if (count == 0)
+      return;
+    bits_.resize(key(records[count - 1]) / 64 + 1, 0);
+    uint32_t previous = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+      const uint32_t k = key(records[i]);
+      if (i > 0 && k < previous)
+        throw std::runtime_error("RecordIndex: records are not sorted by key");
+      if (i == 0 || k != previous) {
+        if (k / 64 >= bits_.size())
+          throw std::runtime_error("RecordIndex: records are not sorted by key");
+        bits_[k / 64] |= uint64_t(1) << (k % 64);
+        starts_.push_back(i);
+      }
+      previous = k;
+    }
+    starts_.push_back(count);
+    finish();
+  }
+
+  /**
+   * Does a key have any records?
+   * @param  key  Key (edge index or line Id).
+   * @return  Returns true if there is at least one record with the key.
+   */
+  bool has(const uint32_t key) const {
+    const uint32_t word = key / 64;
+    return word < bits_.size() && (bits_[word] >> (key % 64)) & 1;
+  }
+
+  /**
+   * Get the records of a key.
+   * @param  key  Key (edge index or line Id).
+   * @return  Returns the index of the first record with the key and one past
+   *          the last. Both are the record count if the key has no records.
+   */
+  std::pair<uint32_t, uint32_t> range(const uint32_t key) const;
+
+  /**
+   * Get the number of distinct keys with records.
+   * @return  Returns the number of keys.
+   */
+  uint32_t key_count() const;
+
+ protected:
+  // Number of records
+  uint32_t count_;
+
+  // Bit per key, set if the key has records
+  std::vector<uint64_t> bits_;
+
+  // Number of set bits in the words before each word of the bitmap
+  std::vector<uint32_t> ranks_;
+
+  // First record of each key with records, in key order, then the count
+  std::vector<uint32_t> starts_;
+
+  /**
+   * Computes the ranks once the bitmap is filled in.
+   */
+  void finish();
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_RECORD_INDEX_H_
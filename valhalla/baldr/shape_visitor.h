@@ -0,0 +1,243 @@
+#ifndef VALHALLA_BALDR_SHAPE_VISITOR_H_
+#define VALHALLA_BALDR_SHAPE_VISITOR_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/constants.h>
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Geometry operations over an edge shape that decode one point at a time
+ * rather than materializing a vector of points. Each takes a shape decoder
+ * by value: anything with PointLL pop() and bool empty() such as
+ * EdgeInfo::lazy_shape() (midgard::Shape7Decoder) or EdgeInfo::shape_stream().
+ * Operations that only need the start of the shape stop decoding as soon as
+ * they have their answer.
+ */
+
+/**
+ * Visits each segment of a shape in order.
+ * @param  decoder  Shape decoder.
+ * @param  visitor  Called with the start and end point of each segment and
+ *                  the segment index. Return false to stop decoding.
+ * @return  Returns the first point of the shape (invalid if it is empty).
+ */
+template <class decoder_t, class visitor_t>
+midgard::PointLL visit_segments(decoder_t decoder, const visitor_t& visitor) {
+  if (decoder.empty())
+    return {};
+  const midgard::PointLL first = decoder.pop();
+  midgard::PointLL a = first;
+  for (uint32_t i = 0; !decoder.empty(); i++) {
+    const midgard::PointLL b = decoder.pop();
+    if (!visitor(a, b, i))
+      break;
+    a = b;
+  }
+  return first;
+}
+
+/**
+ * Length (meters) of a shape.
+ * @param  decoder  Shape decoder.
+ * @return  Returns the length.
+ */
+template <class decoder_t>
+float shape_length(decoder_t decoder) {
+  float length = 0.0f;
+  visit_segments(decoder, [&length](const midgard::PointLL& a,
+                                    const midgard::PointLL& b, uint32_t) {
+    length += a.Distance(b);
+    return true;
+  });
+  return length;
+}
+
+/**
+ * Bounding box of a shape.
+ * @param  decoder  Shape decoder.
+ * @return  Returns the bounding box.
+ */
+template <class decoder_t>
+midgard::AABB2<midgard::PointLL> shape_bounds(decoder_t decoder) {
+  float minx = std::numeric_limits<float>::max(), miny = minx;
+  float maxx = std::numeric_limits<float>::lowest(), maxy = maxx;
+  while (!decoder.empty()) {
+    const midgard::PointLL p = decoder.pop();
+    minx = std::min(minx, p.lng());
+    miny = std::min(miny, p.lat());
+    maxx = std::max(maxx, p.lng());
+    maxy = std::max(maxy, p.lat());
+  }
+  return midgard::AABB2<midgard::PointLL>(minx, miny, maxx, maxy);
+}
+
+/**
+ * Result of projecting a point onto a shape.
+ */
+struct ShapeProjection {
+  midgard::PointLL point;  // Closest point on the shape
+  float distance;          // Distance (meters) from the query point
+  uint32_t segment;        // Index of the first point of the closest segment
+  float along;             // Distance (meters) along the shape to the point
+  float length;            // Length (meters) of the whole shape
+};
+
+/**
+ * Projects a point onto a shape. The closest point on each segment is found
+ * in a local equirectangular projection around the query point.
+ * @param  decoder  Shape decoder.
+ * @param  pt       Point to project.
+ * @return  Returns the projection. If the shape is empty the distance is
+ *          the max float.
+ */
+template <class decoder_t>
+ShapeProjection project(decoder_t decoder, const midgard::PointLL& pt) {
+  const float mx = midgard::kMetersPerDegreeLat * std::cos(pt.lat() * midgard::kRadPerDeg);
+  const float my = midgard::kMetersPerDegreeLat;
+  ShapeProjection result{ {}, std::numeric_limits<float>::max(), 0, 0.0f, 0.0f };
+  float best = std::numeric_limits<float>::max();
+  const midgard::PointLL first = visit_segments(decoder,
+      [&](const midgard::PointLL& a, const midgard::PointLL& b, const uint32_t i) {
+        const float ax = (a.lng() - pt.lng()) * mx, ay = (a.lat() - pt.lat()) * my;
+        const float dx = (b.lng() - a.lng()) * mx, dy = (b.lat() - a.lat()) * my;
+        const float len2 = dx * dx + dy * dy;
+        float t = len2 > 0.0f ? -(ax * dx + ay * dy) / len2 : 0.0f;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        const float px = ax + t * dx, py = ay + t * dy;
+        const float d2 = px * px + py * py;
+        const float segment_length = a.Distance(b);
+        if (d2 < best) {
+          best = d2;
+          result.point = midgard::PointLL(a.lng() + t * (b.lng() - a.lng()),
+                                          a.lat() + t * (b.lat() - a.lat()));
+          result.segment = i;
+          result.along = result.length + t * segment_length;
+        }
+        result.length += segment_length;
+        return true;
+      });
+
+  // A single point shape
+  if (best == std::numeric_limits<float>::max() && first.IsValid())
+    result.point = first;
+  if (result.point.IsValid())
+    result.distance = pt.Distance(result.point);
+  return result;
+}
+
+/**
+ * Gets the part of a shape between two fractions of its length. Stops
+ * decoding once the end fraction is reached.
+ * @param  decoder  Shape decoder.
+ * @param  begin    Fraction (0 to 1) along the shape to start at.
+ * @param  end      Fraction (0 to 1) along the shape to end at.
+ * @param  length   Length (meters) of the shape. If 0 it is computed first,
+ *                  which decodes the whole shape an extra time.
+ * @param  shape    Points of the partial shape (previous contents cleared).
+ */
+template <class decoder_t>
+void trim_shape(decoder_t decoder, float begin, float end, float length,
+                std::vector<midgard::PointLL>& shape) {
+  shape.clear();
+  if (length <= 0.0f)
+    length = shape_length(decoder);
+  begin = std::min(std::max(begin, 0.0f), 1.0f) * length;
+  end = std::max(std::min(end, 1.0f) * length, begin);
+
+  float along = 0.0f;
+  midgard::PointLL last;
+  const midgard::PointLL first = visit_segments(decoder,
+      [&](const midgard::PointLL& a, const midgard::PointLL& b, uint32_t) {
+        const float segment_length = a.Distance(b);
+        const float next = along + segment_length;
+        if (shape.empty() && begin <= next) {
+          const float t = segment_length > 0.0f ? (begin - along) / segment_length : 0.0f;
+          shape.emplace_back(a.lng() + t * (b.lng() - a.lng()), a.lat() + t * (b.lat() - a.lat()));
+        }
+        if (!shape.empty()) {
+          if (end <= next) {
+            const float t = segment_length > 0.0f ? (end - along) / segment_length : 1.0f;
+            shape.emplace_back(a.lng() + t * (b.lng() - a.lng()), a.lat() + t * (b.lat() - a.lat()));
+            return false;
+          }
+          shape.push_back(b);
+        }
+        along = next;
+        last = b;
+        return true;
+      });
+
+  // Starting beyond the end of the shape (the given length may not quite
+  // match it) leaves just the last point
+  if (shape.empty() && first.IsValid())
+    shape.push_back(last.IsValid() ? last : first);
+  if (shape.size() == 1)
+    shape.push_back(shape.front());
+}
+
+/**
+ * Heading (degrees from north) of a shape at a distance along it. Stops
+ * decoding once the segment containing that distance is reached, so the
+ * heading at the start of an edge only decodes two points.
+ * @param  decoder   Shape decoder.
+ * @param  distance  Distance (meters) along the shape.
+ * @return  Returns the heading of the segment at that distance (the last
+ *          segment if the distance is beyond the end). Returns 0 if the
+ *          shape has less than two distinct points.
+ */
+template <class decoder_t>
+float heading_at(decoder_t decoder, const float distance) {
+  float heading = 0.0f;
+  float along = 0.0f;
+  visit_segments(decoder, [&](const midgard::PointLL& a,
+                              const midgard::PointLL& b, uint32_t) {
+    if (a == b)
+      return true;
+    heading = a.Heading(b);
+    along += a.Distance(b);
+    return along < distance;
+  });
+  return heading;
+}
+
+/**
+ * Point at a distance along a shape. Stops decoding once it is reached.
+ * @param  decoder   Shape decoder.
+ * @param  distance  Distance (meters) along the shape.
+ * @return  Returns the point (the last point if the distance is beyond the
+ *          end, invalid if the shape is empty).
+ */
+template <class decoder_t>
+midgard::PointLL point_at(decoder_t decoder, const float distance) {
+  float along = 0.0f;
+  midgard::PointLL point;
+  const midgard::PointLL first = visit_segments(decoder,
+      [&](const midgard::PointLL& a, const midgard::PointLL& b, uint32_t) {
+        const float segment_length = a.Distance(b);
+        if (along + segment_length >= distance) {
+          const float t = segment_length > 0.0f ?
+                            std::max(distance - along, 0.0f) / segment_length : 0.0f;
+          point = midgard::PointLL(a.lng() + t * (b.lng() - a.lng()),
+                                   a.lat() + t * (b.lat() - a.lat()));
+          return false;
+        }
+        along += segment_length;
+        point = b;
+        return true;
+      });
+  return point.IsValid() ? point : first;
+}
+
+}
+}
+
+#endif  // VALHALLA_BALDR_SHAPE_VISITOR_H_
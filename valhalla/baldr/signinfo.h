@@ -2,6 +2,7 @@
 #define VALHALLA_BALDR_SIGNINFO_H_
 
 #include <valhalla/baldr/sign.h>
+#include <valhalla/baldr/text_view.h>
 
 namespace valhalla {
 namespace baldr {
@@ -36,6 +37,70 @@ class SignInfo {
   std::string text_;
 };
 
+/**
+ * Non-owning sign type and text. The text points into the tile's text list.
+ */
+struct SignView {
+  Sign::Type type;
+  TextView text;
+};
+
+/**
+ * Non-owning list of the signs of an edge. Iterating yields a SignView per
+ * sign without any heap allocation. Only valid while the tile is alive.
+ */
+class SignViews {
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = SignView;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const SignView*;
+    using reference = SignView;
+
+    iterator(const Sign* sign, const char* text, const size_t text_size)
+        : sign_(sign), text_(text), text_size_(text_size) { }
+    SignView operator*() const {
+      if (sign_->text_offset() >= text_size_)
+        throw std::runtime_error("GetSigns: offset exceeds size of text list");
+      return { sign_->type(),
+               TextView::terminated(text_ + sign_->text_offset(),
+                                    text_size_ - sign_->text_offset()) };
+    }
+    iterator& operator++() { ++sign_; return *this; }
+    iterator operator++(int) { iterator i = *this; ++sign_; return i; }
+    bool operator ==(const iterator& rhs) const { return sign_ == rhs.sign_; }
+    bool operator !=(const iterator& rhs) const { return sign_ != rhs.sign_; }
+   protected:
+    const Sign* sign_;
+    const char* text_;
+    size_t text_size_;
+  };
+
+  /**
+   * Constructor.
+   * @param  signs      Pointer to the first sign.
+   * @param  count      Number of signs.
+   * @param  text       Pointer to the start of the text list.
+   * @param  text_size  Size (bytes) of the text list.
+   */
+  SignViews(const Sign* signs, const uint32_t count, const char* text,
+            const size_t text_size)
+      : signs_(signs), count_(count), text_(text), text_size_(text_size) { }
+
+  uint32_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+  iterator begin() const { return iterator(signs_, text_, text_size_); }
+  iterator end() const { return iterator(signs_ + count_, text_, text_size_); }
+
+ protected:
+  const Sign* signs_;
+  uint32_t count_;
+  const char* text_;
+  size_t text_size_;
+};
+
 }
 }
 
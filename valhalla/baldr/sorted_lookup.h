@@ -0,0 +1,49 @@
+#ifndef VALHALLA_BALDR_SORTED_LOOKUP_H_
+#define VALHALLA_BALDR_SORTED_LOOKUP_H_
+
+#include <cstdint>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Finds the first item in a sorted array that is not less than the value
+ * being searched for (like std::lower_bound). Used for the sorted sections
+ * of a tile (signs, access restrictions, transit departures) that are keyed
+ * by edge index or line Id.
+ *
+ * The search is branchless: the loop runs a fixed log2(count) times and
+ * each step is a conditional move rather than a hard to predict branch.
+ * Both possible next midpoints are prefetched so the memory latency of the
+ * following step overlaps the current one.
+ * @param  items  Pointer to the first item of the sorted array.
+ * @param  count  Number of items in the array.
+ * @param  less   Predicate returning true if an item is less than the
+ *                value being searched for.
+ * @return  Returns the index of the first item not less than the value.
+ *          Returns count if all items are less.
+ */
+template <class T, class less_t>
+uint32_t branchless_lower_bound(const T* items, const uint32_t count,
+                                const less_t& less) {
+  if (count == 0) {
+    return 0;
+  }
+  const T* base = items;
+  uint32_t n = count;
+  while (n > 1) {
+    const uint32_t half = n / 2;
+#if defined(__GNUC__)
+    __builtin_prefetch(base + half / 2);
+    __builtin_prefetch(base + half + half / 2);
+#endif
+    base = less(base[half]) ? base + half : base;
+    n -= half;
+  }
+  return (base - items) + (less(*base) ? 1 : 0);
+}
+
+}
+}
+
+#endif  // VALHALLA_BALDR_SORTED_LOOKUP_H_
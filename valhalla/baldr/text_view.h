@@ -0,0 +1,199 @@
+#ifndef VALHALLA_BALDR_TEXT_VIEW_H_
+#define VALHALLA_BALDR_TEXT_VIEW_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Non-owning view of a string within a tile's text list (or another fixed
+ * piece of tile memory). Reading text through a view does no heap
+ * allocation. A view points directly into the tile so it is only valid
+ * while a GraphTile sharing that tile memory is alive (copies of a
+ * GraphTile share the same reference counted memory).
+ */
+class TextView {
+ public:
+  /**
+   * Constructor for an empty view.
+   */
+  TextView() : data_(""), size_(0) { }
+
+  /**
+   * Constructor.
+   * @param  data  Pointer to the first character.
+   * @param  size  Number of characters.
+   */
+  TextView(const char* data, const size_t size) : data_(data), size_(size) { }
+
+  /**
+   * Constructor given a null terminated string. Stops at max_size if there
+   * is no terminator before it.
+   * @param  data      Pointer to the first character.
+   * @param  max_size  Maximum number of characters to look at.
+   */
+  static TextView terminated(const char* data, const size_t max_size) {
+    const void* end = std::memchr(data, '\0', max_size);
+    return TextView(data, end == nullptr ? max_size :
+                    static_cast<const char*>(end) - data);
+  }
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const char* begin() const { return data_; }
+  const char* end() const { return data_ + size_; }
+  char operator[](const size_t i) const { return data_[i]; }
+
+  /**
+   * Copies the text into a string.
+   * @return  Returns the text as a string.
+   */
+  std::string str() const { return std::string(data_, size_); }
+
+  bool operator ==(const TextView& rhs) const {
+    return size_ == rhs.size_ && std::memcmp(data_, rhs.data_, size_) == 0;
+  }
+  bool operator !=(const TextView& rhs) const { return !(*this == rhs); }
+  bool operator ==(const std::string& rhs) const {
+    return size_ == rhs.size() && std::memcmp(data_, rhs.data(), size_) == 0;
+  }
+  bool operator !=(const std::string& rhs) const { return !(*this == rhs); }
+  bool operator ==(const char* rhs) const {
+    return std::strncmp(data_, rhs, size_) == 0 && rhs[size_] == '\0';
+  }
+  bool operator !=(const char* rhs) const { return !(*this == rhs); }
+
+  // Byte wise ordering, like std::string
+  bool operator <(const TextView& rhs) const {
+    int c = std::memcmp(data_, rhs.data_, size_ < rhs.size_ ? size_ : rhs.size_);
+    return c < 0 || (c == 0 && size_ < rhs.size_);
+  }
+
+ protected:
+  const char* data_;
+  size_t size_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const TextView& text) {
+  return os.write(text.data(), text.size());
+}
+
+/**
+ * FNV-1a hash of the text of a view, so views can key hash maps without
+ * copying the text into strings.
+ */
+struct TextViewHash {
+  size_t operator()(const TextView& text) const {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char c : text) {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+  }
+};
+
+/**
+ * Non-owning list of names given a list of offsets into a tile's text list.
+ * Iterating yields a TextView per name. Like TextView this points into tile
+ * memory and does no heap allocation.
+ */
+class NameViews {
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = TextView;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const TextView*;
+    using reference = TextView;
+
+    iterator(const uint32_t* offset, const char* text, const size_t text_size)
+        : offset_(offset), text_(text), text_size_(text_size) { }
+    TextView operator*() const { return get(*offset_, text_, text_size_); }
+    TextView operator[](const std::ptrdiff_t n) const { return *(*this + n); }
+    iterator& operator++() { ++offset_; return *this; }
+    iterator operator++(int) { iterator i = *this; ++offset_; return i; }
+    iterator& operator--() { --offset_; return *this; }
+    iterator operator--(int) { iterator i = *this; --offset_; return i; }
+    iterator& operator+=(const std::ptrdiff_t n) { offset_ += n; return *this; }
+    iterator& operator-=(const std::ptrdiff_t n) { offset_ -= n; return *this; }
+    iterator operator+(const std::ptrdiff_t n) const {
+      return iterator(offset_ + n, text_, text_size_);
+    }
+    friend iterator operator+(const std::ptrdiff_t n, const iterator& i) { return i + n; }
+    iterator operator-(const std::ptrdiff_t n) const {
+      return iterator(offset_ - n, text_, text_size_);
+    }
+    std::ptrdiff_t operator-(const iterator& rhs) const { return offset_ - rhs.offset_; }
+    bool operator ==(const iterator& rhs) const { return offset_ == rhs.offset_; }
+    bool operator !=(const iterator& rhs) const { return offset_ != rhs.offset_; }
+    bool operator <(const iterator& rhs) const { return offset_ < rhs.offset_; }
+    bool operator >(const iterator& rhs) const { return offset_ > rhs.offset_; }
+    bool operator <=(const iterator& rhs) const { return offset_ <= rhs.offset_; }
+    bool operator >=(const iterator& rhs) const { return offset_ >= rhs.offset_; }
+   protected:
+    const uint32_t* offset_;
+    const char* text_;
+    size_t text_size_;
+  };
+
+  /**
+   * Constructor.
+   * @param  offsets    Offsets of each name within the text list.
+   * @param  count      Number of names.
+   * @param  text       Pointer to the start of the text list.
+   * @param  text_size  Size (bytes) of the text list.
+   */
+  NameViews(const uint32_t* offsets, const uint32_t count, const char* text,
+            const size_t text_size)
+      : offsets_(offsets), count_(count), text_(text), text_size_(text_size) { }
+
+  uint32_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+  iterator begin() const { return iterator(offsets_, text_, text_size_); }
+  iterator end() const { return iterator(offsets_ + count_, text_, text_size_); }
+
+  /**
+   * Get the name at the specified index.
+   * @param  index  Index of the name.
+   * @return  Returns a view of the name.
+   */
+  TextView operator[](const uint32_t index) const {
+    if (index >= count_)
+      throw std::runtime_error("NameViews index was out of bounds");
+    return get(offsets_[index], text_, text_size_);
+  }
+
+  /**
+   * Get the text at an offset within a text list.
+   * @param  offset     Offset within the text list.
+   * @param  text       Pointer to the start of the text list.
+   * @param  text_size  Size (bytes) of the text list.
+   * @return  Returns a view of the text.
+   */
+  static TextView get(const uint32_t offset, const char* text, const size_t text_size) {
+    if (offset >= text_size)
+      throw std::runtime_error("GetNames: offset exceeds size of text list");
+    return TextView::terminated(text + offset, text_size - offset);
+  }
+
+ protected:
+  const uint32_t* offsets_;
+  uint32_t count_;
+  const char* text_;
+  size_t text_size_;
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_TEXT_VIEW_H_
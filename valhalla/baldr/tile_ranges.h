@@ -0,0 +1,138 @@
+#ifndef VALHALLA_BALDR_TILE_RANGES_H_
+#define VALHALLA_BALDR_TILE_RANGES_H_
+
+#include <cstdint>
+#include <iterator>
+
+#include <valhalla/baldr/checked_access.h>
+#include <valhalla/baldr/directededge.h>
+#include <valhalla/baldr/nodeinfo.h>
+#include <valhalla/midgard/util.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * A node of a tile together with its outbound directed edges.
+ */
+struct NodeEdges {
+  uint32_t id;                                   // Index of the node in the tile
+  const NodeInfo* node;                          // The node
+  midgard::iterable_t<const DirectedEdge> edges; // Its outbound directed edges
+};
+
+/**
+ * Range over every node of a tile and its outbound directed edges, for tile
+ * wide passes. The node and edge arrays are bounds checked when the range
+ * is created and each node's edges with a single compare as it is reached,
+ * rather than on every node() and directededge() call. While walking the
+ * nodes the outbound edges of a node a few places ahead are prefetched so
+ * the jump from each NodeInfo to its DirectedEdges does not stall.
+ */
+class NodeEdgesRange {
+ public:
+  // How many nodes ahead to prefetch the outbound edges of
+  static constexpr uint32_t kPrefetchDistance = 8;
+
+  class iterator : public std::iterator<std::forward_iterator_tag, NodeEdges> {
+   public:
+    iterator(const NodeEdgesRange* range, const uint32_t id)
+        : range_(range), id_(id) {
+      for (uint32_t i = id; i < id + kPrefetchDistance; ++i)
+        range_->prefetch(i);
+    }
+    iterator& operator++() {
+      range_->prefetch(++id_ + kPrefetchDistance - 1);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator it = *this;
+      ++(*this);
+      return it;
+    }
+    bool operator==(const iterator& other) const {
+      return id_ == other.id_;
+    }
+    bool operator!=(const iterator& other) const {
+      return id_ != other.id_;
+    }
+    NodeEdges operator*() const {
+      return range_->at(id_);
+    }
+   protected:
+    const NodeEdgesRange* range_;
+    uint32_t id_;
+  };
+
+  /**
+   * Constructor.
+   * @param  nodes       Pointer to the first node.
+   * @param  node_count  Number of nodes.
+   * @param  edges       Pointer to the first directed edge.
+   * @param  edge_count  Number of directed edges.
+   */
+  NodeEdgesRange(const NodeInfo* nodes, const uint32_t node_count,
+                 const DirectedEdge* edges, const uint32_t edge_count)
+      : nodes_(nodes), node_count_(node_count), edges_(edges),
+        edge_count_(edge_count) {
+  }
+
+  iterator begin() const {
+    return iterator(this, 0);
+  }
+  iterator end() const {
+    return iterator(this, node_count_);
+  }
+
+  /**
+   * Get the number of nodes.
+   * @return  Returns the number of nodes.
+   */
+  uint32_t size() const {
+    return node_count_;
+  }
+
+  /**
+   * Get a node and its outbound edges. The node index is not checked;
+   * throws if the node's edges are outside the tile.
+   * @param  id  Index of the node.
+   * @return  Returns the node and its edges.
+   */
+  NodeEdges at(const uint32_t id) const {
+    const NodeInfo* node = nodes_ + id;
+    const uint32_t first = node->edge_index();
+    const uint32_t count = node->edge_count();
+    if (VALHALLA_UNLIKELY(first + count > edge_count_))
+      edges_out_of_bounds(id, first, count);
+    return { id, node, midgard::iterable_t<const DirectedEdge>(edges_ + first, count) };
+  }
+
+ protected:
+  const NodeInfo* nodes_;
+  uint32_t node_count_;
+  const DirectedEdge* edges_;
+  uint32_t edge_count_;
+
+  /**
+   * Prefetches the outbound edges of a node, if it exists.
+   * @param  id  Index of the node.
+   */
+  void prefetch(const uint32_t id) const {
+#if defined(__GNUC__)
+    if (id < node_count_)
+      __builtin_prefetch(edges_ + nodes_[id].edge_index());
+#endif
+  }
+
+  /**
+   * Throws for a node whose edges are outside the tile. Kept out of line so
+   * building the message stays off the iteration path.
+   */
+  [[noreturn]] VALHALLA_COLD void edges_out_of_bounds(const uint32_t id,
+      const uint32_t first, const uint32_t count) const;
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_TILE_RANGES_H_
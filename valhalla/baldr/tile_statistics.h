@@ -0,0 +1,92 @@
+#ifndef VALHALLA_BALDR_TILE_STATISTICS_H_
+#define VALHALLA_BALDR_TILE_STATISTICS_H_
+
+#include <array>
+#include <cstdint>
+
+#include <valhalla/baldr/graphconstants.h>
+
+namespace valhalla {
+namespace baldr {
+
+class GraphTile;
+
+/**
+ * Summary statistics of the graph in one tile (or, summed, of many tiles):
+ * counts of edges by road class, use and access mode, total length and the
+ * sizes of the variable length sections. Computed in a single pass over
+ * the directed edges so monitoring and QA do not have to scan the tile.
+ */
+struct TileStatistics {
+  // Number of uses (the directed edge use field is 6 bits)
+  static constexpr uint32_t kUseCount = 64;
+
+  // Number of access modes (the directed edge access masks are 12 bits)
+  static constexpr uint32_t kAccessModeCount = 12;
+
+  uint64_t tile_count;          // Number of tiles summed (1 for one tile)
+  uint64_t tile_bytes;          // Size of the tiles (bytes)
+  uint64_t node_count;
+  uint64_t edge_count;          // Directed edges
+  uint64_t shortcut_count;      // Directed edges that are shortcuts
+  uint64_t transit_line_count;  // Directed edges that are transit lines
+  uint64_t length;              // Length of all directed edges (meters)
+  uint64_t edgeinfo_bytes;      // Size of the edge info section (bytes)
+  uint64_t textlist_bytes;      // Size of the text list (bytes)
+  uint64_t sign_count;
+  uint64_t restriction_count;   // Access restrictions
+  uint64_t departure_count;     // Transit departures
+
+  // Directed edges and their length (meters) by road class
+  std::array<uint64_t, static_cast<uint32_t>(RoadClass::kServiceOther) + 1> edges_by_class;
+  std::array<uint64_t, static_cast<uint32_t>(RoadClass::kServiceOther) + 1> length_by_class;
+
+  // Directed edges by use
+  std::array<uint64_t, kUseCount> edges_by_use;
+
+  // Directed edges allowing each access mode (bit of the access mask, see
+  // kAutoAccess and friends) forward and in reverse
+  std::array<uint64_t, kAccessModeCount> forward_access;
+  std::array<uint64_t, kAccessModeCount> reverse_access;
+
+  /**
+   * Constructor. All counts are 0.
+   */
+  TileStatistics();
+
+  /**
+   * Constructor. Computes the statistics of a tile.
+   * @param  tile  Graph tile.
+   */
+  explicit TileStatistics(const GraphTile& tile);
+
+  /**
+   * Adds the statistics of other tiles to these.
+   * @param  other  Statistics to add.
+   * @return  Returns these statistics.
+   */
+  TileStatistics& operator+=(const TileStatistics& other);
+
+  /**
+   * Get the number of directed edges of a road class.
+   * @param  rc  Road class.
+   * @return  Returns the number of edges.
+   */
+  uint64_t edges(const RoadClass rc) const {
+    return edges_by_class[static_cast<uint32_t>(rc)];
+  }
+
+  /**
+   * Get the number of directed edges with a use.
+   * @param  use  Use.
+   * @return  Returns the number of edges.
+   */
+  uint64_t edges(const Use use) const {
+    return edges_by_use[static_cast<uint32_t>(use)];
+  }
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_TILE_STATISTICS_H_
@@ -7,7 +7,9 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <vector>
 #include <valhalla/midgard/pointll.h>
+#include <valhalla/midgard/aabb2.h>
 #include <valhalla/midgard/tiles.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphconstants.h>
@@ -65,6 +67,16 @@ class TileHierarchy {
    */
   GraphId GetGraphId(const midgard::PointLL& pointll, const uint8_t level) const;
 
+  /**
+   * Returns the graphids of the tiles at a level that intersect a bounding
+   * box. If the level is not supported an empty list is returned
+   *
+   * @param bbox    the bounding box (lng,lat) to intersect
+   * @param level   the level of the requested tiles
+   */
+  std::vector<GraphId> GetGraphIds(const midgard::AABB2<midgard::PointLL>& bbox,
+                                   const uint8_t level) const;
+
   /**
    * Gets the hierarchy level given the road class.
    * @param  road_class  Road classification.
@@ -0,0 +1,80 @@
+#ifndef VALHALLA_BALDR_TRANSFER_INDEX_H_
+#define VALHALLA_BALDR_TRANSFER_INDEX_H_
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <valhalla/baldr/record_index.h>
+#include <valhalla/baldr/transittransfer.h>
+#include <valhalla/midgard/util.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Adjacency (CSR) index of transit transfers by from stop Id. The transfers
+ * are kept sorted by from stop Id then to stop Id, with a RecordIndex over
+ * the from stop Ids, so all transfers from a stop are a bit test plus a
+ * popcount away and the transfer between two stops is a binary search over
+ * the (few) transfers from the first.
+ */
+class TransferIndex {
+ public:
+  // Minimum transfer time returned when a transfer is not possible
+  static constexpr uint32_t kNotPossible = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * Constructor. The transfers are copied and sorted.
+   * @param  transfers  Pointer to the first transfer, in any order.
+   * @param  count      Number of transfers.
+   */
+  TransferIndex(const TransitTransfer* transfers, const uint32_t count);
+
+  /**
+   * Get all transfers from a stop.
+   * @param  stopid  From stop Id.
+   * @return  Returns the transfers sorted by to stop Id (empty if none).
+   */
+  midgard::iterable_t<const TransitTransfer> from(const uint32_t stopid) const;
+
+  /**
+   * Get the transfer between two stops.
+   * @param  from_stopid  From stop Id.
+   * @param  to_stopid    To stop Id.
+   * @return  Returns the transfer or nullptr if there is none.
+   */
+  const TransitTransfer* find(const uint32_t from_stopid,
+                              const uint32_t to_stopid) const;
+
+  /**
+   * Get the minimum time to transfer between two stops: the transfer's
+   * minimum time for kMinTime transfers, 0 for recommended and timed
+   * transfers and kNotPossible if the transfer is not possible.
+   * @param  from_stopid   From stop Id.
+   * @param  to_stopid     To stop Id.
+   * @param  default_time  Time to use if there is no transfer between the
+   *                       stops (e.g. a generic transfer penalty).
+   * @return  Returns the minimum transfer time (seconds).
+   */
+  uint32_t min_transfer_time(const uint32_t from_stopid, const uint32_t to_stopid,
+                             const uint32_t default_time) const;
+
+  /**
+   * Get the number of transfers.
+   * @return  Returns the number of transfers.
+   */
+  uint32_t size() const;
+
+ protected:
+  // Transfers sorted by from stop Id then to stop Id
+  std::vector<TransitTransfer> transfers_;
+
+  // Transfers of each from stop Id
+  RecordIndex index_;
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_TRANSFER_INDEX_H_
@@ -0,0 +1,81 @@
+#ifndef VALHALLA_BALDR_TRIP_INDEX_H_
+#define VALHALLA_BALDR_TRIP_INDEX_H_
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include <valhalla/baldr/transitdeparture.h>
+#include <valhalla/midgard/util.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Index from trip Ids and block Ids to the departures of a tile that run
+ * them, so following a vehicle along its trip or onto the next trip of its
+ * block is a direct lookup rather than a scan of a line's departures. The
+ * departures of each trip (and of each block) are kept in one contiguous
+ * run in departure time order, and the distinct Ids sorted for a binary
+ * search. Departures without a block (block Id 0) are not in the block
+ * index.
+ */
+class TripIndex {
+ public:
+  using positions_t = midgard::iterable_t<const uint32_t>;
+
+  /**
+   * Constructor.
+   * @param  departures  Departures of the tile.
+   * @param  count       Number of departures.
+   */
+  TripIndex(const TransitDeparture* departures, const uint32_t count);
+
+  /**
+   * Get the departures of a trip.
+   * @param  tripid  Trip Id.
+   * @return  Returns the departure indexes in time order (empty if the
+   *          trip has no departures in the tile).
+   */
+  positions_t trip(const uint32_t tripid) const;
+
+  /**
+   * Get the departures of a block.
+   * @param  blockid  Block Id.
+   * @return  Returns the departure indexes in time order (empty if the
+   *          block has no departures in the tile or is 0).
+   */
+  positions_t block(const uint32_t blockid) const;
+
+ protected:
+  /**
+   * Departures grouped by one Id.
+   */
+  struct Groups {
+    std::vector<uint32_t> ids;        // Distinct Ids in sorted order
+    std::vector<uint32_t> starts;     // First position of each Id, then the end
+    std::vector<uint32_t> positions;  // Departure indexes, grouped by Id
+
+    /**
+     * Constructor.
+     * @param  keyed  (Id, departure time, departure index) of each
+     *                departure to index, in any order.
+     */
+    explicit Groups(std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> keyed);
+
+    /**
+     * Get the departures with an Id.
+     * @param  id  Trip or block Id.
+     * @return  Returns the departure indexes in time order.
+     */
+    positions_t find(const uint32_t id) const;
+  };
+
+  Groups trips_;
+  Groups blocks_;
+};
+
+}
+}
+
+#endif  // VALHALLA_BALDR_TRIP_INDEX_H_